@@ -0,0 +1,53 @@
+#version 460 core
+
+layout (location = 0) in vec2 a_GridPosition;
+
+layout (std140, binding = 0) uniform Scene
+{
+    mat4 u_ViewProjection;
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_CameraPosition;
+};
+
+layout (std140, binding = 1) uniform Object
+{
+    mat4 u_Transform;
+};
+
+uniform sampler2DArray u_Heights;
+uniform int u_Level;
+uniform ivec2 u_LevelOrigin;
+uniform float u_LevelSpacing;
+uniform int u_GridSize;
+uniform int u_TextureSize;
+
+out vec2 FragTexCoord;
+out float Height;
+out vec3 FragPos;
+
+// Grid position p of a level is stored in texel p mod u_TextureSize
+float FetchHeight(ivec2 position)
+{
+    ivec2 texel = position - u_TextureSize * ivec2(floor(vec2(position) / float(u_TextureSize)));
+    return texelFetch(u_Heights, ivec3(texel, u_Level), 0).r;
+}
+
+void main() {
+    ivec2 local = ivec2(a_GridPosition);
+    ivec2 position = u_LevelOrigin + local;
+    float height = FetchHeight(position);
+
+    // Odd vertices on the border lie on an edge of the coarser level, they follow it to avoid cracks
+    if ((local.x == 0 || local.x == u_GridSize) && (position.y & 1) != 0)
+        height = 0.5 * (FetchHeight(position - ivec2(0, 1)) + FetchHeight(position + ivec2(0, 1)));
+    else if ((local.y == 0 || local.y == u_GridSize) && (position.x & 1) != 0)
+        height = 0.5 * (FetchHeight(position - ivec2(1, 0)) + FetchHeight(position + ivec2(1, 0)));
+
+    vec2 world = vec2(position) * u_LevelSpacing;
+
+    gl_Position = u_ViewProjection * u_Transform * vec4(world.x, height, world.y, 1.0);
+    FragTexCoord = world / 10.0;
+    Height = height;
+    FragPos = vec3(gl_Position);
+}
@@ -0,0 +1,131 @@
+#version 460 core
+
+// Tests the bounds of every chunk draw against the view frustum and against the hierarchical depth of the
+// previous frame, and appends the visible ones to the indirect command buffer with the draw count.
+
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct ChunkDraw
+{
+    vec4 boundsMin;
+    vec4 boundsMax;
+    DrawCommand command;
+};
+
+layout (std430, binding = 0) readonly buffer Chunks
+{
+    ChunkDraw chunks[];
+};
+
+layout (std430, binding = 1) writeonly buffer Commands
+{
+    DrawCommand commands[];
+};
+
+layout (std430, binding = 2) buffer Parameters
+{
+    uint drawCount;
+};
+
+uniform int u_ChunkCount;
+uniform vec4 u_FrustumPlanes[6];
+
+// Without GL_ARB_indirect_parameters every command is kept in place, the culled ones without instance
+uniform int u_Compact;
+
+uniform int u_Occlusion;
+uniform sampler2D u_HiZ;
+uniform mat4 u_HiZViewProjection;
+uniform ivec2 u_HiZSize;
+uniform int u_HiZLevelCount;
+
+// Same conservative test as Frustum::IntersectsAabb
+bool IsInFrustum(vec3 boundsMin, vec3 boundsMax)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        vec4 plane = u_FrustumPlanes[i];
+        vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(plane.xyz, vec3(0.0)));
+        if (dot(plane.xyz, corner) + plane.w < 0.0)
+            return false;
+    }
+
+    return true;
+}
+
+// Hidden when its nearest depth is behind the farthest depth of the pyramid texels covering its screen rectangle
+bool IsOccluded(vec3 boundsMin, vec3 boundsMax)
+{
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = vec3((i & 1) != 0 ? boundsMax.x : boundsMin.x, (i & 2) != 0 ? boundsMax.y : boundsMin.y, (i & 4) != 0 ? boundsMax.z : boundsMin.z);
+        vec4 clip = u_HiZViewProjection * vec4(corner, 1.0);
+
+        // Reaches behind the camera the depth was rendered from
+        if (clip.w <= 0.0)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    // Parts outside the previous view have no depth to be tested against
+    if (any(lessThan(uvMin, vec2(0.0))) || any(greaterThan(uvMax, vec2(1.0))))
+        return false;
+
+    ivec2 pixelMin = min(ivec2(uvMin * vec2(u_HiZSize)), u_HiZSize - 1);
+    ivec2 pixelMax = min(ivec2(uvMax * vec2(u_HiZSize)), u_HiZSize - 1);
+
+    // Coarsest level where the rectangle covers 2x2 texels at most
+    int level = 0;
+    while (level + 1 < u_HiZLevelCount && any(greaterThan((pixelMax >> level) - (pixelMin >> level), ivec2(1))))
+        ++level;
+
+    ivec2 levelSize = max(u_HiZSize >> level, ivec2(1));
+    ivec2 texelMin = min(pixelMin >> level, levelSize - 1);
+    ivec2 texelMax = min(pixelMax >> level, levelSize - 1);
+
+    float farthest = max(
+        max(texelFetch(u_HiZ, texelMin, level).r, texelFetch(u_HiZ, ivec2(texelMax.x, texelMin.y), level).r),
+        max(texelFetch(u_HiZ, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(u_HiZ, texelMax, level).r));
+
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(u_ChunkCount))
+        return;
+
+    ChunkDraw chunk = chunks[index];
+    bool visible = IsInFrustum(chunk.boundsMin.xyz, chunk.boundsMax.xyz)
+        && (u_Occlusion == 0 || !IsOccluded(chunk.boundsMin.xyz, chunk.boundsMax.xyz));
+
+    // The count is also read back for statistics when the commands are not compacted
+    uint slot = visible ? atomicAdd(drawCount, 1u) : 0u;
+    if (u_Compact != 0)
+    {
+        if (visible)
+            commands[slot] = chunk.command;
+        return;
+    }
+
+    DrawCommand command = chunk.command;
+    command.instanceCount = visible ? 1u : 0u;
+    commands[index] = command;
+}
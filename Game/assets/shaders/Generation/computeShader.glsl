@@ -0,0 +1,295 @@
+#version 460 core
+
+// GPU version of the HeightMap pipeline: noise, spline remap, ridge, terraces and subtractive blend.
+// Writes the chunk vertices (grid position + height, see ChunkVertex) straight into its vertex buffer
+// and reduces the height range of the chunk into its entry of the bounds buffer.
+
+// Every invocation generates two consecutive vertices, which fill three words of the vertex buffer
+layout (local_size_x = 64) in;
+
+struct NoiseLayer
+{
+    float frequency;
+    int octaves;
+    float persistence;
+    int splineOffset;
+    int splineCount;
+    int smoothSpline;
+    int terraceCount;
+};
+
+struct SplineSegment
+{
+    float breakpoint;
+    float valueStart;
+    float valueRange;
+    float heightStart;
+    float heightRange;
+    float tangentStart;
+    float tangentEnd;
+    float padding;
+};
+
+// 256 entries for the continentalness permutation followed by 256 for the erosion one
+layout (std430, binding = 0) readonly buffer Permutations
+{
+    int permutations[];
+};
+
+layout (std430, binding = 1) readonly buffer Splines
+{
+    SplineSegment segments[];
+};
+
+// ChunkVertex pairs, 6 bytes each: the grid position as two 16 bit values then the height as an unsigned
+// normalized 16 bit value over the range of the settings (u_VertexMinHeight, u_VertexHeightScale)
+layout (std430, binding = 2) writeonly buffer Vertices
+{
+    uint vertices[];
+};
+
+// Min and max height of every chunk of a Generate, as ordered bits (see OrderedBits)
+layout (std430, binding = 3) buffer Bounds
+{
+    uint bounds[];
+};
+
+uniform ivec2 u_ChunkStart;
+uniform ivec2 u_Samples;
+uniform int u_Lod;
+uniform int u_BoundsIndex;
+
+uniform NoiseLayer u_Continentalness;
+uniform NoiseLayer u_Erosion;
+
+uniform bool u_RidgeNoise;
+uniform bool u_Terraces;
+uniform bool u_Blend;
+uniform float u_ErosionFactor;
+uniform float u_VertexMinHeight;
+uniform float u_VertexHeightScale;
+
+const float DEFAULT_Z = 0.34567;
+
+
+shared uint s_minHeight;
+shared uint s_maxHeight;
+
+// Float bits whose unsigned order is the order of the floats, negative ones included
+uint OrderedBits(float value)
+{
+    uint bits = floatBitsToUint(value);
+    return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+// Same as ChunkVertex::PackHeight, in the low 16 bits
+uint PackHeight(float height)
+{
+    float normalized = u_VertexHeightScale > 0.0 ? (height - u_VertexMinHeight) / u_VertexHeightScale : 0.0;
+    return uint(round(clamp(normalized, 0.0, 1.0) * 65535.0));
+}
+
+int Permutation(int layer, int index)
+{
+    return permutations[layer * 256 + (index & 255)];
+}
+
+float Fade(float t)
+{
+    return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+
+float Lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+float Grad(int hash, float x, float y, float z)
+{
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14) ? x : z;
+    return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+// Same as siv::PerlinNoise::noise2D
+float Noise2D(int layer, float x, float y)
+{
+    float _x = floor(x);
+    float _y = floor(y);
+
+    int ix = int(_x) & 255;
+    int iy = int(_y) & 255;
+
+    float fx = x - _x;
+    float fy = y - _y;
+    float fz = DEFAULT_Z;
+
+    float u = Fade(fx);
+    float v = Fade(fy);
+    float w = Fade(fz);
+
+    int A = (Permutation(layer, ix) + iy) & 255;
+    int B = (Permutation(layer, ix + 1) + iy) & 255;
+
+    int AA = Permutation(layer, A);
+    int AB = Permutation(layer, A + 1);
+    int BA = Permutation(layer, B);
+    int BB = Permutation(layer, B + 1);
+
+    float p0 = Grad(Permutation(layer, AA), fx, fy, fz);
+    float p1 = Grad(Permutation(layer, BA), fx - 1.0, fy, fz);
+    float p2 = Grad(Permutation(layer, AB), fx, fy - 1.0, fz);
+    float p3 = Grad(Permutation(layer, BB), fx - 1.0, fy - 1.0, fz);
+    float p4 = Grad(Permutation(layer, AA + 1), fx, fy, fz - 1.0);
+    float p5 = Grad(Permutation(layer, BA + 1), fx - 1.0, fy, fz - 1.0);
+    float p6 = Grad(Permutation(layer, AB + 1), fx, fy - 1.0, fz - 1.0);
+    float p7 = Grad(Permutation(layer, BB + 1), fx - 1.0, fy - 1.0, fz - 1.0);
+
+    float q0 = Lerp(p0, p1, u);
+    float q1 = Lerp(p2, p3, u);
+    float q2 = Lerp(p4, p5, u);
+    float q3 = Lerp(p6, p7, u);
+
+    return Lerp(Lerp(q0, q1, v), Lerp(q2, q3, v), w);
+}
+
+float Octave2D(int layer, float x, float y, int octaves, float persistence)
+{
+    float result = 0.0;
+    float amplitude = 1.0;
+
+    for (int i = 0; i < octaves; ++i)
+    {
+        result += Noise2D(layer, x, y) * amplitude;
+        x *= 2.0;
+        y *= 2.0;
+        amplitude *= persistence;
+    }
+
+    return result;
+}
+
+// Same as CompiledSpline::Apply
+float ApplySpline(NoiseLayer layer, float value)
+{
+    if (layer.splineCount < 2)
+        return value;
+
+    int segment = 0;
+    for (int i = 0; i < layer.splineCount; ++i)
+        segment += value >= segments[layer.splineOffset + i].breakpoint ? 1 : 0;
+    segment = layer.splineOffset + min(segment, layer.splineCount - 1);
+
+    SplineSegment s = segments[segment];
+    float linear = (value - s.valueStart) * s.heightRange / s.valueRange + s.heightStart;
+    if (layer.smoothSpline == 0)
+        return linear;
+
+    float t = s.valueRange > 0.0 ? (value - s.valueStart) / s.valueRange : -1.0;
+    if (t < 0.0 || t > 1.0)
+        return linear;
+
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return (2.0 * t3 - 3.0 * t2 + 1.0) * s.heightStart
+        + (t3 - 2.0 * t2 + t) * s.valueRange * s.tangentStart
+        + (-2.0 * t3 + 3.0 * t2) * (s.heightStart + s.heightRange)
+        + (t3 - t2) * s.valueRange * s.tangentEnd;
+}
+
+float RidgeNoise(float h)
+{
+    return 2.0 * (0.5 - abs(0.5 - h));
+}
+
+float TerraceNoise(float h, int terraceCount)
+{
+    float terraceHeight = 1.0 / float(terraceCount);
+    return floor(h / terraceHeight) * terraceHeight;
+}
+
+float GenerateHeight(ivec2 sampleIndex)
+{
+    float x1 = float(sampleIndex.x) / float(u_Lod) + float(u_ChunkStart.x);
+    float z1 = float(sampleIndex.y) / float(u_Lod) + float(u_ChunkStart.y);
+
+    float f = u_Continentalness.frequency * 0.001;
+    float continentalness = Octave2D(0, x1 * f, z1 * f, u_Continentalness.octaves, u_Continentalness.persistence);
+    continentalness = ApplySpline(u_Continentalness, continentalness);
+
+    float g = u_Erosion.frequency * 0.001;
+    float erosion = Octave2D(1, x1 * g, z1 * g, u_Erosion.octaves, u_Erosion.persistence);
+    erosion = ApplySpline(u_Erosion, erosion);
+
+    if (u_RidgeNoise)
+    {
+        continentalness = RidgeNoise(continentalness);
+        erosion = RidgeNoise(erosion);
+    }
+
+    if (u_Terraces)
+    {
+        continentalness = TerraceNoise(continentalness, u_Continentalness.terraceCount);
+        erosion = TerraceNoise(erosion, u_Erosion.terraceCount);
+    }
+
+    float height = continentalness;
+    if (u_Blend)
+    {
+        float erosionValue = erosion * u_ErosionFactor;
+        height = max(0.0, min(continentalness - erosionValue, continentalness));
+    }
+
+    return height;
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+    {
+        s_minHeight = 0xFFFFFFFFu;
+        s_maxHeight = 0u;
+    }
+
+    barrier();
+
+    // No early return, every invocation reaches the barriers
+    int sampleCount = u_Samples.x * u_Samples.y;
+    int first = int(gl_GlobalInvocationID.x) * 2;
+    if (first < sampleCount)
+    {
+        ivec2 firstSample = ivec2(first % u_Samples.x, first / u_Samples.x);
+        float firstHeight = GenerateHeight(firstSample);
+        uint minHeight = OrderedBits(firstHeight);
+        uint maxHeight = minHeight;
+
+        // An odd last vertex leaves the second one empty, its words land in the padding of the buffer
+        ivec2 secondSample = ivec2((first + 1) % u_Samples.x, (first + 1) / u_Samples.x);
+        uint second = 0u;
+        if (first + 1 < sampleCount)
+        {
+            float secondHeight = GenerateHeight(secondSample);
+            second = PackHeight(secondHeight);
+            minHeight = min(minHeight, OrderedBits(secondHeight));
+            maxHeight = max(maxHeight, OrderedBits(secondHeight));
+        }
+
+        int index = first / 2 * 3;
+        vertices[index] = uint(firstSample.x) | (uint(firstSample.y) << 16);
+        vertices[index + 1] = PackHeight(firstHeight) | (uint(secondSample.x) << 16);
+        vertices[index + 2] = uint(secondSample.y) | (second << 16);
+
+        atomicMin(s_minHeight, minHeight);
+        atomicMax(s_maxHeight, maxHeight);
+    }
+
+    barrier();
+
+    // One global atomic per work group
+    if (gl_LocalInvocationIndex == 0)
+    {
+        atomicMin(bounds[u_BoundsIndex * 2], s_minHeight);
+        atomicMax(bounds[u_BoundsIndex * 2 + 1], s_maxHeight);
+    }
+}
@@ -0,0 +1,46 @@
+#version 460 core
+
+// One level of the hierarchical depth: level 0 copies the depth texture, the others keep the farthest
+// depth of the 2x2 texels below them, plus the last row or column when the level below has an odd size.
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform readonly image2D u_Source;
+layout (r32f, binding = 1) uniform writeonly image2D u_Destination;
+
+uniform sampler2D u_Depth;
+uniform int u_Level;
+uniform ivec2 u_SourceSize;
+uniform ivec2 u_LevelSize;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, u_LevelSize)))
+        return;
+
+    if (u_Level == 0)
+    {
+        imageStore(u_Destination, texel, vec4(texelFetch(u_Depth, texel, 0).r));
+        return;
+    }
+
+    // Texels past the last of the source are clamped, they read a texel already covered
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1, u_SourceSize - 1);
+
+    // The last texel of the level also covers the extra row or column of an odd source
+    if (texel.x == u_LevelSize.x - 1)
+        last.x = u_SourceSize.x - 1;
+    if (texel.y == u_LevelSize.y - 1)
+        last.y = u_SourceSize.y - 1;
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+            depth = max(depth, imageLoad(u_Source, ivec2(x, y)).r);
+    }
+
+    imageStore(u_Destination, texel, vec4(depth));
+}
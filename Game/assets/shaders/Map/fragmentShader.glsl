@@ -6,10 +6,13 @@ in vec3 FragPos;
 
 out vec4 FragColor;
 
-uniform sampler2D snowTexture;
-uniform sampler2D grassTexture;
-uniform sampler2D rockTexture;
-uniform sampler2D sandTexture;
+// Terrain materials bound by the Renderer on unit 0 (kMaterialUnit), in the layer order of TestLayer
+layout (binding = 0) uniform sampler2DArray u_Materials;
+
+const float grassLayer = 0.0;
+const float rockLayer = 1.0;
+const float sandLayer = 2.0;
+const float snowLayer = 3.0;
 
 uniform float sandThreshold;
 uniform float grassThreshold;
@@ -19,10 +22,10 @@ const float transitionWidth = 1.5;
 
 void main()
 {
-    vec4 snowColor = texture(snowTexture, FragTexCoord);
-    vec4 grassColor = texture(grassTexture, FragTexCoord);
-    vec4 rockColor = texture(rockTexture, FragTexCoord);
-    vec4 sandColor = texture(sandTexture, FragTexCoord);
+    vec4 snowColor = texture(u_Materials, vec3(FragTexCoord, snowLayer));
+    vec4 grassColor = texture(u_Materials, vec3(FragTexCoord, grassLayer));
+    vec4 rockColor = texture(u_Materials, vec3(FragTexCoord, rockLayer));
+    vec4 sandColor = texture(u_Materials, vec3(FragTexCoord, sandLayer));
 
     vec4 rockColorMix = rockColor * 2;
     rockColorMix.a = 1.0;
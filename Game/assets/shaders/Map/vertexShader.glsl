@@ -1,20 +1,33 @@
 #version 460 core
 
-layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec2 a_TexCoord;
+// Chunk vertices are grid samples (see ChunkVertex), u_Transform places the chunk grid and its height range
+// in the world
+layout (location = 0) in vec2 a_GridPosition;
+layout (location = 1) in float a_Height;
 
-uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Projection;
-uniform mat4 u_Transform;
+// Camera of the frame and transform of the draw, see Renderer::kSceneBinding and kObjectBinding
+layout (std140, binding = 0) uniform Scene
+{
+    mat4 u_ViewProjection;
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_CameraPosition;
+};
+
+layout (std140, binding = 1) uniform Object
+{
+    mat4 u_Transform;
+};
 
 out vec2 FragTexCoord;
 out float Height;
 out vec3 FragPos;
 
 void main() {
-    gl_Position = u_Projection * u_View * u_Transform * vec4(a_Position, 1.0);
-    FragTexCoord = a_TexCoord.xy;
-    Height = a_Position.y;
+    vec4 world = u_Transform * vec4(a_GridPosition.x, a_Height, a_GridPosition.y, 1.0);
+
+    gl_Position = u_ViewProjection * world;
+    FragTexCoord = world.xz / 10.0;
+    Height = world.y;
     FragPos = vec3(gl_Position);
-}
\ No newline at end of file
+}
@@ -0,0 +1,46 @@
+#version 460 core
+
+// Map vertex shader for the multi-draws of a ChunkArena, which place every chunk grid from a buffer
+layout (location = 0) in vec2 a_GridPosition;
+layout (location = 1) in float a_Height;
+
+// Of the chunk of each draw, indexed by its base instance: origin (xy) and sample spacing (z) of the grid,
+// then the vertex height range (x min, y scale), see ChunkArena::AddDraw
+struct ChunkPlacement
+{
+    vec4 grid;
+    vec4 heights;
+};
+
+layout (std430, binding = 3) readonly buffer ChunkPlacements
+{
+    ChunkPlacement placements[];
+};
+
+layout (std140, binding = 0) uniform Scene
+{
+    mat4 u_ViewProjection;
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_CameraPosition;
+};
+
+layout (std140, binding = 1) uniform Object
+{
+    mat4 u_Transform;
+};
+
+out vec2 FragTexCoord;
+out float Height;
+out vec3 FragPos;
+
+void main() {
+    ChunkPlacement placement = placements[gl_BaseInstance];
+    vec2 world = placement.grid.xy + a_GridPosition * placement.grid.z;
+    float height = placement.heights.x + a_Height * placement.heights.y;
+
+    gl_Position = u_ViewProjection * u_Transform * vec4(world.x, height, world.y, 1.0);
+    FragTexCoord = world / 10.0;
+    Height = height;
+    FragPos = vec3(gl_Position);
+}
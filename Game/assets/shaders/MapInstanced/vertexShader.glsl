@@ -0,0 +1,37 @@
+#version 460 core
+
+// Map vertex shader for the instances of a ChunkInstancer: one grid shared by every chunk, its heights
+// fetched from the layer of the chunk
+layout (location = 0) in vec2 a_GridPosition;
+layout (location = 1) in ivec2 a_ChunkOffset;
+layout (location = 2) in int a_Layer;
+
+layout (std140, binding = 0) uniform Scene
+{
+    mat4 u_ViewProjection;
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_CameraPosition;
+};
+
+layout (std140, binding = 1) uniform Object
+{
+    mat4 u_Transform;
+};
+
+uniform sampler2DArray u_Heights;
+uniform float u_SampleSpacing;
+
+out vec2 FragTexCoord;
+out float Height;
+out vec3 FragPos;
+
+void main() {
+    float height = texelFetch(u_Heights, ivec3(ivec2(a_GridPosition), a_Layer), 0).r;
+    vec2 world = vec2(a_ChunkOffset) + a_GridPosition * u_SampleSpacing;
+
+    gl_Position = u_ViewProjection * u_Transform * vec4(world.x, height, world.y, 1.0);
+    FragTexCoord = world / 10.0;
+    Height = height;
+    FragPos = vec3(gl_Position);
+}
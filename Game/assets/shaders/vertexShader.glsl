@@ -2,11 +2,20 @@
 
 layout (location = 0) in vec3 a_Position;
 
-uniform mat4 u_View;
-uniform mat4 u_Projection;
-uniform mat4 u_Transform;  
+layout (std140, binding = 0) uniform Scene
+{
+    mat4 u_ViewProjection;
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_CameraPosition;
+};
+
+layout (std140, binding = 1) uniform Object
+{
+    mat4 u_Transform;
+};
 
 void main() {
-    gl_Position = u_Projection * u_View * u_Transform * vec4(a_Position, 1.0);
+    gl_Position = u_ViewProjection * u_Transform * vec4(a_Position, 1.0);
 }
 
@@ -1,23 +1,38 @@
 #include <imgui.h>
+#include <chrono>
 #include <iostream>
 #include "src/Application/Application.h"
 #include "src/Camera/Camera.h"
+#include "src/OpenGl/Buffer/BufferAllocator.h"
 #include "src/OpenGl/Buffer/VertexArray.h"
 #include "src/OpenGl/Renderer/Renderer.h"
 #include "src/OpenGl/Shader/Shader.h"
 #include "src/OpenGl/Texture/Texture.h"
+#include "src/OpenGl/Texture/Texture2DArray.h"
+#include "src/OpenGl/Texture/TextureCache.h"
+#include "src/OpenGl/Texture/TextureStreamer.h"
 
 #include "src/Camera/CameraController.h"
+#include "src/Camera/FrustumCuller.h"
 #include "src/OpenGl/Renderer/RendererAPI.h"
 
 #include "src/PerlinNoise/PerlinGeneration.h"
 #include <glm/gtc/noise.hpp>
 #include "src/Terrain/HeightMap/HeightMap.h"
-#include <queue>
-#include <thread>
 #include "src/Terrain/Chunk.h"
 #include <glm/gtc/type_ptr.hpp>
 #include "src/Terrain/Water/Water.h"
+#include "src/JobSystem/JobSystem.h"
+#include "src/Terrain/GpuChunkGenerator.h"
+#include "src/Terrain/ChunkRegenerator.h"
+#include "src/Terrain/ChunkStreamer.h"
+#include "src/Terrain/ChunkArena.h"
+#include "src/Terrain/ChunkInstancer.h"
+#include "src/Terrain/IndexBufferCache.h"
+#include "src/Terrain/GeoMipmap.h"
+#include "src/Terrain/GpuChunkCuller.h"
+#include "src/Terrain/Clipmap.h"
+#include "src/Terrain/RtinMeshCache.h"
 class TestLayer : public Layer
 {
 public:
@@ -26,25 +41,44 @@ public:
 		m_cameraController.GetCamera().SetPosition({ -37.5531f, 71.7751f, 6.45213f });
 		m_cameraController.GetCamera().SetYaw(33.f);
 
-        m_textures.push_back(Texture2D::Create("grassTexture","./assets/textures/Grass.jpg"));
-        m_textures.push_back(Texture2D::Create("rockTexture","./assets/textures/Rock.jpg"));
-        m_textures.push_back(Texture2D::Create("sandTexture","./assets/textures/sand.bmp"));
-        m_textures.push_back(Texture2D::Create("snowTexture","./assets/textures/Neige.png"));
+		// Layer order of the Map fragment shader. Drawn with the fallback colors until the streamer loads them,
+		// the layers covering most of the terrain first
+		const std::vector<TextureLayerDesc> materials = {
+			{ "grass", "./assets/textures/Grass.jpg", { 86, 125, 70, 255 }, 1 },
+			{ "rock", "./assets/textures/Rock.jpg", { 110, 105, 100, 255 }, 1 },
+			{ "sand", "./assets/textures/sand.bmp", { 194, 178, 128, 255 } },
+			{ "snow", "./assets/textures/Neige.png", { 240, 240, 245, 255 } },
+		};
+		m_materials = Texture2DArray::Create(materials, kMaterialSize, kMaterialSize, Texture2DArray::SelectCompression(materials));
+		Renderer::SetMaterials(m_materials);
 
 
-		GenerateChunks();
-		GenerateWater();
-
         //m_ShaderLibrary.Load("MapShader", "./assets/shaders/vertexShader.glsl", "./assets/shaders/fragmentShader.glsl");
         m_ShaderLibrary.Load("MapShader", "./assets/shaders/Map/vertexShader.glsl", "./assets/shaders/Map/fragmentShader.glsl");
+		m_ShaderLibrary.Load("MapIndirectShader", "./assets/shaders/MapIndirect/vertexShader.glsl", "./assets/shaders/Map/fragmentShader.glsl");
+		m_ShaderLibrary.Load("MapInstancedShader", "./assets/shaders/MapInstanced/vertexShader.glsl", "./assets/shaders/Map/fragmentShader.glsl");
+		m_ShaderLibrary.Load("ClipmapShader", "./assets/shaders/Clipmap/vertexShader.glsl", "./assets/shaders/Map/fragmentShader.glsl");
 		m_ShaderLibrary.Load("WaterShader", "./assets/shaders/Water/vertexShader.glsl", "./assets/shaders/Water/fragmentShader.glsl");
+		m_ShaderLibrary.LoadCompute("GenerationShader", "./assets/shaders/Generation/computeShader.glsl");
+		m_ShaderLibrary.LoadCompute("CullingShader", "./assets/shaders/Culling/computeShader.glsl");
+		m_ShaderLibrary.LoadCompute("HiZShader", "./assets/shaders/HiZ/computeShader.glsl");
+
+		m_gpuChunkGenerator = GpuChunkGenerator::Create(m_ShaderLibrary.Get("GenerationShader"));
+		m_gpuChunkCuller = GpuChunkCuller::Create(m_ShaderLibrary.Get("CullingShader"));
+		m_hiZBuffer = HiZBuffer::Create(m_ShaderLibrary.Get("HiZShader"));
 
-        auto shader = m_ShaderLibrary.Get("MapShader");
+		m_stagingRing = StagingRing::Create(kStagingRingSize);
+		m_chunkRegenerator.SetStagingRing(m_stagingRing);
+		m_chunkStreamer.SetStagingRing(m_stagingRing);
+		m_textureStreamer.SetStagingRing(m_stagingRing);
+		m_textureStreamer.Request(m_materials);
+
+		GenerateChunks();
+		GenerateWater();
 
-        shader->Bind();
-        shader->SetFloat("grassThreshold", m_grassThreshold);
-        shader->SetFloat("rockThreshold", m_rockThreshold);
-        shader->SetFloat("sandThreshold", m_sandThreshold);
+        SetTerrainShaderFloat("grassThreshold", m_grassThreshold);
+        SetTerrainShaderFloat("rockThreshold", m_rockThreshold);
+        SetTerrainShaderFloat("sandThreshold", m_sandThreshold);
     }
 
     ~TestLayer() override = default;
@@ -55,24 +89,61 @@ public:
 	void OnUpdate(float dt) override
 	{
 		m_cameraController.OnUpdate(dt);
+		m_textureStreamer.Update();
+
+		if (m_clipmap)
+			m_clipmap->Update(m_cameraController.GetCamera().GetPosition());
+		else if (m_streaming)
+			m_chunkStreamer.Update(m_cameraController.GetCamera(), dt, [this](Chunk& chunk, bool isNew, const StagingRing::Allocation& staging) { GenerateChunk(chunk, isNew, staging); });
+		else
+			PollChunkRegeneration();
+
+		// Chunks generated on the GPU are bounded by the settings until their own height range is read back
+		if (m_gpuGeneration)
+			m_gpuChunkGenerator->ResolveBounds(m_chunks);
 
 		RendererAPI::Get()->SetClearColor({ 0.2f, 0.3f, 0.3f, 1.0f });
 		RendererAPI::Get()->Clear();
 
 		Renderer::BeginScene(m_cameraController.GetCamera());
 
+		UpdateChunkLevels();
+
 		const auto mapShader = m_ShaderLibrary.Get("MapShader");
 		const auto waterShader = m_ShaderLibrary.Get("WaterShader");
 		glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(0.f), glm::vec3(0.5f, 1.0f, 0.0f));
 
-		for (auto& chunk: m_chunks)
-        {
-            Renderer::Submit(mapShader, chunk.GetVertexArray(), m_textures, model);
-        }
+		glm::mat4 waterModel = model;
+		if (m_clipmap)
+		{
+			m_clipmap->Draw(m_ShaderLibrary.Get("ClipmapShader"), {}, model);
+			m_triangleCount = m_clipmap->GetTriangleCount();
 
-		Renderer::Submit(waterShader, m_water.GetVertexArray(), m_textures, model);
+			const glm::vec2 origin = m_clipmap->GetOrigin();
+			waterModel = glm::translate(model, glm::vec3(origin.x, 0.f, origin.y));
+		}
+		else if (m_streaming)
+		{
+			SubmitChunks(mapShader, model);
+
+			// The water covers the streamed area and follows the camera
+			const ChunkCoord center = m_chunkStreamer.GetCenter();
+			const int extent = m_chunkStreamer.GetRadius() + m_chunkStreamer.GetEvictionMargin();
+			waterModel = glm::translate(model, glm::vec3((center.x - extent) * (m_chunkSize - 1), 0.f, (center.z - extent) * (m_chunkSize - 1)));
+		}
+		else
+		{
+			SubmitChunks(mapShader, model);
+		}
+
+		DrawState waterState;
+		waterState.pass = RenderPass::Transparent;
+		Renderer::Submit(waterShader, m_water.GetVertexArray(), {}, waterModel, waterState);
 
 		Renderer::EndScene();
+
+		m_stagingRing->EndFrame();
+		BufferAllocator::Get().Defragment(kDefragmentBytesPerFrame);
 	}
 
 	void OnImGuiRender() override
@@ -120,12 +191,106 @@ public:
                     if (ImGui::Button("Wireframe"))
                         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+					if (m_gpuGeneration && !m_chunks.empty() && m_chunks.front().GetVertexArray() && ImGui::Button("Validate GPU generation"))
+						m_gpuValidationError = m_gpuChunkGenerator->Validate(m_chunks.front(), m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap);
+
+					ImGui::Checkbox("Frustum culling", &m_frustumCulling);
+					ImGui::Text("Chunks drawn: %zu / %zu, culled: %zu (%.3f ms)", m_visibleChunkCount, m_visibleChunkCount + m_culledChunkCount, m_culledChunkCount, m_cullingTime);
+					ImGui::Text("Staging ring: %.1f / %.1f MB, overflows: %zu", m_stagingRing->GetUsedSize() / 1048576.f, m_stagingRing->GetSize() / 1048576.f, m_stagingRing->GetOverflowCount());
+
+					const auto bufferStats = BufferAllocator::Get().GetStats();
+					ImGui::Text("Buffers: %.1f / %.1f MB in %zu blocks, %zu allocations", bufferStats.usedBytes / 1048576.f, bufferStats.reservedBytes / 1048576.f, bufferStats.blockCount, bufferStats.allocationCount);
+					ImGui::Text("Free ranges: %zu, largest %.1f MB, moved %.1f MB", bufferStats.freeRangeCount, bufferStats.largestFreeRange / 1048576.f, bufferStats.movedBytes / 1048576.f);
+
+					const auto& renderStats = Renderer::GetStats();
+					ImGui::Text("Render commands: %zu, binds: %zu, skipped: %zu, arena: %zu KB", renderStats.commandCount, renderStats.binds, renderStats.skippedBinds, renderStats.arenaSize / 1024);
+					ImGui::Text("Materials: %u layers of %ux%u, %u mips, %.1f MB, %u resident, %u missing", m_materials->GetLayerCount(), m_materials->GetWidth(), m_materials->GetHeight(), m_materials->GetLevelCount(), m_materials->GetMemorySize() / 1048576.f,
+						m_materials->GetLayerCount(Texture2DArray::LayerState::Resident), m_materials->GetLayerCount(Texture2DArray::LayerState::Missing));
+					const TextureStreamer::Stats streamStats = m_textureStreamer.GetStats();
+					ImGui::Text("Texture streaming: %zu queued, %zu loading (%.1f MB), %zu resident, %zu failed", streamStats.queuedCount, streamStats.loadingCount, streamStats.pendingSize / 1048576.f, streamStats.residentCount, streamStats.failedCount);
+					const TextureCache::Stats cacheStats = TextureCache::Get().GetStats();
+					ImGui::Text("Texture cache: %zu hits (%.1f ms), %zu misses (%.1f ms)", cacheStats.hitCount, cacheStats.loadMilliseconds, cacheStats.missCount, cacheStats.encodeMilliseconds);
+
+					if (m_gpuValidationError >= 0.f)
+						ImGui::Text("GPU max difference: %f (%s)", m_gpuValidationError, m_gpuValidationError < 0.01f ? "PASS" : "FAIL");
+
 				}
 
 				if (ImGui::BeginTabItem("MAP OPTIONS")) {
 
 					mapHasBeenUpdated |= ImGui::Checkbox("Generate map", &m_generateMap);
 					mapHasBeenUpdated |= ImGui::Checkbox("Blend Noise map", &m_blendNoiseMap);
+					mapHasBeenUpdated |= ImGui::Checkbox("GPU generation", &m_gpuGeneration);
+
+					if (m_chunkRegenerator.IsBusy())
+						ImGui::Text("Regenerating...");
+
+					ImGui::Checkbox("Geomipmapping", &m_geomipmapping);
+					if (ImGui::Checkbox("Adaptive mesh (RTIN)", &m_adaptiveMeshing))
+						SetAdaptiveMeshing(m_adaptiveMeshing);
+					ImGui::SliderFloat("LOD Pixel Error", &m_lodPixelError, 0.25f, 16.f);
+					ImGui::Text("Triangles: %zu", m_triangleCount);
+					if (m_adaptiveMeshing)
+						ImGui::Text("Adaptive mesh vertices: %zu", m_rtinMeshCache.GetVertexCount());
+
+					if (!m_clipmapRendering)
+					{
+						if (!m_instancedDrawing && ImGui::Checkbox("Multi-draw indirect", &m_indirectDrawing))
+							SetIndirectDrawing(m_indirectDrawing);
+
+						if (!m_indirectDrawing && ImGui::Checkbox("Instanced grid", &m_instancedDrawing))
+							SetInstancedDrawing(m_instancedDrawing);
+
+						if (m_instancedDrawing)
+						{
+							ImGui::Text("Instances: %zu in %zu draws, layers: %zu / %zu", m_chunkInstancer.GetInstanceCount(), m_chunkInstancer.GetCommandCount(), m_chunkInstancer.GetLayerCount(), m_chunkInstancer.GetLayerCapacity());
+							ImGui::Text("Mesh memory: %.1f MB", m_chunkInstancer.GetMemorySize() / 1048576.f);
+							if (m_gpuGeneration)
+								ImGui::Text("Chunks generated on the GPU have no heights to instance, they are drawn one by one");
+						}
+
+						if (m_indirectDrawing)
+						{
+							ImGui::Text("Indirect draws: %zu, arena vertices: %zu / %zu", m_chunkArena.GetDrawCount(), m_chunkArena.GetUsedVertexCount(), m_chunkArena.GetVertexCapacity());
+
+							ImGui::Checkbox("GPU culling", &m_gpuCulling);
+							if (m_gpuCulling)
+							{
+								// The pyramid left from the last time would test the chunks against an old view
+								if (ImGui::Checkbox("Hi-Z occlusion culling", &m_occlusionCulling))
+									m_hiZBuffer->Invalidate();
+
+								if (!GpuChunkCuller::IsCompactionSupported())
+									ImGui::Text("GL_ARB_indirect_parameters missing, culled draws are kept empty");
+							}
+						}
+					}
+
+					if (ImGui::Checkbox("Clipmap renderer", &m_clipmapRendering))
+						SetClipmapRendering(m_clipmapRendering);
+
+					if (m_clipmapRendering)
+					{
+						if (ImGui::SliderInt("Clipmap Levels", &m_clipmapLevels, 1, 12))
+							SetClipmapRendering(true);
+
+						ImGui::Text("Draw calls: %d, samples updated: %zu", m_clipmap->GetLevelCount(), m_clipmap->GetUpdatedSampleCount());
+					}
+					else if (ImGui::Checkbox("Stream chunks around camera", &m_streaming))
+						SetStreaming(m_streaming);
+
+					if (m_streaming && !m_clipmapRendering)
+					{
+						bool radiusChanged = ImGui::SliderInt("Stream Radius", &m_streamRadius, 1, 64);
+						radiusChanged |= ImGui::SliderInt("Eviction Margin", &m_streamEvictionMargin, 0, 8);
+						if (radiusChanged)
+						{
+							m_chunkStreamer.SetRadius(m_streamRadius, m_streamEvictionMargin);
+							waterHeightUpdated = true;
+						}
+
+						ImGui::Text("Loaded chunks: %zu, generating: %zu", m_chunkStreamer.GetLoadedCount(), m_chunkStreamer.GetPendingCount());
+					}
 
 					sizeHasChanged |= ImGui::SliderInt("Chunk Size", &m_chunkSize, 10, 2000);
 					sizeHasChanged |= ImGui::SliderInt("Chunk X", &m_nbChunksX, 1, 200);
@@ -138,26 +303,17 @@ public:
 
                     if(ImGui::SliderFloat("Grass Threshold", &m_grassThreshold, 0.0f, 500.0f))
                     {
-                        auto shader = m_ShaderLibrary.Get("MapShader");
-                        shader->Bind();
-                        shader->SetFloat("grassThreshold", m_grassThreshold);
-                        shader->Unbind();
+                        SetTerrainShaderFloat("grassThreshold", m_grassThreshold);
                     };
 
                     if(ImGui::SliderFloat("Rock Threshold", &m_rockThreshold, 0.0f, 500.0f))
                     {
-                        auto shader = m_ShaderLibrary.Get("MapShader");
-                        shader->Bind();
-                        shader->SetFloat("rockThreshold", m_rockThreshold);
-                        shader->Unbind();
+                        SetTerrainShaderFloat("rockThreshold", m_rockThreshold);
                     };
 
                     if(ImGui::SliderFloat("Sand Threshold", &m_sandThreshold, 0.0f, 500.0f))
                     {
-                        auto shader = m_ShaderLibrary.Get("MapShader");
-                        shader->Bind();
-                        shader->SetFloat("sandThreshold", m_sandThreshold);
-                        shader->Unbind();
+                        SetTerrainShaderFloat("sandThreshold", m_sandThreshold);
                     };
 
 
@@ -169,6 +325,7 @@ public:
 						if (ImGui::BeginTabItem("General options")) {
 
 							mapHasBeenUpdated |= ImGui::Checkbox("Add Ridge Noise", &m_continalnessNoiseSettings.ridgeNoise);
+							mapHasBeenUpdated |= ImGui::Checkbox("Smooth Spline", &m_continalnessNoiseSettings.smoothSpline);
 
 							ImGui::EndTabItem();
 						}
@@ -180,6 +337,10 @@ public:
 							mapHasBeenUpdated |= ImGui::SliderFloat("Persistence", &m_continalnessNoiseSettings.persistence, 0.1f, 1.0f);
 							mapHasBeenUpdated |= ImGui::SliderInt("Seed", &m_continalnessNoiseSettings.seed, 0, 100000);
 
+							mapHasBeenUpdated |= ImGui::Checkbox("Coarse Grid", &m_continalnessNoiseSettings.coarseGrid);
+							mapHasBeenUpdated |= ImGui::InputFloat("Coarse Grid Max Error", &m_continalnessNoiseSettings.coarseGridMaxError, 0.0001f, 0.001f, "%.5f");
+							ImGui::Text("Coarse grid step: %d", m_continalnessNoiseSettings.GetCoarseGridStep(m_lod));
+
 							ImGui::EndTabItem();
 						}
 
@@ -241,6 +402,7 @@ public:
 						if (ImGui::BeginTabItem("General options")) {
 
 							mapHasBeenUpdated |= ImGui::Checkbox("Add Ridge Noise", &m_erosionNoiseSettings.ridgeNoise);
+							mapHasBeenUpdated |= ImGui::Checkbox("Smooth Spline", &m_erosionNoiseSettings.smoothSpline);
 
 							ImGui::EndTabItem();
 						}
@@ -253,6 +415,10 @@ public:
 							mapHasBeenUpdated |= ImGui::SliderInt("Seed", &m_erosionNoiseSettings.seed, 0, 100000);
 							mapHasBeenUpdated |= ImGui::SliderFloat("Erosion Factor", &m_erosionNoiseSettings.factor, 0.f, 1.f);
 
+							mapHasBeenUpdated |= ImGui::Checkbox("Coarse Grid", &m_erosionNoiseSettings.coarseGrid);
+							mapHasBeenUpdated |= ImGui::InputFloat("Coarse Grid Max Error", &m_erosionNoiseSettings.coarseGridMaxError, 0.0001f, 0.001f, "%.5f");
+							ImGui::Text("Coarse grid step: %d", m_erosionNoiseSettings.GetCoarseGridStep(m_lod));
+
 							ImGui::EndTabItem();
 						}
 
@@ -322,10 +488,20 @@ public:
 
 		 if (m_generateMap && mapHasBeenUpdated)
          {
-			 GenerateChunks();
-			 GenerateWater();
+			 // The GPU path is a few dispatches, the CPU one runs in the background while the sliders move
+			 if (m_clipmap)
+				 m_clipmap->SetSettings(m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap);
+			 else if (m_streaming)
+			 {
+				 m_chunkStreamer.SetParameters(GetGenerationParameters());
+				 m_indexBufferCache.Trim();
+			 }
+			 else if (m_gpuGeneration)
+				 GenerateChunks(sizeHasChanged);
+			 else
+				 m_chunkRegenerator.Request(GetGenerationParameters());
          }
-		 if (waterHeightUpdated)
+		 if (sizeHasChanged || waterHeightUpdated)
 		 {
 			 GenerateWater();
 		 }
@@ -338,90 +514,508 @@ public:
 	}
 
 
-	void GenerateChunk(Chunk& chunk, bool sizeHasChanged)
+	void GenerateChunk(Chunk& chunk, bool sizeHasChanged, const StagingRing::Allocation& staging = StagingRing::Allocation())
 	{
-		RegenerationVerticesIndices(chunk, sizeHasChanged);
+		RegenerationVerticesIndices(chunk, sizeHasChanged, staging);
 	}
 
-    void RegenerationVerticesIndices(Chunk& chunk, bool sizeHasChanged)
+	// Vertices staged by a worker are only copied on the GPU, the others are uploaded from the chunk
+    void RegenerationVerticesIndices(Chunk& chunk, bool sizeHasChanged, const StagingRing::Allocation& staging)
     {
+		// Instanced chunks have no vertices, their heights are uploaded by ChunkInstancer::Update. Chunks
+		// generated on the GPU have no heights and keep their vertex array
+		if (m_instancedDrawing && !chunk.GetHeightMap().empty())
+		{
+			chunk.SetVertexArray(nullptr);
+			return;
+		}
+
+		// The arena uploads the vertices of the drawn chunks itself, see ChunkArena::Update
+		if (m_indirectDrawing)
+		{
+			if (staging)
+				m_chunkArena.Upload(chunk, staging, *m_stagingRing);
+			return;
+		}
+
         if (!sizeHasChanged) {
 
             if(chunk.GetVertexArray() == nullptr)
                 throw std::runtime_error("Chunk has no vertex array index");
 
             auto& vertexBuffer = chunk.GetVertexArray()->GetVertexBuffers()[0];
-            vertexBuffer->SetData(chunk.GetVertices().data(), sizeof(float) * chunk.GetVertices().size());
-
-            auto& indexBuffer = chunk.GetVertexArray()->GetIndexBuffer();
-            indexBuffer->SetData(chunk.GetIndices().data(), chunk.GetIndices().size());
+            if (staging)
+                m_stagingRing->Copy(staging, vertexBuffer->GetRendererID(), vertexBuffer->GetOffset());
+            else
+                vertexBuffer->SetData(chunk.GetVertices().data(), sizeof(ChunkVertex) * chunk.GetVertices().size());
 
+            // Indices only depend on the chunk size, they are shared through m_indexBufferCache
         }
         else
         {
             auto vertexArray = VertexArray::Create();
 			chunk.SetVertexArray(vertexArray);
 
-            const auto vertexBuffer = VertexBuffer::Create(chunk.GetVertices().data(), sizeof(float) * chunk.GetVertices().size());
-            const BufferLayout layout = {
-                    { ShaderDataType::Float3, "a_Position" },
-                    { ShaderDataType::Float2, "a_TexCoord" },
-            };
-            vertexBuffer->SetLayout(layout);
+            // Chunks generated on the GPU have no CPU vertices, the buffer is only allocated
+            const auto vertexBuffer = chunk.GetVertices().empty() || staging
+                    ? VertexBuffer::Create(static_cast<uint32_t>(sizeof(ChunkVertex) * chunk.GetVertexCount()))
+                    : VertexBuffer::Create(chunk.GetVertices().data(), sizeof(ChunkVertex) * chunk.GetVertices().size());
+            if (staging)
+                m_stagingRing->Copy(staging, vertexBuffer->GetRendererID(), vertexBuffer->GetOffset());
+            vertexBuffer->SetLayout(Chunk::GetVertexLayout());
             vertexArray->AddVertexBuffer(vertexBuffer);
 
-            const auto indexBuffer = IndexBuffer::Create(chunk.GetIndices().data(), chunk.GetIndices().size());
-            vertexArray->SetIndexBuffer(indexBuffer);
+            vertexArray->SetIndexBuffer(m_indexBufferCache.GetChunkIndexBuffer(chunk.width, chunk.height, chunk.lod));
         }
     }
 
 
-	void GenerateChunks()
+	// Chunks are only rebuilt when their size or count changes, otherwise each chunk reruns
+	// the generation stages invalidated by the settings and its vertex buffer is updated in place
+	void GenerateChunks(bool sizeHasChanged = true)
 	{
+		m_chunkRegenerator.Cancel();
+
+		m_continalnessNoiseSettings.CompileSpline();
+		m_erosionNoiseSettings.CompileSpline();
+
+		const size_t chunkCount = static_cast<size_t>(m_nbChunksX) * m_nbChunksZ;
+		if (!m_gpuGeneration && !sizeHasChanged && m_chunks.size() == chunkCount)
+		{
+			UpdateChunks();
+			return;
+		}
+
+		// Every chunk writes its own slot, so the workers never contend on m_chunks
 		m_chunks.clear();
-		std::vector<std::thread> threads;
+		m_chunks.resize(chunkCount);
+		m_indexBufferCache.Trim();
 
-		for (int x = 0; x < m_nbChunksX; ++x)
+		if (m_gpuGeneration)
 		{
-			for (int z = 0; z < m_nbChunksZ; ++z)
+			GenerateChunksOnGpu();
+			return;
+		}
+
+		JobCounter counter;
+		JobSystem::Get().Dispatch(static_cast<uint32_t>(m_chunks.size()), 1, [this](uint32_t index)
+		{
+			const int x = static_cast<int>(index) / m_nbChunksZ;
+			const int z = static_cast<int>(index) % m_nbChunksZ;
+			m_chunks[index] = Chunk{ x, z, m_chunkSize, m_chunkSize, m_lod, m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap, !m_instancedDrawing, UsesAdaptiveMeshes() };
+		}, counter);
+		JobSystem::Get().Wait(counter);
+
+		for (auto& chunk : m_chunks) {
+			GenerateChunk(chunk, true);
+		}
+	}
+
+	void UpdateChunks()
+	{
+		std::vector<uint8_t> needsUpload(m_chunks.size());
+
+		JobCounter counter;
+		JobSystem::Get().Dispatch(static_cast<uint32_t>(m_chunks.size()), 1, [this, &needsUpload](uint32_t index)
+		{
+			needsUpload[index] = m_chunks[index].Update(m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap, !m_instancedDrawing, UsesAdaptiveMeshes());
+		}, counter);
+		JobSystem::Get().Wait(counter);
+
+		for (size_t i = 0; i < m_chunks.size(); ++i)
+		{
+			if (needsUpload[i])
+				GenerateChunk(m_chunks[i], false);
+		}
+	}
+
+	// Chunks drawn by the chunk renderers, the loaded ones while streaming
+	std::vector<Chunk*> GetDrawnChunks()
+	{
+		std::vector<Chunk*> chunks;
+		if (m_streaming)
+			m_chunkStreamer.ForEachLoaded([&](Chunk& chunk) { chunks.push_back(&chunk); });
+		else
+			for (auto& chunk : m_chunks)
+				chunks.push_back(&chunk);
+		return chunks;
+	}
+
+	// Submits the chunks whose bounds intersect the view frustum
+	void SubmitChunks(const std::shared_ptr<Shader>& shader, const glm::mat4& model)
+	{
+		const std::vector<Chunk*> chunks = GetDrawnChunks();
+		if (m_indirectDrawing && m_gpuCulling)
+		{
+			SubmitChunksCulledOnGpu(chunks, shader, model);
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		m_frustumCuller.Clear();
+		for (const Chunk* chunk : chunks)
+			m_frustumCuller.Add(chunk->GetBoundsMin(), chunk->GetBoundsMax());
+
+		std::vector<uint8_t> visible(chunks.size(), 1);
+		if (m_frustumCulling)
+			m_frustumCuller.Cull(Frustum::FromViewProjection(m_cameraController.GetCamera().GetViewProjection()), visible);
+		m_cullingTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		m_visibleChunkCount = 0;
+		m_chunkArena.BeginFrame();
+		m_chunkInstancer.BeginFrame();
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			if (!visible[i])
+				continue;
+
+			// Adaptive meshes have their own buffers and are still drawn one by one, as are the chunks generated on
+			// the GPU, which have no heights to instance
+			if (m_instancedDrawing && !chunks[i]->GetHeightMap().empty())
 			{
-				threads.emplace_back([this, x, z] {
-					Chunk newChunk{ x, z, m_chunkSize, m_chunkSize, m_lod, m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap };
-					std::unique_lock<std::mutex> lock(mtx);
-					m_chunks.emplace_back(std::move(newChunk));
-					lock.unlock();
-					});
+				if (!m_chunkInstancer.AddDraw(*chunks[i], m_chunkSelections[i].GetVariant()))
+					continue;
 			}
+			else if (m_indirectDrawing && !m_rtinMeshCache.Find(*chunks[i]))
+				m_chunkArena.AddDraw(*chunks[i], m_chunkSelections[i].GetVariant());
+			else if (GetChunkVertexArray(*chunks[i]))
+				Renderer::Submit(shader, GetChunkVertexArray(*chunks[i]), {}, model * chunks[i]->GetTransform());
+			else
+				continue;
+
+			++m_visibleChunkCount;
 		}
+		m_culledChunkCount = chunks.size() - m_visibleChunkCount;
 
-		for (auto& thread : threads) {
-			thread.join();
+		if (m_indirectDrawing)
+			m_chunkArena.Draw(m_ShaderLibrary.Get("MapIndirectShader"), {}, model);
+		else if (m_instancedDrawing)
+			m_chunkInstancer.Draw(m_ShaderLibrary.Get("MapInstancedShader"), {}, model);
+	}
+
+	// The arena draws are culled by a compute pass, only the adaptive meshes drawn one by one are culled here
+	void SubmitChunksCulledOnGpu(const std::vector<Chunk*>& chunks, const std::shared_ptr<Shader>& shader, const glm::mat4& model)
+	{
+		const glm::mat4 viewProjection = m_cameraController.GetCamera().GetViewProjection();
+		const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+
+		size_t adaptiveChunkCount = 0;
+		m_chunkArena.BeginFrame();
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			const Chunk& chunk = *chunks[i];
+			if (!m_rtinMeshCache.Find(chunk))
+				m_chunkArena.AddDraw(chunk, m_chunkSelections[i].GetVariant());
+			else if (frustum.IntersectsAabb(chunk.GetBoundsMin(), chunk.GetBoundsMax()))
+			{
+				Renderer::Submit(shader, GetChunkVertexArray(*chunks[i]), {}, model * chunk.GetTransform());
+				++adaptiveChunkCount;
+			}
 		}
 
-		for (auto& chunk : m_chunks) {
-			GenerateChunk(chunk, true);
+		const auto start = std::chrono::steady_clock::now();
+		m_gpuChunkCuller->Cull(m_chunkArena, frustum, m_occlusionCulling ? m_hiZBuffer.get() : nullptr);
+		m_cullingTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		m_gpuChunkCuller->Draw(m_chunkArena, m_ShaderLibrary.Get("MapIndirectShader"), {}, model);
+
+		// Only the terrain occludes, the pyramid is tested by the next frame. The terrain draws must be made first
+		if (m_occlusionCulling)
+		{
+			Renderer::Flush();
+			m_hiZBuffer->Build(viewProjection);
 		}
+
+		// The GPU count lags a few frames behind
+		m_visibleChunkCount = std::min<size_t>(m_gpuChunkCuller->GetVisibleCount() + adaptiveChunkCount, chunks.size());
+		m_culledChunkCount = chunks.size() - m_visibleChunkCount;
+	}
+
+	// Picks the geomipmap level of every chunk from the camera of the scene and swaps their index buffers
+	void UpdateChunkLevels()
+	{
+		const std::vector<Chunk*> chunks = GetDrawnChunks();
+
+		const std::vector<const Chunk*> constChunks(chunks.begin(), chunks.end());
+
+		std::vector<GeoMipmap::MeshSelection>& selections = m_chunkSelections;
+		selections.assign(chunks.size(), {});
+		if (m_geomipmapping)
+			GeoMipmap::SelectLevels(constChunks, Renderer::GetCameraPosition(), Renderer::GetScreenSpaceErrorFactor(), m_lodPixelError, selections);
+
+		// Chunks with an adaptive mesh draw it instead of their grid, see GetChunkVertexArray
+		if (UsesAdaptiveMeshes())
+			m_rtinMeshCache.Update(constChunks, Renderer::GetCameraPosition(), Renderer::GetScreenSpaceErrorFactor(), m_lodPixelError);
+		else
+			m_rtinMeshCache.Clear();
+
+		m_triangleCount = m_rtinMeshCache.GetTriangleCount();
+
+		// Instances of the shared grid, the selections pick their index ranges. Chunks generated on the GPU keep
+		// their vertex array and swap their index buffers below
+		if (m_instancedDrawing)
+		{
+			m_chunkInstancer.Update(constChunks);
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				if (!chunks[i]->GetHeightMap().empty())
+					m_triangleCount += m_chunkInstancer.GetIndexCount(selections[i].GetVariant()) / 3;
+			}
+		}
+
+		// Drawn from the arena, the selections pick the index ranges of the commands built by SubmitChunks
+		if (m_indirectDrawing)
+		{
+			m_chunkArena.Update(constChunks);
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				if (!m_rtinMeshCache.Find(*chunks[i]))
+					m_triangleCount += m_chunkArena.GetIndexCount(*chunks[i], selections[i].GetVariant()) / 3;
+			}
+			return;
+		}
+
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			Chunk& chunk = *chunks[i];
+			const auto& vertexArray = chunk.GetVertexArray();
+			if (!vertexArray || m_rtinMeshCache.Find(chunk))
+				continue;
+
+			const auto& indexBuffer = m_indexBufferCache.GetChunkIndexBuffer(chunk.width, chunk.height, chunk.lod, selections[i].level, selections[i].stitchMask);
+			if (vertexArray->GetIndexBuffer() != indexBuffer)
+				vertexArray->SetIndexBuffer(indexBuffer);
+
+			m_triangleCount += indexBuffer->GetCount() / 3;
+		}
+	}
+
+	const std::shared_ptr<VertexArray>& GetChunkVertexArray(Chunk& chunk) const
+	{
+		const auto* adaptiveMesh = m_rtinMeshCache.Find(chunk);
+		return adaptiveMesh ? *adaptiveMesh : chunk.GetVertexArray();
+	}
+
+	ChunkGenerationParameters GetGenerationParameters() const
+	{
+		return { m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap, m_nbChunksX, m_nbChunksZ, m_chunkSize, m_lod, !m_instancedDrawing, UsesAdaptiveMeshes() };
+	}
+
+	void PollChunkRegeneration()
+	{
+		std::vector<size_t> chunksToUpload;
+		std::vector<StagingRing::Allocation> staging;
+		bool rebuilt = false;
+		if (!m_chunkRegenerator.Poll(m_chunks, chunksToUpload, staging, rebuilt))
+			return;
+
+		for (size_t i = 0; i < chunksToUpload.size(); ++i)
+			GenerateChunk(m_chunks[chunksToUpload[i]], rebuilt, staging[i]);
+
+		if (rebuilt)
+			m_indexBufferCache.Trim();
+	}
+
+	void GenerateChunksOnGpu()
+	{
+		for (int x = 0; x < m_nbChunksX; ++x)
+		{
+			for (int z = 0; z < m_nbChunksZ; ++z)
+			{
+				auto& chunk = m_chunks[x * m_nbChunksZ + z];
+				chunk = Chunk{ x, z, m_chunkSize, m_chunkSize, m_lod };
+				GenerateChunk(chunk, true);
+			}
+		}
+
+		m_gpuChunkGenerator->SetSettings(m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap);
+		if (m_indirectDrawing)
+			m_gpuChunkGenerator->Generate(m_chunks, m_chunkArena);
+		else
+			m_gpuChunkGenerator->Generate(m_chunks);
+		m_gpuValidationError = -1.f;
 	}
 
 	void GenerateWater()
 	{
+		if (m_clipmap)
+		{
+			const int extent = static_cast<int>(m_clipmap->GetExtent());
+			m_water = Water(extent, extent, m_waterHeight);
+			return;
+		}
+
+		if (m_streaming)
+		{
+			const int streamedChunks = 2 * (m_streamRadius + m_streamEvictionMargin) + 1;
+			m_water = Water(streamedChunks * (m_chunkSize - 1), streamedChunks * (m_chunkSize - 1), m_waterHeight);
+			return;
+		}
+
 		m_water = Water(m_nbChunksX * (m_chunkSize - 1), m_nbChunksZ * (m_chunkSize - 1), m_waterHeight);
 	}
 
+	// Streaming replaces the chunk rectangle, which is released while streaming is on
+	void SetStreaming(bool streaming)
+	{
+		m_streaming = streaming;
+		if (m_streaming)
+		{
+			m_chunkRegenerator.Cancel();
+			m_chunks.clear();
+			m_chunkStreamer.SetRadius(m_streamRadius, m_streamEvictionMargin);
+			m_chunkStreamer.SetParameters(GetGenerationParameters());
+		}
+		else
+		{
+			m_chunkStreamer.Clear();
+			GenerateChunks();
+		}
+
+		GenerateWater();
+	}
+
+	// The clipmap replaces the chunks, which are released while it is on
+	void SetClipmapRendering(bool clipmapRendering)
+	{
+		m_clipmapRendering = clipmapRendering;
+		if (m_clipmapRendering)
+		{
+			m_chunkRegenerator.Cancel();
+			m_chunks.clear();
+			m_chunkStreamer.Clear();
+			m_indexBufferCache.Trim();
+
+			m_clipmap = Clipmap::Create(kClipmapGridSize, m_clipmapLevels);
+			m_clipmap->SetSettings(m_continalnessNoiseSettings, m_erosionNoiseSettings, m_blendNoiseMap);
+			GenerateWater();
+			return;
+		}
+
+		m_clipmap.reset();
+		SetStreaming(m_streaming);
+	}
+
+	// Chunks drawn from the arena have no vertex array of their own, switching rebuilds or completes them
+	void SetIndirectDrawing(bool indirectDrawing)
+	{
+		m_indirectDrawing = indirectDrawing;
+		m_chunkArena.Clear();
+
+		if (!m_streaming)
+		{
+			GenerateChunks();
+			return;
+		}
+
+		// Loaded chunks keep their vertex arrays until evicted, the ones streamed in meanwhile need one
+		if (!m_indirectDrawing)
+			m_chunkStreamer.ForEachLoaded([this](Chunk& chunk)
+			{
+				if (!chunk.GetVertexArray())
+					GenerateChunk(chunk, true);
+			});
+	}
+
+	// Instanced chunks only keep their heights, every chunk is generated again with or without its vertices.
+	// The choice travels with the generation parameters, so jobs in flight finish with the one they started with
+	void SetInstancedDrawing(bool instancedDrawing)
+	{
+		m_instancedDrawing = instancedDrawing;
+		m_chunkInstancer.Clear();
+
+		if (m_streaming)
+			m_chunkStreamer.SetParameters(GetGenerationParameters());
+		else
+			GenerateChunks();
+	}
+
+	// Instanced chunks are drawn from the shared grid and have no adaptive mesh
+	bool UsesAdaptiveMeshes() const
+	{
+		return m_adaptiveMeshing && !m_instancedDrawing;
+	}
+
+	// The chunks only keep the RTIN errors of their adaptive mesh while it is on, they are updated again to
+	// compute or release them from their cached heights. Chunks generated on the GPU have none
+	void SetAdaptiveMeshing(bool adaptiveMeshing)
+	{
+		m_adaptiveMeshing = adaptiveMeshing;
+
+		if (m_clipmap)
+			return;
+
+		if (m_streaming)
+			m_chunkStreamer.SetParameters(GetGenerationParameters());
+		else if (!m_gpuGeneration)
+			m_chunkRegenerator.Request(GetGenerationParameters());
+	}
+
+	void SetTerrainShaderFloat(const std::string& name, float value)
+	{
+		for (const auto& shaderName : { "MapShader", "MapIndirectShader", "MapInstancedShader", "ClipmapShader" })
+		{
+			auto shader = m_ShaderLibrary.Get(shaderName);
+			shader->Bind();
+			shader->SetFloat(name, value);
+			shader->Unbind();
+		}
+	}
+
 private:
 	
     bool lauchRegenMap = false;
 	CameraController m_cameraController;
 
     std::vector<Chunk> m_chunks;
-	std::vector<std::shared_ptr<Texture2D>> m_textures;
+	static constexpr uint32_t kMaterialSize = 1024;
+	std::shared_ptr<Texture2DArray> m_materials;
 	ShaderLibrary m_ShaderLibrary;
+	IndexBufferCache m_indexBufferCache;
+
+	bool m_geomipmapping = true;
+	float m_lodPixelError = 2.f;
+	size_t m_triangleCount = 0;
+
+	bool m_adaptiveMeshing = false;
+	RtinMeshCache m_rtinMeshCache;
+
+	bool m_frustumCulling = true;
+	FrustumCuller m_frustumCuller;
+	size_t m_visibleChunkCount = 0;
+	size_t m_culledChunkCount = 0;
+	float m_cullingTime = 0.f;
+
+	// Level and stitching of every drawn chunk this frame, in GetDrawnChunks order
+	std::vector<GeoMipmap::MeshSelection> m_chunkSelections;
+
+	bool m_indirectDrawing = false;
+	ChunkArena m_chunkArena;
+
+	bool m_instancedDrawing = false;
+	ChunkInstancer m_chunkInstancer;
+
+	// Workers write the vertices of the chunks they generate into it, see GenerateChunk, and the blocks of the material layers
+	static constexpr size_t kStagingRingSize = 32 << 20;
+
+	// Bounds the copies the buffer defragmentation issues every frame
+	static constexpr size_t kDefragmentBytesPerFrame = 4 << 20;
+	std::shared_ptr<StagingRing> m_stagingRing;
+
+	bool m_gpuCulling = false;
+	bool m_occlusionCulling = true;
+	std::shared_ptr<GpuChunkCuller> m_gpuChunkCuller;
+	std::shared_ptr<HiZBuffer> m_hiZBuffer;
 
 	NoiseSettings m_continalnessNoiseSettings = continentalnessNoiseSettings;
 	NoiseSettings m_erosionNoiseSettings = erosionNoiseSettings;
 
 	bool m_generateMap = true;
 	bool m_blendNoiseMap = true;
+	bool m_gpuGeneration = false;
+
+	std::shared_ptr<GpuChunkGenerator> m_gpuChunkGenerator;
+	float m_gpuValidationError = -1.f;
 
 	HeightMap m_continalnessNoiseHeightMap;
 	HeightMap m_erosionNoiseHeightMap;
@@ -440,7 +1034,19 @@ private:
     float m_rockThreshold = 70.0f;
     float m_sandThreshold = 42.0f;
 
-	std::mutex mtx;
+	// Declared after m_chunks: its jobs read the chunks until it is destroyed
+	ChunkRegenerator m_chunkRegenerator;
+
+	bool m_streaming = false;
+	int m_streamRadius = 8;
+	int m_streamEvictionMargin = 2;
+	ChunkStreamer m_chunkStreamer;
+	TextureStreamer m_textureStreamer;
+
+	static constexpr int kClipmapGridSize = 128;
+	bool m_clipmapRendering = false;
+	int m_clipmapLevels = 8;
+	std::shared_ptr<Clipmap> m_clipmap;
 
 };
 
@@ -71,7 +71,7 @@ void Application::OnEvent(Event& e)
 
 	dispatcher.Dispatch<WindowResizeEvent>([](const WindowResizeEvent& event)
 	{
-		glViewport(0, 0, event.GetWidth(), event.GetHeight());
+		Renderer::OnWindowResize(event.GetWidth(), event.GetHeight());
 		return false;
 	});
 
@@ -70,7 +70,7 @@ public:
 
 	[[nodiscard]] const glm::mat4& GetView() const { return m_view; }
 
-	[[nodiscard]] const glm::mat4& GetViewProjection() const { return m_projection * m_view; }
+	[[nodiscard]] glm::mat4 GetViewProjection() const { return m_projection * m_view; }
 
 	[[nodiscard]] float GetYaw() const { return m_yaw; }
 
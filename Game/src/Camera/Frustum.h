@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <glm/glm.hpp>
+
+// View frustum as six planes (xyz normal pointing inside, w distance) extracted from a view projection matrix
+struct Frustum
+{
+	enum Plane { Left, Right, Bottom, Top, Near, Far, Count };
+
+	std::array<glm::vec4, Count> planes;
+
+	static Frustum FromViewProjection(const glm::mat4& viewProjection)
+	{
+		const glm::mat4 rows = glm::transpose(viewProjection);
+
+		Frustum frustum{};
+		frustum.planes[Left] = rows[3] + rows[0];
+		frustum.planes[Right] = rows[3] - rows[0];
+		frustum.planes[Bottom] = rows[3] + rows[1];
+		frustum.planes[Top] = rows[3] - rows[1];
+		frustum.planes[Near] = rows[3] + rows[2];
+		frustum.planes[Far] = rows[3] - rows[2];
+
+		for (auto& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	// Conservative: boxes crossing the corners outside the frustum may still be reported visible
+	[[nodiscard]] bool IntersectsAabb(const glm::vec3& min, const glm::vec3& max) const
+	{
+		for (const auto& plane : planes)
+		{
+			// Corner of the box furthest along the plane normal
+			const glm::vec3 corner(plane.x >= 0.f ? max.x : min.x, plane.y >= 0.f ? max.y : min.y, plane.z >= 0.f ? max.z : min.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f)
+				return false;
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,85 @@
+#include "FrustumCuller.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define FRUSTUM_CULLER_SSE 1
+#	include <xmmintrin.h>
+#else
+#	define FRUSTUM_CULLER_SSE 0
+#endif
+
+void FrustumCuller::Clear()
+{
+	m_count = 0;
+	m_minX.clear();
+	m_minY.clear();
+	m_minZ.clear();
+	m_maxX.clear();
+	m_maxY.clear();
+	m_maxZ.clear();
+}
+
+void FrustumCuller::Add(const glm::vec3& min, const glm::vec3& max)
+{
+	// Padding slots hold copies of a real box, the SIMD loop never reads uninitialised values
+	const size_t paddedCount = (m_count + 4) & ~size_t(3);
+	m_minX.resize(paddedCount, min.x);
+	m_minY.resize(paddedCount, min.y);
+	m_minZ.resize(paddedCount, min.z);
+	m_maxX.resize(paddedCount, max.x);
+	m_maxY.resize(paddedCount, max.y);
+	m_maxZ.resize(paddedCount, max.z);
+
+	m_minX[m_count] = min.x;
+	m_minY[m_count] = min.y;
+	m_minZ[m_count] = min.z;
+	m_maxX[m_count] = max.x;
+	m_maxY[m_count] = max.y;
+	m_maxZ[m_count] = max.z;
+	++m_count;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const
+{
+	const size_t paddedCount = m_minX.size();
+	visible.assign(paddedCount, 1);
+
+	for (const auto& plane : frustum.planes)
+	{
+		// The corner furthest along the normal is picked per plane, so every box reads the same arrays
+		const float* xs = plane.x >= 0.f ? m_maxX.data() : m_minX.data();
+		const float* ys = plane.y >= 0.f ? m_maxY.data() : m_minY.data();
+		const float* zs = plane.z >= 0.f ? m_maxZ.data() : m_minZ.data();
+
+#if FRUSTUM_CULLER_SSE
+		const __m128 nx = _mm_set1_ps(plane.x);
+		const __m128 ny = _mm_set1_ps(plane.y);
+		const __m128 nz = _mm_set1_ps(plane.z);
+		const __m128 w = _mm_set1_ps(plane.w);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (size_t i = 0; i < paddedCount; i += 4)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(xs + i)), _mm_mul_ps(ny, _mm_loadu_ps(ys + i)));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(nz, _mm_loadu_ps(zs + i))), w);
+
+			const int outside = _mm_movemask_ps(_mm_cmplt_ps(distance, zero));
+			if (outside == 0)
+				continue;
+
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if (outside & (1 << lane))
+					visible[i + lane] = 0;
+			}
+		}
+#else
+		for (size_t i = 0; i < paddedCount; ++i)
+		{
+			if (plane.x * xs[i] + plane.y * ys[i] + plane.z * zs[i] + plane.w < 0.f)
+				visible[i] = 0;
+		}
+#endif
+	}
+
+	visible.resize(m_count);
+}
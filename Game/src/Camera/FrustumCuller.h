@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+// Boxes stored as a structure of arrays, tested four at a time against each plane of a frustum with SSE
+class FrustumCuller
+{
+public:
+	void Clear();
+
+	void Add(const glm::vec3& min, const glm::vec3& max);
+
+	// visible[i] is set when box i intersects the frustum, with the same conservative test as Frustum::IntersectsAabb
+	void Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+	[[nodiscard]] size_t GetCount() const { return m_count; }
+
+private:
+	size_t m_count = 0;
+
+	// Padded to a multiple of 4 boxes
+	std::vector<float> m_minX, m_minY, m_minZ;
+	std::vector<float> m_maxX, m_maxY, m_maxZ;
+};
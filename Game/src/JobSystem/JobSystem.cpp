@@ -0,0 +1,166 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Queue owned by the current thread, -1 for threads that are not workers of the pool
+	thread_local int t_queueIndex = -1;
+	thread_local const JobSystem* t_owner = nullptr;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		// The thread waiting on a batch runs jobs too, so leave it a core
+		const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+	}
+
+	m_queues.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+		m_queues.push_back(std::make_unique<WorkQueue>());
+
+	m_workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+		m_workers.emplace_back([this, i] { WorkerLoop(i); });
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stop = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void JobSystem::Execute(Job job, JobCounter& counter)
+{
+	counter.m_value.fetch_add(1, std::memory_order_relaxed);
+	Push({ std::move(job), &counter });
+}
+
+void JobSystem::Dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(uint32_t)>& job, JobCounter& counter)
+{
+	if (jobCount == 0)
+		return;
+
+	groupSize = std::max(1u, groupSize);
+	const uint32_t groupCount = (jobCount + groupSize - 1) / groupSize;
+	counter.m_value.fetch_add(groupCount, std::memory_order_relaxed);
+
+	for (uint32_t group = 0; group < groupCount; ++group)
+	{
+		const uint32_t begin = group * groupSize;
+		const uint32_t end = std::min(begin + groupSize, jobCount);
+		Push({ [job, begin, end] {
+			for (uint32_t i = begin; i < end; ++i)
+				job(i);
+		}, &counter });
+	}
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!TryRunOne())
+			std::this_thread::yield();
+	}
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem instance;
+	return instance;
+}
+
+void JobSystem::Push(QueuedJob job)
+{
+	// Workers keep what they spawn, other threads spread jobs over all the queues
+	const size_t queueIndex = (t_owner == this && t_queueIndex >= 0)
+		? static_cast<size_t>(t_queueIndex)
+		: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+	{
+		auto& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	m_pendingJobs.fetch_add(1, std::memory_order_release);
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+bool JobSystem::TryPop(QueuedJob& job)
+{
+	if (m_pendingJobs.load(std::memory_order_acquire) == 0)
+		return false;
+
+	const bool isWorker = t_owner == this && t_queueIndex >= 0;
+	if (isWorker)
+	{
+		auto& queue = *m_queues[t_queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			m_pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	const size_t queueCount = m_queues.size();
+	const size_t start = isWorker ? static_cast<size_t>(t_queueIndex) + 1 : 0;
+	for (size_t i = 0; i < queueCount; ++i)
+	{
+		auto& victim = *m_queues[(start + i) % queueCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			m_pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::TryRunOne()
+{
+	QueuedJob job;
+	if (!TryPop(job))
+		return false;
+
+	job.job();
+	if (job.counter)
+		job.counter->m_value.fetch_sub(1, std::memory_order_acq_rel);
+
+	return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	t_queueIndex = static_cast<int>(index);
+	t_owner = this;
+
+	while (!m_stop)
+	{
+		if (TryRunOne())
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this] { return m_stop || m_pendingJobs.load(std::memory_order_acquire) > 0; });
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the jobs of a batch that are still running, Wait() on it to join the batch.
+class JobCounter
+{
+public:
+	[[nodiscard]] bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> m_value = 0;
+};
+
+// Set by the owner of a batch to stop its jobs early, the jobs poll it between rows of work.
+class CancellationToken
+{
+public:
+	void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+	[[nodiscard]] bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+	// Null tokens are never cancelled
+	[[nodiscard]] static bool IsCancelled(const CancellationToken* token) { return token && token->IsCancelled(); }
+
+private:
+	std::atomic<bool> m_cancelled = false;
+};
+
+// Fixed pool of worker threads sized to the hardware. Every worker owns a deque,
+// pops its own jobs from the back and steals from the front of the others when empty.
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	explicit JobSystem(uint32_t workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void Execute(Job job, JobCounter& counter);
+
+	// Runs job(i) for i in [0, jobCount), grouped by groupSize indices per job
+	void Dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(uint32_t)>& job, JobCounter& counter);
+
+	// Blocks until the counter reaches zero, the calling thread runs pending jobs meanwhile
+	void Wait(const JobCounter& counter);
+
+	[[nodiscard]] uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	static JobSystem& Get();
+
+private:
+	struct QueuedJob
+	{
+		Job job;
+		JobCounter* counter = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	void Push(QueuedJob job);
+	bool TryPop(QueuedJob& job);
+	bool TryRunOne();
+	void WorkerLoop(uint32_t index);
+
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::atomic<uint32_t> m_pendingJobs = 0;
+	std::atomic<uint32_t> m_nextQueue = 0;
+	std::atomic<bool> m_stop = false;
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+};
@@ -5,7 +5,13 @@
 
 enum class ShaderDataType
 {
-	None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool
+	None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool,
+
+	// Compact vertex formats, read as floats. The 16 bit and packed ones are normalized when the element is
+	Half, Half2, Half3, Half4, Short, Short2, Short4, UShort, UShort2, UShort4,
+
+	// 10 bits for xyz and 2 for w packed in 32 bits (GL_INT_2_10_10_10_REV and GL_UNSIGNED_INT_2_10_10_10_REV)
+	Int1010102, UInt1010102
 };
 
 static uint32_t ShaderDataTypeSize(ShaderDataType type)
@@ -23,6 +29,18 @@ static uint32_t ShaderDataTypeSize(ShaderDataType type)
 		case ShaderDataType::Int3:     return 4 * 3;
 		case ShaderDataType::Int4:     return 4 * 4;
 		case ShaderDataType::Bool:     return 1;
+		case ShaderDataType::Half:     return 2;
+		case ShaderDataType::Half2:    return 2 * 2;
+		case ShaderDataType::Half3:    return 2 * 3;
+		case ShaderDataType::Half4:    return 2 * 4;
+		case ShaderDataType::Short:    return 2;
+		case ShaderDataType::Short2:   return 2 * 2;
+		case ShaderDataType::Short4:   return 2 * 4;
+		case ShaderDataType::UShort:   return 2;
+		case ShaderDataType::UShort2:  return 2 * 2;
+		case ShaderDataType::UShort4:  return 2 * 4;
+		case ShaderDataType::Int1010102:  return 4;
+		case ShaderDataType::UInt1010102: return 4;
 		default: throw std::runtime_error("Unknown ShaderDataType!");
 	}
 }
@@ -57,6 +75,18 @@ struct BufferElement
 			case ShaderDataType::Int3:    return 3;
 			case ShaderDataType::Int4:    return 4;
 			case ShaderDataType::Bool:    return 1;
+			case ShaderDataType::Half:    return 1;
+			case ShaderDataType::Half2:   return 2;
+			case ShaderDataType::Half3:   return 3;
+			case ShaderDataType::Half4:   return 4;
+			case ShaderDataType::Short:   return 1;
+			case ShaderDataType::Short2:  return 2;
+			case ShaderDataType::Short4:  return 4;
+			case ShaderDataType::UShort:  return 1;
+			case ShaderDataType::UShort2: return 2;
+			case ShaderDataType::UShort4: return 4;
+			case ShaderDataType::Int1010102:  return 4;
+			case ShaderDataType::UInt1010102: return 4;
 			default: throw std::runtime_error("Unknown ShaderDataType!");
 		}
 	}
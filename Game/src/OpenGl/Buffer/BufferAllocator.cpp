@@ -0,0 +1,264 @@
+#include "BufferAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	constexpr uint32_t kNoBlock = std::numeric_limits<uint32_t>::max();
+
+	GLsizeiptr Align(GLsizeiptr size)
+	{
+		return (size + BufferAllocator::kAlignment - 1) / BufferAllocator::kAlignment * BufferAllocator::kAlignment;
+	}
+}
+
+BufferAllocator& BufferAllocator::Get()
+{
+	static BufferAllocator instance;
+	return instance;
+}
+
+BufferAllocation* BufferAllocator::Allocate(GLsizeiptr size, const void* data)
+{
+	const GLsizeiptr alignedSize = Align(std::max<GLsizeiptr>(size, 1));
+
+	uint32_t block;
+	GLintptr offset;
+	if (alignedSize > kBlockSize / 2)
+	{
+		block = CreateBlock(alignedSize, true);
+		offset = 0;
+		RemoveFreeRange(block, 0, alignedSize);
+		m_blocks[block].usedSize = alignedSize;
+	}
+	else if (!AllocateRange(alignedSize, -1, block, offset))
+	{
+		CreateBlock(kBlockSize, false);
+		if (!AllocateRange(alignedSize, -1, block, offset))
+			throw std::runtime_error("Failed to allocate buffer memory!");
+	}
+
+	auto* allocation = new BufferAllocation{ m_blocks[block].buffer, offset, alignedSize, 0, block };
+	m_blocks[block].allocations.insert(allocation);
+
+	if (data)
+		glNamedBufferSubData(allocation->buffer, offset, size, data);
+
+	return allocation;
+}
+
+void BufferAllocator::Free(BufferAllocation* allocation)
+{
+	if (!allocation)
+		return;
+
+	Block& block = m_blocks[allocation->block];
+	block.allocations.erase(allocation);
+	block.usedSize -= allocation->size;
+
+	if (block.dedicated)
+		ReleaseBlock(allocation->block);
+	else
+		AddFreeRange(allocation->block, allocation->offset, allocation->size);
+
+	delete allocation;
+}
+
+void BufferAllocator::Defragment(size_t maxBytes)
+{
+	// Empty blocks are released, one is kept to avoid recreating it right away
+	uint32_t emptyBlock = kNoBlock;
+	for (uint32_t i = 0; i < m_blocks.size(); ++i)
+	{
+		if (!m_blocks[i].buffer || m_blocks[i].dedicated || !m_blocks[i].allocations.empty())
+			continue;
+
+		if (emptyBlock == kNoBlock)
+			emptyBlock = i;
+		else
+			ReleaseBlock(i);
+	}
+
+	// The emptiest block is moved into the free ranges of the denser ones when they can take all of it. Only
+	// denser blocks receive its allocations: the kept empty block or an equally sparse one would be the source
+	// of a later call and the same bytes would go back and forth
+	uint32_t source = kNoBlock;
+	for (uint32_t i = 0; i < m_blocks.size(); ++i)
+	{
+		const Block& block = m_blocks[i];
+		if (!block.buffer || block.dedicated || i == emptyBlock)
+			continue;
+
+		if (source == kNoBlock || block.usedSize < m_blocks[source].usedSize)
+			source = i;
+	}
+
+	if (source == kNoBlock)
+		return;
+
+	const GLsizeiptr sourceUsedSize = m_blocks[source].usedSize;
+	GLsizeiptr denserFreeSize = 0;
+	for (const Block& block : m_blocks)
+	{
+		if (block.buffer && !block.dedicated && block.usedSize > sourceUsedSize)
+			denserFreeSize += block.size - block.usedSize;
+	}
+
+	if (denserFreeSize < sourceUsedSize)
+		return;
+
+	std::vector<BufferAllocation*> allocations(m_blocks[source].allocations.begin(), m_blocks[source].allocations.end());
+	std::ranges::sort(allocations, [](const BufferAllocation* a, const BufferAllocation* b) { return a->offset < b->offset; });
+
+	size_t movedBytes = 0;
+	for (BufferAllocation* allocation : allocations)
+	{
+		// At least one allocation is moved, however large
+		if (movedBytes > 0 && movedBytes + allocation->size > maxBytes)
+			break;
+
+		uint32_t block;
+		GLintptr offset;
+		if (!AllocateRange(allocation->size, sourceUsedSize, block, offset))
+			break;
+
+		glCopyNamedBufferSubData(allocation->buffer, m_blocks[block].buffer, allocation->offset, offset, allocation->size);
+
+		Block& sourceBlock = m_blocks[source];
+		sourceBlock.allocations.erase(allocation);
+		sourceBlock.usedSize -= allocation->size;
+		AddFreeRange(source, allocation->offset, allocation->size);
+
+		allocation->buffer = m_blocks[block].buffer;
+		allocation->offset = offset;
+		allocation->block = block;
+		++allocation->version;
+		m_blocks[block].allocations.insert(allocation);
+
+		movedBytes += allocation->size;
+	}
+
+	m_movedBytes += movedBytes;
+
+	if (m_blocks[source].allocations.empty() && emptyBlock != kNoBlock)
+		ReleaseBlock(source);
+}
+
+BufferAllocator::Stats BufferAllocator::GetStats() const
+{
+	Stats stats;
+	for (const Block& block : m_blocks)
+	{
+		if (!block.buffer)
+			continue;
+
+		++stats.blockCount;
+		stats.reservedBytes += block.size;
+		stats.usedBytes += block.usedSize;
+		stats.allocationCount += block.allocations.size();
+		stats.freeRangeCount += block.freeRanges.size();
+		for (const auto& [offset, size] : block.freeRanges)
+			stats.largestFreeRange = std::max(stats.largestFreeRange, static_cast<size_t>(size));
+	}
+
+	stats.movedBytes = m_movedBytes;
+	return stats;
+}
+
+bool BufferAllocator::AllocateRange(GLsizeiptr size, GLsizeiptr minUsedSize, uint32_t& block, GLintptr& offset)
+{
+	// The ranges of the size class of the request can be smaller than it, the ones of the larger classes cannot
+	for (size_t sizeClass = GetSizeClass(size); sizeClass < kSizeClassCount; ++sizeClass)
+	{
+		for (const auto& [rangeBlock, rangeOffset] : m_freeLists[sizeClass])
+		{
+			if (m_blocks[rangeBlock].usedSize <= minUsedSize)
+				continue;
+
+			const GLsizeiptr rangeSize = m_blocks[rangeBlock].freeRanges.at(rangeOffset);
+			if (rangeSize < size)
+				continue;
+
+			block = rangeBlock;
+			offset = rangeOffset;
+
+			RemoveFreeRange(block, offset, rangeSize);
+			if (rangeSize > size)
+				AddFreeRange(block, offset + size, rangeSize - size);
+
+			m_blocks[block].usedSize += size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void BufferAllocator::AddFreeRange(uint32_t block, GLintptr offset, GLsizeiptr size)
+{
+	auto& ranges = m_blocks[block].freeRanges;
+
+	auto next = ranges.lower_bound(offset);
+	if (next != ranges.end() && offset + size == next->first)
+	{
+		m_freeLists[GetSizeClass(next->second)].erase({ block, next->first });
+		size += next->second;
+		next = ranges.erase(next);
+	}
+
+	if (next != ranges.begin())
+	{
+		const auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			m_freeLists[GetSizeClass(previous->second)].erase({ block, previous->first });
+			offset = previous->first;
+			size += previous->second;
+			ranges.erase(previous);
+		}
+	}
+
+	ranges.emplace(offset, size);
+	m_freeLists[GetSizeClass(size)].insert({ block, offset });
+}
+
+void BufferAllocator::RemoveFreeRange(uint32_t block, GLintptr offset, GLsizeiptr size)
+{
+	m_blocks[block].freeRanges.erase(offset);
+	m_freeLists[GetSizeClass(size)].erase({ block, offset });
+}
+
+uint32_t BufferAllocator::CreateBlock(GLsizeiptr size, bool dedicated)
+{
+	const auto released = std::ranges::find_if(m_blocks, [](const Block& block) { return block.buffer == 0; });
+	const auto index = static_cast<uint32_t>(released - m_blocks.begin());
+	if (released == m_blocks.end())
+		m_blocks.emplace_back();
+
+	Block& block = m_blocks[index];
+	glCreateBuffers(1, &block.buffer);
+	glNamedBufferStorage(block.buffer, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	block.size = size;
+	block.usedSize = 0;
+	block.dedicated = dedicated;
+
+	AddFreeRange(index, 0, size);
+	return index;
+}
+
+void BufferAllocator::ReleaseBlock(uint32_t block)
+{
+	for (const auto& [offset, size] : m_blocks[block].freeRanges)
+		m_freeLists[GetSizeClass(size)].erase({ block, offset });
+
+	glDeleteBuffers(1, &m_blocks[block].buffer);
+	m_blocks[block] = Block();
+}
+
+size_t BufferAllocator::GetSizeClass(GLsizeiptr size)
+{
+	return std::min<size_t>(std::bit_width(static_cast<uint64_t>(size)) - 1, kSizeClassCount - 1);
+}
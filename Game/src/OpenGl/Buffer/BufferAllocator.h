@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Range of a buffer owned by a VertexBuffer or IndexBuffer. A defragmentation can move it, version then changes
+struct BufferAllocation
+{
+	GLuint buffer = 0;
+	GLintptr offset = 0;
+	GLsizeiptr size = 0;
+	uint32_t version = 0;
+
+	uint32_t block = 0;
+};
+
+// Carves the vertex and index buffers out of a few large GL buffers, so regenerating chunks neither creates
+// nor deletes buffer objects. Free ranges are coalesced and kept in a free list per power of two size class.
+// Allocations larger than half a block get a block of their own. Defragment moves a bounded amount of
+// allocations per call out of the emptiest block into denser ones and deletes the blocks left empty.
+// Must be used from the thread owning the GL context. The blocks are never deleted at exit, the context
+// is already gone by then and takes them with it.
+class BufferAllocator
+{
+public:
+	// Offsets are aligned for any vertex attribute, index type and shader storage binding
+	static constexpr GLsizeiptr kAlignment = 256;
+	static constexpr GLsizeiptr kBlockSize = 64 << 20;
+
+	struct Stats
+	{
+		size_t blockCount = 0;
+		size_t reservedBytes = 0;
+		size_t usedBytes = 0;
+		size_t allocationCount = 0;
+		size_t freeRangeCount = 0;
+		size_t largestFreeRange = 0;
+		size_t movedBytes = 0;
+	};
+
+	BufferAllocator(const BufferAllocator&) = delete;
+	BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+	static BufferAllocator& Get();
+
+	// The storage is uninitialised when data is null. The allocation stays valid until freed
+	BufferAllocation* Allocate(GLsizeiptr size, const void* data = nullptr);
+	void Free(BufferAllocation* allocation);
+
+	// Moves at most maxBytes of allocations, once per frame
+	void Defragment(size_t maxBytes);
+
+	[[nodiscard]] Stats GetStats() const;
+
+private:
+	struct Block
+	{
+		GLuint buffer = 0;
+		GLsizeiptr size = 0;
+		GLsizeiptr usedSize = 0;
+		bool dedicated = false;
+
+		// Offset -> size of the free ranges, coalesced
+		std::map<GLintptr, GLsizeiptr> freeRanges;
+		std::unordered_set<BufferAllocation*> allocations;
+	};
+
+	// Block index and offset of a free range, the size is in the block
+	using FreeRange = std::pair<uint32_t, GLintptr>;
+
+	static constexpr size_t kSizeClassCount = 48;
+
+	BufferAllocator() = default;
+
+	// Only searches the free lists of the blocks using more than minUsedSize, a block is never created
+	bool AllocateRange(GLsizeiptr size, GLsizeiptr minUsedSize, uint32_t& block, GLintptr& offset);
+	void AddFreeRange(uint32_t block, GLintptr offset, GLsizeiptr size);
+	void RemoveFreeRange(uint32_t block, GLintptr offset, GLsizeiptr size);
+	uint32_t CreateBlock(GLsizeiptr size, bool dedicated);
+	void ReleaseBlock(uint32_t block);
+
+	static size_t GetSizeClass(GLsizeiptr size);
+
+	// Released blocks stay in the vector with no buffer, their index is reused
+	std::vector<Block> m_blocks;
+	std::array<std::set<FreeRange>, kSizeClassCount> m_freeLists;
+
+	size_t m_movedBytes = 0;
+};
@@ -1,32 +1,43 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <gl/glew.h>
+#include "BufferAllocator.h"
 
 class IndexBuffer
 {
 public:
-	IndexBuffer(uint32_t* indices, uint32_t count) : m_Count(count)
+	IndexBuffer(uint32_t* indices, uint32_t count) : m_Count(count), m_Type(GL_UNSIGNED_INT)
 	{
         Load(indices, count);
     }
 
+	IndexBuffer(const uint16_t* indices, uint32_t count) : m_Count(count), m_Type(GL_UNSIGNED_SHORT)
+	{
+		Load(indices, count);
+	}
+
     void Load(const uint32_t *indices, uint32_t count)
     {
-        glCreateBuffers(1, &m_RendererID);
-        // GL_ELEMENT_ARRAY_BUFFER is not valid without an actively bound VAO
-        // Binding with GL_ARRAY_BUFFER allows the data to be loaded regardless of VAO state.
-        glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-        glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+        m_Allocation = BufferAllocator::Get().Allocate(count * sizeof(uint32_t), indices);
     }
 
+	void Load(const uint16_t* indices, uint32_t count)
+	{
+		m_Allocation = BufferAllocator::Get().Allocate(count * sizeof(uint16_t), indices);
+	}
+
     ~IndexBuffer()
 	{
-		glDeleteBuffers(1, &m_RendererID);
+		BufferAllocator::Get().Free(m_Allocation);
 	}
 
+	IndexBuffer(const IndexBuffer&) = delete;
+	IndexBuffer& operator=(const IndexBuffer&) = delete;
+
 	void Bind() const
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Allocation->buffer);
 	}
 
 	void Unbind() const
@@ -34,21 +45,42 @@ public:
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
+	// Reuses the range when the indices fit, a larger one is only allocated to grow
 	void SetData(uint32_t* indices, uint32_t count)
 	{
+		const size_t size = count * sizeof(uint32_t);
 		m_Count = count;
-		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+		m_Type = GL_UNSIGNED_INT;
+		if (static_cast<GLsizeiptr>(size) > m_Allocation->size)
+		{
+			BufferAllocator::Get().Free(m_Allocation);
+			m_Allocation = BufferAllocator::Get().Allocate(static_cast<GLsizeiptr>(size), indices);
+		}
+		else
+			glNamedBufferSubData(m_Allocation->buffer, m_Allocation->offset, static_cast<GLsizeiptr>(size), indices);
 	}
 
 	uint32_t GetCount() const { return m_Count; }
 
+	// The indices are a range of a shared buffer, which a defragmentation can move. The offset is in bytes
+	GLuint GetRendererID() const { return m_Allocation->buffer; }
+	GLintptr GetOffset() const { return m_Allocation->offset; }
+
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, as expected by glDrawElements
+	GLenum GetType() const { return m_Type; }
+
 	static std::shared_ptr<IndexBuffer> Create(uint32_t* indices, uint32_t count)
 	{
 		return std::make_shared<IndexBuffer>(indices, count);
 	}
 
+	static std::shared_ptr<IndexBuffer> Create(const uint16_t* indices, uint32_t count)
+	{
+		return std::make_shared<IndexBuffer>(indices, count);
+	}
+
 private:
-	uint32_t m_RendererID;
+	BufferAllocation* m_Allocation = nullptr;
 	uint32_t m_Count;
+	GLenum m_Type;
 };
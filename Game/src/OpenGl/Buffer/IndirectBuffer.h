@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+
+// Layout of the commands read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
+class IndirectBuffer
+{
+public:
+	IndirectBuffer()
+	{
+		glCreateBuffers(1, &m_RendererID);
+	}
+
+	~IndirectBuffer()
+	{
+		glDeleteBuffers(1, &m_RendererID);
+	}
+
+	// Replaces the commands, the storage only grows
+	void SetCommands(const std::vector<DrawElementsIndirectCommand>& commands)
+	{
+		Reserve(static_cast<uint32_t>(commands.size()));
+
+		if (!commands.empty())
+			glNamedBufferSubData(m_RendererID, 0, static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand)), commands.data());
+	}
+
+	// Room for count commands written on the GPU (as a shader storage buffer), the storage only grows
+	void Reserve(uint32_t count)
+	{
+		m_count = count;
+
+		const size_t size = count * sizeof(DrawElementsIndirectCommand);
+		if (size > m_capacity)
+		{
+			m_capacity = std::max(size, m_capacity * 2);
+			glNamedBufferData(m_RendererID, static_cast<GLsizeiptr>(m_capacity), nullptr, GL_DYNAMIC_DRAW);
+		}
+	}
+
+	void Bind() const
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+	}
+
+	uint32_t GetCount() const { return m_count; }
+
+	GLuint GetRendererID() const { return m_RendererID; }
+
+	static std::shared_ptr<IndirectBuffer> Create()
+	{
+		return std::make_shared<IndirectBuffer>();
+	}
+
+private:
+	GLuint m_RendererID = 0;
+	uint32_t m_count = 0;
+	size_t m_capacity = 0;
+};
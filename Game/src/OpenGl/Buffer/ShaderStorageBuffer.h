@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <GL/glew.h>
+
+class ShaderStorageBuffer
+{
+public:
+	ShaderStorageBuffer(uint32_t size, uint32_t binding): m_size(size), m_binding(binding)
+	{
+		glCreateBuffers(1, &m_RendererID);
+		glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_RendererID);
+	}
+
+	~ShaderStorageBuffer()
+	{
+		glDeleteBuffers(1, &m_RendererID);
+	}
+
+	void SetData(const void* data, uint32_t size, uint32_t offset = 0)
+	{
+		if (offset + size > m_size)
+		{
+			// Grow the storage, the previous content is lost
+			m_size = offset + size;
+			glNamedBufferData(m_RendererID, m_size, nullptr, GL_DYNAMIC_DRAW);
+		}
+		glNamedBufferSubData(m_RendererID, offset, size, data);
+	}
+
+	void Bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, m_RendererID);
+	}
+
+	uint32_t GetRendererID() const { return m_RendererID; }
+
+	static std::shared_ptr<ShaderStorageBuffer> Create(uint32_t size, uint32_t binding)
+	{
+		return std::make_shared<ShaderStorageBuffer>(size, binding);
+	}
+private:
+	uint32_t m_RendererID = 0;
+	uint32_t m_size = 0;
+	uint32_t m_binding = 0;
+};
@@ -0,0 +1,146 @@
+#include "StagingRing.h"
+
+namespace
+{
+	// Blocks start on a cache line, workers writing neighbouring blocks do not share one
+	constexpr size_t kAlignment = 64;
+
+	constexpr GLuint64 kFenceTimeout = 1'000'000'000;
+
+	constexpr GLbitfield kMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+StagingRing::StagingRing(size_t size): m_size(size)
+{
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferStorage(m_buffer, static_cast<GLsizeiptr>(size), nullptr, kMapFlags);
+	m_data = static_cast<uint8_t*>(glMapNamedBufferRange(m_buffer, 0, static_cast<GLsizeiptr>(size), kMapFlags));
+}
+
+StagingRing::~StagingRing()
+{
+	for (const Fence& fence : m_fences)
+		glDeleteSync(fence.sync);
+
+	glUnmapNamedBuffer(m_buffer);
+	glDeleteBuffers(1, &m_buffer);
+}
+
+StagingRing::Allocation StagingRing::Allocate(size_t size)
+{
+	const size_t alignedSize = (size + kAlignment - 1) / kAlignment * kAlignment;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_blocks.empty())
+	{
+		m_head = 0;
+		m_wrapped = false;
+	}
+
+	// Free space is [head, end) then [0, tail) before wrapping, [head, tail) after
+	const size_t tail = m_blocks.empty() ? m_size : m_blocks.front().offset;
+	size_t offset = m_head;
+	if (!m_data || alignedSize > m_size)
+		offset = m_size;
+	else if (!m_wrapped && m_head + alignedSize > m_size)
+	{
+		offset = alignedSize <= tail ? 0 : m_size;
+		m_wrapped = offset == 0;
+	}
+	else if (m_wrapped && m_head + alignedSize > tail)
+		offset = m_size;
+
+	if (offset == m_size)
+	{
+		++m_overflowCount;
+		return {};
+	}
+
+	m_head = offset + alignedSize;
+	m_usedSize += alignedSize;
+	m_blocks.push_back({ offset, alignedSize });
+
+	Allocation allocation;
+	allocation.m_ring = this;
+	allocation.m_data = m_data + offset;
+	allocation.m_offset = offset;
+	allocation.m_size = size;
+	allocation.m_id = m_firstId + m_blocks.size() - 1;
+	return allocation;
+}
+
+void StagingRing::Copy(const Allocation& allocation, GLuint buffer, GLintptr offset)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	glCopyNamedBufferSubData(m_buffer, buffer, static_cast<GLintptr>(allocation.m_offset), offset, static_cast<GLsizeiptr>(allocation.m_size));
+	m_blocks[allocation.m_id - m_firstId].copyFrame = m_frame;
+}
+
+void StagingRing::CopyToTextureLayer(const Allocation& allocation, size_t offset, size_t size, GLuint texture, GLint level, GLint layer, GLsizei width, GLsizei height, GLenum format)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+	glCompressedTextureSubImage3D(texture, level, 0, 0, layer, width, height, 1, format, static_cast<GLsizei>(size), reinterpret_cast<const void*>(allocation.m_offset + offset));
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	m_blocks[allocation.m_id - m_firstId].copyFrame = m_frame;
+}
+
+void StagingRing::EndFrame()
+{
+	// Fences are only touched by the GL thread, the workers keep allocating meanwhile
+	m_fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_frame });
+
+	uint64_t completedFrame = 0;
+	while (!m_fences.empty())
+	{
+		// Past kFramesInFlight frames the oldest one is waited for, the others are only polled
+		const bool wait = m_fences.size() > kFramesInFlight;
+		const GLenum status = glClientWaitSync(m_fences.front().sync, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? kFenceTimeout : 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		completedFrame = m_fences.front().frame;
+		glDeleteSync(m_fences.front().sync);
+		m_fences.pop_front();
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_frame;
+	if (completedFrame > 0)
+		m_completedFrame = completedFrame;
+	Recycle();
+}
+
+size_t StagingRing::GetUsedSize() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_usedSize;
+}
+
+size_t StagingRing::GetOverflowCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_overflowCount;
+}
+
+void StagingRing::Release(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_blocks[id - m_firstId].released = true;
+	Recycle();
+}
+
+void StagingRing::Recycle()
+{
+	while (!m_blocks.empty() && m_blocks.front().released && m_blocks.front().copyFrame <= m_completedFrame)
+	{
+		const size_t offset = m_blocks.front().offset;
+		m_usedSize -= m_blocks.front().size;
+		m_blocks.pop_front();
+		++m_firstId;
+
+		// The tail moved past the end of the ring, back to a single free range
+		if (m_wrapped && (m_blocks.empty() || m_blocks.front().offset < offset))
+			m_wrapped = false;
+	}
+}
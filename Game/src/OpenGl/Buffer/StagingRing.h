@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <GL/glew.h>
+
+// Upload memory persistently mapped once (glBufferStorage), carved in order like a ring. Any thread can
+// allocate and write into it, the thread owning the GL context only issues the copies to the destination
+// buffers. An allocation is recycled once it is released and the frame of its copy completed on the GPU
+// (glFenceSync), with at most kFramesInFlight frames of copies pending.
+class StagingRing
+{
+public:
+	static constexpr size_t kFramesInFlight = 3;
+
+	// Released when destroyed, from any thread. Empty when the ring had no room
+	class Allocation
+	{
+	public:
+		Allocation() = default;
+		~Allocation() { Reset(); }
+
+		Allocation(Allocation&& other) noexcept { *this = std::move(other); }
+		Allocation& operator=(Allocation&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				m_ring = std::exchange(other.m_ring, nullptr);
+				m_data = other.m_data;
+				m_offset = other.m_offset;
+				m_size = other.m_size;
+				m_id = other.m_id;
+			}
+			return *this;
+		}
+
+		Allocation(const Allocation&) = delete;
+		Allocation& operator=(const Allocation&) = delete;
+
+		void Reset()
+		{
+			if (m_ring)
+				m_ring->Release(m_id);
+			m_ring = nullptr;
+		}
+
+		explicit operator bool() const { return m_ring != nullptr; }
+
+		[[nodiscard]] void* GetData() const { return m_data; }
+		[[nodiscard]] size_t GetSize() const { return m_size; }
+
+	private:
+		friend class StagingRing;
+
+		StagingRing* m_ring = nullptr;
+		void* m_data = nullptr;
+		size_t m_offset = 0;
+		size_t m_size = 0;
+		uint64_t m_id = 0;
+	};
+
+	explicit StagingRing(size_t size);
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	// Thread safe, the ring must outlive the allocation
+	Allocation Allocate(size_t size);
+
+	// GL thread: copies the allocation into buffer at offset, the allocation can be released right after
+	void Copy(const Allocation& allocation, GLuint buffer, GLintptr offset);
+
+	// GL thread: uploads size bytes of compressed blocks, at offset in the allocation, to a level of a layer of
+	// a texture array. The ring is the pixel unpack buffer of the upload
+	void CopyToTextureLayer(const Allocation& allocation, size_t offset, size_t size, GLuint texture, GLint level, GLint layer, GLsizei width, GLsizei height, GLenum format);
+
+	// GL thread, once per frame after its copies: fences them and recycles the completed allocations
+	void EndFrame();
+
+	[[nodiscard]] size_t GetSize() const { return m_size; }
+	[[nodiscard]] size_t GetUsedSize() const;
+
+	// Allocations refused because the ring was full, their owners uploaded without it
+	[[nodiscard]] size_t GetOverflowCount() const;
+
+	static std::shared_ptr<StagingRing> Create(size_t size)
+	{
+		return std::make_shared<StagingRing>(size);
+	}
+
+private:
+	struct Block
+	{
+		size_t offset;
+		size_t size;
+		bool released = false;
+
+		// Frame of the last copy from the block, 0 when never copied
+		uint64_t copyFrame = 0;
+	};
+
+	struct Fence
+	{
+		GLsync sync;
+		uint64_t frame;
+	};
+
+	void Release(uint64_t id);
+
+	// m_mutex must be held
+	void Recycle();
+
+	GLuint m_buffer = 0;
+	uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+	mutable std::mutex m_mutex;
+
+	// Blocks in allocation order, the first one has the id m_firstId
+	std::deque<Block> m_blocks;
+	uint64_t m_firstId = 1;
+	size_t m_head = 0;
+	bool m_wrapped = false;
+	size_t m_usedSize = 0;
+	size_t m_overflowCount = 0;
+
+	// Frames numbered from 1, m_completedFrame is the last one the GPU finished
+	uint64_t m_frame = 1;
+	uint64_t m_completedFrame = 0;
+	std::deque<Fence> m_fences;
+};
@@ -22,6 +22,19 @@ public:
 		glNamedBufferSubData(m_RendererID, offset, size, data);
 	}
 
+	void Bind(uint32_t binding) const
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
+	}
+
+	// Offset must be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	void BindRange(uint32_t binding, uint32_t offset, uint32_t size) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_RendererID, offset, size);
+	}
+
+	uint32_t GetRendererID() const { return m_RendererID; }
+
 	static std::shared_ptr<UniformBuffer> Create(uint32_t size, uint32_t binding)
 	{
 		return std::make_shared<UniformBuffer>(size, binding);
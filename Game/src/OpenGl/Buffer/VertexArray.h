@@ -22,6 +22,18 @@ static GLenum ShaderDataTypeToOpenGLBaseType(ShaderDataType type)
 		case ShaderDataType::Int3:     return GL_INT;
 		case ShaderDataType::Int4:     return GL_INT;
 		case ShaderDataType::Bool:     return GL_BOOL;
+		case ShaderDataType::Half:     return GL_HALF_FLOAT;
+		case ShaderDataType::Half2:    return GL_HALF_FLOAT;
+		case ShaderDataType::Half3:    return GL_HALF_FLOAT;
+		case ShaderDataType::Half4:    return GL_HALF_FLOAT;
+		case ShaderDataType::Short:    return GL_SHORT;
+		case ShaderDataType::Short2:   return GL_SHORT;
+		case ShaderDataType::Short4:   return GL_SHORT;
+		case ShaderDataType::UShort:   return GL_UNSIGNED_SHORT;
+		case ShaderDataType::UShort2:  return GL_UNSIGNED_SHORT;
+		case ShaderDataType::UShort4:  return GL_UNSIGNED_SHORT;
+		case ShaderDataType::Int1010102:  return GL_INT_2_10_10_10_REV;
+		case ShaderDataType::UInt1010102: return GL_UNSIGNED_INT_2_10_10_10_REV;
 	}
 
 	throw std::runtime_error("Unknown ShaderDataType!");
@@ -40,9 +52,27 @@ public:
 		glDeleteVertexArrays(1, &m_id);
 	}
 
+	// Points the attributes and the indices again at the buffers a defragmentation moved
 	void Bind()
 	{
 		glBindVertexArray(m_id);
+
+		for (size_t i = 0; i < m_VertexBuffers.size(); ++i)
+		{
+			const auto& vertexBuffer = m_VertexBuffers[i];
+			BufferBinding& binding = m_vertexBufferBindings[i];
+			if (binding.buffer != vertexBuffer->GetRendererID() || binding.offset != vertexBuffer->GetOffset())
+			{
+				SetAttributes(vertexBuffer, binding.firstAttribute);
+				binding = { vertexBuffer->GetRendererID(), vertexBuffer->GetOffset(), binding.firstAttribute };
+			}
+		}
+
+		if (m_IndexBuffer && m_indexBufferID != m_IndexBuffer->GetRendererID())
+		{
+			m_IndexBuffer->Bind();
+			m_indexBufferID = m_IndexBuffer->GetRendererID();
+		}
 	}
 
 	void Unbind()
@@ -50,9 +80,52 @@ public:
 		glBindVertexArray(0);
 	}
 
-	void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer)
+	// The attributes of a buffer with a divisor advance once every divisor instances instead of every vertex
+	void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, uint32_t divisor = 0)
 	{
 		glBindVertexArray(m_id);
+		m_vertexBufferBindings.push_back({ vertexBuffer->GetRendererID(), vertexBuffer->GetOffset(), m_vertexBufferIndex });
+
+		const uint32_t firstAttribute = m_vertexBufferIndex;
+		m_vertexBufferIndex = SetAttributes(vertexBuffer, m_vertexBufferIndex);
+		if (divisor != 0)
+		{
+			for (uint32_t attribute = firstAttribute; attribute < m_vertexBufferIndex; ++attribute)
+				glVertexAttribDivisor(attribute, divisor);
+		}
+
+		m_VertexBuffers.push_back(vertexBuffer);
+	}
+
+	void SetIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
+
+		glBindVertexArray(m_id);
+		indexBuffer->Bind();
+
+		m_IndexBuffer = indexBuffer;
+		m_indexBufferID = indexBuffer->GetRendererID();
+	}
+
+	const std::vector<std::shared_ptr<VertexBuffer>>& GetVertexBuffers() const { return m_VertexBuffers; }
+	const std::shared_ptr<IndexBuffer>& GetIndexBuffer() const { return m_IndexBuffer; }
+
+	static std::shared_ptr<VertexArray> Create()
+	{
+		return std::make_shared<VertexArray>();
+	}
+
+private:
+	// Buffer and offset the attributes of a vertex buffer were last set with
+	struct BufferBinding
+	{
+		GLuint buffer;
+		GLintptr offset;
+		uint32_t firstAttribute;
+	};
+
+	// The vertex array must be bound, returns the index after the last attribute
+	static uint32_t SetAttributes(const std::shared_ptr<VertexBuffer>& vertexBuffer, uint32_t attributeIndex)
+	{
 		vertexBuffer->Bind();
 
 		const auto& layout = vertexBuffer->GetLayout();
@@ -64,15 +137,28 @@ public:
 				case ShaderDataType::Float2:
 				case ShaderDataType::Float3:
 				case ShaderDataType::Float4:
+				case ShaderDataType::Half:
+				case ShaderDataType::Half2:
+				case ShaderDataType::Half3:
+				case ShaderDataType::Half4:
+				case ShaderDataType::Short:
+				case ShaderDataType::Short2:
+				case ShaderDataType::Short4:
+				case ShaderDataType::UShort:
+				case ShaderDataType::UShort2:
+				case ShaderDataType::UShort4:
+				case ShaderDataType::Int1010102:
+				case ShaderDataType::UInt1010102:
 				{
-					glEnableVertexAttribArray(m_vertexBufferIndex);
-					glVertexAttribPointer(m_vertexBufferIndex,
+					// Integers are converted to floats as they are, or to [0, 1] ([-1, 1] signed) when normalized
+					glEnableVertexAttribArray(attributeIndex);
+					glVertexAttribPointer(attributeIndex,
 						element.GetComponentCount(),
 						ShaderDataTypeToOpenGLBaseType(element.Type),
 						element.Normalized ? GL_TRUE : GL_FALSE,
 						layout.GetStride(),
-						(const void*)element.Offset);
-					m_vertexBufferIndex++;
+						(const void*)(vertexBuffer->GetOffset() + element.Offset));
+					attributeIndex++;
 					break;
 				}
 				case ShaderDataType::Int:
@@ -81,13 +167,13 @@ public:
 				case ShaderDataType::Int4:
 				case ShaderDataType::Bool:
 				{
-					glEnableVertexAttribArray(m_vertexBufferIndex);
-					glVertexAttribIPointer(m_vertexBufferIndex,
+					glEnableVertexAttribArray(attributeIndex);
+					glVertexAttribIPointer(attributeIndex,
 						element.GetComponentCount(),
 						ShaderDataTypeToOpenGLBaseType(element.Type),
 						layout.GetStride(),
-						(const void*)element.Offset);
-					m_vertexBufferIndex++;
+						(const void*)(vertexBuffer->GetOffset() + element.Offset));
+					attributeIndex++;
 					break;
 				}
 				case ShaderDataType::Mat3:
@@ -96,15 +182,15 @@ public:
 					uint8_t count = element.GetComponentCount();
 					for (uint8_t i = 0; i < count; i++)
 					{
-						glEnableVertexAttribArray(m_vertexBufferIndex);
-						glVertexAttribPointer(m_vertexBufferIndex,
+						glEnableVertexAttribArray(attributeIndex);
+						glVertexAttribPointer(attributeIndex,
 							count,
 							ShaderDataTypeToOpenGLBaseType(element.Type),
 							element.Normalized ? GL_TRUE : GL_FALSE,
 							layout.GetStride(),
-							(const void*)(element.Offset + sizeof(float) * count * i));
-						glVertexAttribDivisor(m_vertexBufferIndex, 1);
-						m_vertexBufferIndex++;
+							(const void*)(vertexBuffer->GetOffset() + element.Offset + sizeof(float) * count * i));
+						glVertexAttribDivisor(attributeIndex, 1);
+						attributeIndex++;
 					}
 					break;
 				}
@@ -113,30 +199,15 @@ public:
 			}
 		}
 
-		m_VertexBuffers.push_back(vertexBuffer);
-	}
-
-	void SetIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
-
-		glBindVertexArray(m_id);
-		indexBuffer->Bind();
-
-		m_IndexBuffer = indexBuffer;
+		return attributeIndex;
 	}
 
-	const std::vector<std::shared_ptr<VertexBuffer>>& GetVertexBuffers() const { return m_VertexBuffers; }
-	const std::shared_ptr<IndexBuffer>& GetIndexBuffer() const { return m_IndexBuffer; }
-
-	static std::shared_ptr<VertexArray> Create()
-	{
-		return std::make_shared<VertexArray>();
-	}
-
-private:
 	GLuint m_id;
 	uint32_t m_vertexBufferIndex = 0;
 	std::vector<std::shared_ptr<VertexBuffer>> m_VertexBuffers;
+	std::vector<BufferBinding> m_vertexBufferBindings;
 	std::shared_ptr<IndexBuffer> m_IndexBuffer;
+	GLuint m_indexBufferID = 0;
 
 };
 
@@ -3,6 +3,7 @@
 #include <memory>
 #include <gl/glew.h>
 #include "Buffer.h"
+#include "BufferAllocator.h"
 
 class VertexBuffer
 {
@@ -12,26 +13,27 @@ public:
 		Load(size);
 	}
 
-	VertexBuffer(float* vertices, uint32_t size)
+	VertexBuffer(const void* vertices, uint32_t size)
 	{
         Load(size, vertices);
 	}
 
-    void Load(uint32_t size, float* vertices = nullptr)
+    void Load(uint32_t size, const void* vertices = nullptr)
     {
-        glCreateBuffers(1, &m_id);
-        glBindBuffer(GL_ARRAY_BUFFER, m_id);
-        glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+        m_allocation = BufferAllocator::Get().Allocate(size, vertices);
     }
 
 	~VertexBuffer()
 	{
-		glDeleteBuffers(1, &m_id);
+		BufferAllocator::Get().Free(m_allocation);
 	}
 
+	VertexBuffer(const VertexBuffer&) = delete;
+	VertexBuffer& operator=(const VertexBuffer&) = delete;
+
 	void Bind() const
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_id);
+		glBindBuffer(GL_ARRAY_BUFFER, m_allocation->buffer);
 	}
 
 	void Unbind() const
@@ -39,18 +41,21 @@ public:
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
-	void SetData(const void* data, const uint32_t size)
+	void SetData(const void* data, const uint32_t size, const uint32_t offset = 0)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_id);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		glNamedBufferSubData(m_allocation->buffer, m_allocation->offset + offset, size, data);
 	}
 
-
 	const BufferLayout& GetLayout() const { return m_layout; }
 
+	// The vertices are a range of a shared buffer, which a defragmentation can move
+	GLuint GetRendererID() const { return m_allocation->buffer; }
+	GLintptr GetOffset() const { return m_allocation->offset; }
+	GLsizeiptr GetSize() const { return m_allocation->size; }
+
 	void SetLayout(const BufferLayout& layout) { m_layout = layout; }
 
-	static std::shared_ptr<VertexBuffer> Create(float* vertices, uint32_t size)
+	static std::shared_ptr<VertexBuffer> Create(const void* vertices, uint32_t size)
 	{
 		return std::make_shared<VertexBuffer>(vertices, size);
 	}
@@ -62,6 +67,6 @@ public:
 
 
 private:
-	GLuint m_id;
+	BufferAllocation* m_allocation = nullptr;
 	BufferLayout m_layout;
 };
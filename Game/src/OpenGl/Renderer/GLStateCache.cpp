@@ -0,0 +1,74 @@
+#include "GLStateCache.h"
+
+#include "../Buffer/VertexArray.h"
+#include "../Shader/Shader.h"
+
+void GLStateCache::Invalidate()
+{
+	m_program = kUnknown;
+	m_vertexArray = nullptr;
+	m_textures.fill(kUnknown);
+	m_storageBuffers.fill(kUnknown);
+	m_drawIndirectBuffer = kUnknown;
+	m_parameterBuffer = kUnknown;
+}
+
+bool GLStateCache::UseProgram(Shader& shader)
+{
+	if (!Set(m_program, shader.GetRendererID()))
+		return false;
+
+	shader.Bind();
+	return true;
+}
+
+void GLStateCache::BindVertexArray(VertexArray& vertexArray)
+{
+	if (m_vertexArray == &vertexArray)
+	{
+		++m_stats.skippedBinds;
+		return;
+	}
+
+	// Bind also follows the buffers moved by a defragmentation, it runs at least once per flush
+	++m_stats.binds;
+	m_vertexArray = &vertexArray;
+	vertexArray.Bind();
+}
+
+void GLStateCache::BindTexture(uint32_t unit, GLuint texture)
+{
+	if (unit >= kTextureUnitCount || Set(m_textures[unit], texture))
+		glBindTextureUnit(unit, texture);
+}
+
+void GLStateCache::BindDrawIndirectBuffer(GLuint buffer)
+{
+	if (Set(m_drawIndirectBuffer, buffer))
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+}
+
+void GLStateCache::BindParameterBuffer(GLuint buffer)
+{
+	if (Set(m_parameterBuffer, buffer))
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, buffer);
+}
+
+void GLStateCache::BindStorageBuffer(uint32_t binding, GLuint buffer)
+{
+	if (binding >= kStorageBindingCount || Set(m_storageBuffers[binding], buffer))
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
+
+bool GLStateCache::Set(GLuint& current, GLuint value)
+{
+	if (current == value)
+	{
+		++m_stats.skippedBinds;
+		return false;
+	}
+
+	++m_stats.binds;
+	current = value;
+	return true;
+}
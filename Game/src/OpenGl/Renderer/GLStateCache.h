@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+class Shader;
+class VertexArray;
+
+// Remembers the bindings made through it and skips the ones already in place. It knows nothing of the
+// binds made around it, Invalidate must follow them before it is used again.
+class GLStateCache
+{
+public:
+	static constexpr uint32_t kTextureUnitCount = 32;
+	static constexpr uint32_t kStorageBindingCount = 8;
+
+	struct Stats
+	{
+		size_t binds = 0;
+		size_t skippedBinds = 0;
+	};
+
+	GLStateCache() { Invalidate(); }
+
+	// Every binding is unknown, the next bind of each one is made
+	void Invalidate();
+
+	// True when the program changed
+	bool UseProgram(Shader& shader);
+	void BindVertexArray(VertexArray& vertexArray);
+	void BindTexture(uint32_t unit, GLuint texture);
+	void BindDrawIndirectBuffer(GLuint buffer);
+	void BindParameterBuffer(GLuint buffer);
+	void BindStorageBuffer(uint32_t binding, GLuint buffer);
+
+	[[nodiscard]] const Stats& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = {}; }
+
+private:
+	// Tells whether the binding changes and records it
+	bool Set(GLuint& current, GLuint value);
+
+	static constexpr GLuint kUnknown = ~0u;
+
+	GLuint m_program = kUnknown;
+	VertexArray* m_vertexArray = nullptr;
+	std::array<GLuint, kTextureUnitCount> m_textures{};
+	std::array<GLuint, kStorageBindingCount> m_storageBuffers{};
+	GLuint m_drawIndirectBuffer = kUnknown;
+	GLuint m_parameterBuffer = kUnknown;
+
+	Stats m_stats;
+};
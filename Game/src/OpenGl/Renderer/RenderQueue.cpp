@@ -0,0 +1,46 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "../Shader/Shader.h"
+
+void RenderQueue::Submit(const RenderCommand& command, RenderPass pass, float distance)
+{
+	auto* recorded = m_arena.Allocate<RenderCommand>();
+	*recorded = command;
+	recorded->textures = m_arena.Copy(command.textures);
+	recorded->uniforms = m_arena.Copy(command.uniforms);
+
+	m_keys.emplace_back(MakeKey(pass, command.shader->GetRendererID(), command.textureSetHash, distance), recorded);
+}
+
+const std::vector<const RenderCommand*>& RenderQueue::Sort()
+{
+	std::ranges::stable_sort(m_keys, {}, &std::pair<uint64_t, const RenderCommand*>::first);
+
+	m_sorted.clear();
+	for (const auto& [key, command] : m_keys)
+		m_sorted.push_back(command);
+	return m_sorted;
+}
+
+void RenderQueue::Clear()
+{
+	m_keys.clear();
+	m_sorted.clear();
+	m_arena.Reset();
+}
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, GLuint program, uint64_t textureSetHash, float distance)
+{
+	// The bits of a positive float sort like its value, the transparent draws go the other way
+	uint32_t depth = std::bit_cast<uint32_t>(std::max(distance, 0.f));
+	if (pass == RenderPass::Transparent)
+		depth = ~depth;
+
+	return static_cast<uint64_t>(pass) << 62
+		| static_cast<uint64_t>(program & 0x3FFF) << 48
+		| (textureSetHash & 0xFFFF) << 32
+		| depth;
+}
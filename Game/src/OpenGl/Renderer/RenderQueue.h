@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "../Shader/UniformName.h"
+#include "../../Utils/FrameArena.h"
+
+class IndirectBuffer;
+class Shader;
+class VertexArray;
+
+// Passes are drawn in order: the opaque draws front to back, then the transparent ones back to front
+enum class RenderPass : uint8_t
+{
+	Opaque,
+	Transparent,
+};
+
+// Texture bound on its own unit for a draw, its sampler uniform set to the unit
+struct TextureBinding
+{
+	GLuint texture;
+	UniformName uniform;
+};
+
+// Uniform set on the shader right before a draw, for the values changing between draws of one shader
+struct UniformValue
+{
+	enum class Type : uint8_t
+	{
+		Int,
+		Int2,
+		Float,
+	};
+
+	UniformValue(UniformName name, int value) : name(name), type(Type::Int), intValue(value, 0) {}
+	UniformValue(UniformName name, const glm::ivec2& value) : name(name), type(Type::Int2), intValue(value) {}
+	UniformValue(UniformName name, float value) : name(name), type(Type::Float), floatValue(value) {}
+
+	UniformName name;
+	Type type;
+	glm::ivec2 intValue = glm::ivec2(0);
+	float floatValue = 0.f;
+};
+
+// Everything a draw needs besides its shader, mesh, textures and transform. The spans are copied when submitted
+struct DrawState
+{
+	// Bound on the units after the textures of the draw
+	std::span<const TextureBinding> textures;
+	std::span<const UniformValue> uniforms;
+
+	// Shader storage buffer bound for the draw, none when 0
+	GLuint storageBuffer = 0;
+	uint32_t storageBinding = 0;
+
+	RenderPass pass = RenderPass::Opaque;
+};
+
+// A recorded draw. Everything it points to lives in the frame arena or must outlive the flush of the queue
+struct RenderCommand
+{
+	enum class Type : uint8_t
+	{
+		Indexed,
+		Indirect,
+		IndirectCount,
+	};
+
+	Type type;
+	Shader* shader;
+	VertexArray* vertexArray;
+
+	// Indirect draws only, the command count is the one of the buffer when submitted
+	GLuint commands;
+	uint32_t commandCount;
+	GLuint parameterBuffer;
+
+	glm::mat4 transform;
+
+	// The textures of the draw followed by the ones of its DrawState
+	std::span<const TextureBinding> textures;
+	std::span<const UniformValue> uniforms;
+	GLuint storageBuffer;
+	uint32_t storageBinding;
+
+	// Identifies the texture set, the sampler uniforms are only set again when it changes
+	uint64_t textureSetHash;
+};
+
+// Draws of a frame, recorded in a frame arena and sorted by a 64 bit key before they are executed:
+// pass (2 bits), program (14 bits), texture set (16 bits) and view distance (32 bits). Commands sharing
+// a program and textures end up next to each other, the distance orders the ones of a pass.
+class RenderQueue
+{
+public:
+	// Copies the command and its spans into the arena. distance is from the camera to the draw
+	void Submit(const RenderCommand& command, RenderPass pass, float distance);
+
+	// Commands by key, ties kept in submission order
+	[[nodiscard]] const std::vector<const RenderCommand*>& Sort();
+
+	// Forgets the commands, the arena memory is kept for the next frame
+	void Clear();
+
+	[[nodiscard]] size_t GetCommandCount() const { return m_keys.size(); }
+	[[nodiscard]] size_t GetArenaSize() const { return m_arena.GetCapacity(); }
+
+	static uint64_t MakeKey(RenderPass pass, GLuint program, uint64_t textureSetHash, float distance);
+
+private:
+	FrameArena m_arena;
+
+	// Key and command, the vectors keep their capacity from one frame to the next
+	std::vector<std::pair<uint64_t, const RenderCommand*>> m_keys;
+	std::vector<const RenderCommand*> m_sorted;
+};
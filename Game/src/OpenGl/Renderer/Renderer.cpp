@@ -1,11 +1,16 @@
 #include "Renderer.h"
 #include "RendererAPI.h"
 
+#include <cmath>
+
+#include "../../Utils/Hash.h"
+
 std::unique_ptr<Renderer::SceneData> Renderer::s_SceneData = std::make_unique<Renderer::SceneData>();
 
 void Renderer::OnWindowResize(uint32_t width, uint32_t height)
 {
 	RendererAPI::Get()->SetViewport(0, 0, width, height);
+	s_SceneData->ViewportHeight = height;
 }
 
 void Renderer::BeginScene(const Camera& camera)
@@ -13,33 +18,202 @@ void Renderer::BeginScene(const Camera& camera)
 	s_SceneData->ViewProjectionMatrix = camera.GetViewProjection();
 	s_SceneData->ViewMatrix = camera.GetView();
 	s_SceneData->ProjectionMatrix = camera.GetProjection();
+
+	s_SceneData->CameraPosition = camera.GetPosition();
+	s_SceneData->ScreenSpaceErrorFactor = static_cast<float>(s_SceneData->ViewportHeight) / (2.f * std::tan(glm::radians(camera.GetFOV()) * 0.5f));
+
+	if (!s_SceneData->SceneBuffer)
+	{
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		const auto slotAlignment = static_cast<uint32_t>(alignment);
+		s_SceneData->ObjectSlotSize = (static_cast<uint32_t>(sizeof(ObjectUniforms)) + slotAlignment - 1) / slotAlignment * slotAlignment;
+
+		s_SceneData->SceneBuffer = UniformBuffer::Create(sizeof(SceneUniforms), kSceneBinding);
+		s_SceneData->ObjectBuffer = UniformBuffer::Create(s_SceneData->ObjectSlotSize * kObjectSlotCount, kObjectBinding);
+	}
+
+	const SceneUniforms uniforms{ s_SceneData->ViewProjectionMatrix, s_SceneData->ViewMatrix, s_SceneData->ProjectionMatrix, glm::vec4(s_SceneData->CameraPosition, 1.f) };
+	s_SceneData->SceneBuffer->SetData(&uniforms, sizeof(SceneUniforms));
+	s_SceneData->SceneBuffer->Bind(kSceneBinding);
+
+	s_SceneData->ObjectSlot = 0;
+	s_SceneData->ObjectBound = false;
 }
 
 void Renderer::EndScene()
 {
+	Flush();
+
+	s_SceneData->LastStats = s_SceneData->FrameStats;
+	s_SceneData->FrameStats = {};
+}
+
+void Renderer::Flush()
+{
+	RenderQueue& queue = s_SceneData->Queue;
+	GLStateCache& stateCache = s_SceneData->StateCache;
+
+	// Anything may have been bound since the last flush
+	stateCache.Invalidate();
+	stateCache.ResetStats();
 
+	if (s_SceneData->Materials)
+		stateCache.BindTexture(kMaterialUnit, s_SceneData->Materials->GetRendererID());
+
+	for (const RenderCommand* command : queue.Sort())
+		Execute(*command);
+
+	Stats& stats = s_SceneData->FrameStats;
+	stats.commandCount += queue.GetCommandCount();
+	stats.binds += stateCache.GetStats().binds;
+	stats.skippedBinds += stateCache.GetStats().skippedBinds;
+	stats.arenaSize = queue.GetArenaSize();
+
+	queue.Clear();
 }
 
 void Renderer::Submit(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray
                         , const std::vector<std::shared_ptr<Texture2D>>& textures
-                        , const glm::mat4& transform)
-{
-	shader->Bind();
-	shader->SetMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-	shader->SetMat4("u_View", s_SceneData->ViewMatrix);
-	shader->SetMat4("u_Projection", s_SceneData->ProjectionMatrix);
-	shader->SetMat4("u_Transform", transform);
-
-	vertexArray->Bind();
-
-    if (!textures.empty())
-    {
-        for (int i = 0; i < textures.size(); i++)
-        {
-            textures[i]->Bind(i);
-            shader->SetInt(textures[i]->GetName(), i);
-        }
-    }
-
-	RendererAPI::Get()->DrawIndexed(vertexArray);
-}
\ No newline at end of file
+                        , const glm::mat4& transform
+                        , const DrawState& state)
+{
+	RenderCommand command{};
+	command.type = RenderCommand::Type::Indexed;
+	command.shader = shader.get();
+	command.vertexArray = vertexArray.get();
+	command.transform = transform;
+	Record(command, textures, state);
+}
+
+void Renderer::SubmitIndirect(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray
+                        , const std::shared_ptr<IndirectBuffer>& commands
+                        , const std::vector<std::shared_ptr<Texture2D>>& textures
+                        , const glm::mat4& transform
+                        , const DrawState& state)
+{
+	if (commands->GetCount() == 0)
+		return;
+
+	RenderCommand command{};
+	command.type = RenderCommand::Type::Indirect;
+	command.shader = shader.get();
+	command.vertexArray = vertexArray.get();
+	command.commands = commands->GetRendererID();
+	command.commandCount = commands->GetCount();
+	command.transform = transform;
+	Record(command, textures, state);
+}
+
+void Renderer::SubmitIndirectCount(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray
+                        , const std::shared_ptr<IndirectBuffer>& commands
+                        , GLuint parameterBuffer
+                        , const std::vector<std::shared_ptr<Texture2D>>& textures
+                        , const glm::mat4& transform
+                        , const DrawState& state)
+{
+	if (commands->GetCount() == 0)
+		return;
+
+	RenderCommand command{};
+	command.type = RenderCommand::Type::IndirectCount;
+	command.shader = shader.get();
+	command.vertexArray = vertexArray.get();
+	command.commands = commands->GetRendererID();
+	command.commandCount = commands->GetCount();
+	command.parameterBuffer = parameterBuffer;
+	command.transform = transform;
+	Record(command, textures, state);
+}
+
+void Renderer::Record(RenderCommand& command, const std::vector<std::shared_ptr<Texture2D>>& textures, const DrawState& state)
+{
+	std::vector<TextureBinding>& bindings = s_SceneData->TextureBindings;
+	bindings.clear();
+	for (const auto& texture : textures)
+		bindings.push_back({ texture->GetRendererID(), texture->GetUniformName() });
+	bindings.insert(bindings.end(), state.textures.begin(), state.textures.end());
+
+	uint64_t textureSetHash = Hash::kFnvOffset;
+	for (const TextureBinding& binding : bindings)
+	{
+		textureSetHash = Hash::Combine(textureSetHash, binding.texture);
+		textureSetHash = Hash::Combine(textureSetHash, binding.uniform.GetHash());
+	}
+
+	command.textures = bindings;
+	command.uniforms = state.uniforms;
+	command.storageBuffer = state.storageBuffer;
+	command.storageBinding = state.storageBinding;
+	command.textureSetHash = textureSetHash;
+
+	// Distance to the origin of the draw, the corner of a chunk
+	const float distance = glm::length(glm::vec3(command.transform[3]) - s_SceneData->CameraPosition);
+	s_SceneData->Queue.Submit(command, state.pass, distance);
+}
+
+void Renderer::Execute(const RenderCommand& command)
+{
+	GLStateCache& stateCache = s_SceneData->StateCache;
+	Shader& shader = *command.shader;
+
+	// Sampler uniforms are state of the program, they only change with the texture set
+	if (stateCache.UseProgram(shader) || s_SceneData->SamplerTextureSet != command.textureSetHash)
+	{
+		for (uint32_t i = 0; i < command.textures.size(); ++i)
+			shader.SetInt(command.textures[i].uniform, static_cast<int>(kFirstTextureUnit + i));
+		s_SceneData->SamplerTextureSet = command.textureSetHash;
+	}
+
+	for (uint32_t i = 0; i < command.textures.size(); ++i)
+		stateCache.BindTexture(kFirstTextureUnit + i, command.textures[i].texture);
+
+	for (const UniformValue& uniform : command.uniforms)
+	{
+		switch (uniform.type)
+		{
+			case UniformValue::Type::Int:   shader.SetInt(uniform.name, uniform.intValue.x); break;
+			case UniformValue::Type::Int2:  shader.SetInt2(uniform.name, uniform.intValue); break;
+			case UniformValue::Type::Float: shader.SetFloat(uniform.name, uniform.floatValue); break;
+		}
+	}
+
+	if (command.storageBuffer)
+		stateCache.BindStorageBuffer(command.storageBinding, command.storageBuffer);
+
+	BindObject(command.transform);
+	stateCache.BindVertexArray(*command.vertexArray);
+
+	const IndexBuffer& indexBuffer = *command.vertexArray->GetIndexBuffer();
+	switch (command.type)
+	{
+		case RenderCommand::Type::Indexed:
+			RendererAPI::Get()->DrawIndexed(indexBuffer);
+			break;
+		case RenderCommand::Type::Indirect:
+			stateCache.BindDrawIndirectBuffer(command.commands);
+			RendererAPI::Get()->MultiDrawIndexedIndirect(indexBuffer, command.commandCount);
+			break;
+		case RenderCommand::Type::IndirectCount:
+			stateCache.BindDrawIndirectBuffer(command.commands);
+			stateCache.BindParameterBuffer(command.parameterBuffer);
+			RendererAPI::Get()->MultiDrawIndexedIndirectCount(indexBuffer, command.commandCount);
+			break;
+	}
+}
+
+void Renderer::BindObject(const glm::mat4& transform)
+{
+	// The clipmap levels and the multi-draws of a frame share their transform
+	if (s_SceneData->ObjectBound && s_SceneData->BoundTransform == transform)
+		return;
+
+	const uint32_t offset = s_SceneData->ObjectSlot * s_SceneData->ObjectSlotSize;
+	const ObjectUniforms uniforms{ transform };
+	s_SceneData->ObjectBuffer->SetData(&uniforms, sizeof(ObjectUniforms), offset);
+	s_SceneData->ObjectBuffer->BindRange(kObjectBinding, offset, sizeof(ObjectUniforms));
+
+	s_SceneData->ObjectSlot = (s_SceneData->ObjectSlot + 1) % kObjectSlotCount;
+	s_SceneData->ObjectBound = true;
+	s_SceneData->BoundTransform = transform;
+}
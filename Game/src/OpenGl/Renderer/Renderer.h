@@ -1,31 +1,125 @@
 #pragma once
 #include "../../Camera/Camera.h"
+#include "../Buffer/IndirectBuffer.h"
+#include "../Buffer/UniformBuffer.h"
 #include "../Buffer/VertexArray.h"
 #include "../Shader/Shader.h"
 #include "../Texture/Texture.h"
+#include "../Texture/Texture2DArray.h"
+#include "GLStateCache.h"
+#include "RenderQueue.h"
 
 class OrthographicCamera;
 
 class Renderer
 {
 public:
+	// Uniform block bindings shared by the shaders, see the Scene and Object blocks of the Map shader
+	static constexpr uint32_t kSceneBinding = 0;
+	static constexpr uint32_t kObjectBinding = 1;
+
+	// Unit of the terrain materials (u_Materials), the textures of the draws start after it
+	static constexpr uint32_t kMaterialUnit = 0;
+	static constexpr uint32_t kFirstTextureUnit = 1;
+
 	static void Init();
 	static void Shutdown();
 
 	static void OnWindowResize(uint32_t width, uint32_t height);
 
+	// Uploads the camera to the Scene block, once for every draw of the frame
 	static void BeginScene(const Camera& camera);
 
+	// Flushes the draws of the frame
 	static void EndScene();
 
-	static void Submit(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform = glm::mat4(1.0f));
+	// Bound once at the start of every flush, for all the draws
+	static void SetMaterials(const std::shared_ptr<Texture2DArray>& materials) { s_SceneData->Materials = materials; }
+
+	// Executes the draws submitted so far, sorted, for the passes reading what they rendered (see HiZBuffer)
+	static void Flush();
+
+	// The Submit functions only record the draw, it is made by the next Flush or EndScene. The shader, vertex
+	// array and buffers must stay alive and unchanged until then, the state is copied
+	static void Submit(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform = glm::mat4(1.0f), const DrawState& state = {});
+
+	// Draws every command of the buffer with one glMultiDrawElementsIndirect
+	static void SubmitIndirect(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray, const std::shared_ptr<IndirectBuffer>& commands, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform = glm::mat4(1.0f), const DrawState& state = {});
+
+	// Draws the first commands of the buffer, as many as the count written on the GPU in parameterBuffer
+	static void SubmitIndirectCount(const std::shared_ptr<Shader>& shader, const std::shared_ptr<VertexArray>& vertexArray, const std::shared_ptr<IndirectBuffer>& commands, GLuint parameterBuffer, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform = glm::mat4(1.0f), const DrawState& state = {});
+
+	struct Stats
+	{
+		size_t commandCount = 0;
+		size_t binds = 0;
+		size_t skippedBinds = 0;
+		size_t arenaSize = 0;
+	};
+
+	// Of the last frame
+	static const Stats& GetStats() { return s_SceneData->LastStats; }
+
+	// Camera of the current scene
+	static const glm::vec3& GetCameraPosition() { return s_SceneData->CameraPosition; }
+
+	// Pixels covered by one world unit at a distance of one, used to project geometric errors on screen
+	static float GetScreenSpaceErrorFactor() { return s_SceneData->ScreenSpaceErrorFactor; }
 
 private:
+	// Fills the textures and the key parts of the command and queues it
+	static void Record(RenderCommand& command, const std::vector<std::shared_ptr<Texture2D>>& textures, const DrawState& state);
+
+	static void Execute(const RenderCommand& command);
+
+	// std140 layout of the Scene block
+	struct SceneUniforms
+	{
+		glm::mat4 ViewProjection;
+		glm::mat4 View;
+		glm::mat4 Projection;
+		glm::vec4 CameraPosition;
+	};
+
+	// std140 layout of the Object block
+	struct ObjectUniforms
+	{
+		glm::mat4 Transform;
+	};
+
+	// Slots of the object buffer, a frame with more draws reuses them from the first one
+	static constexpr uint32_t kObjectSlotCount = 4096;
+
+	// Writes the transform in the next slot of the object buffer and binds it, unless it is the one bound
+	static void BindObject(const glm::mat4& transform);
+
 	struct SceneData
 	{
 		glm::mat4 ViewProjectionMatrix;
 		glm::mat4 ViewMatrix;
 		glm::mat4 ProjectionMatrix;
+
+		glm::vec3 CameraPosition = glm::vec3(0.f);
+		float ScreenSpaceErrorFactor = 1.f;
+		uint32_t ViewportHeight = 720;
+
+		// Created by the first BeginScene, the GL context does not exist before
+		std::shared_ptr<UniformBuffer> SceneBuffer;
+		std::shared_ptr<UniformBuffer> ObjectBuffer;
+		uint32_t ObjectSlotSize = 0;
+		uint32_t ObjectSlot = 0;
+		bool ObjectBound = false;
+		glm::mat4 BoundTransform = glm::mat4(1.f);
+
+		std::shared_ptr<Texture2DArray> Materials;
+
+		RenderQueue Queue;
+		GLStateCache StateCache;
+		std::vector<TextureBinding> TextureBindings;
+		uint64_t SamplerTextureSet = 0;
+
+		Stats FrameStats;
+		Stats LastStats;
 	};
 
 	static std::unique_ptr<SceneData> s_SceneData;
@@ -49,10 +49,24 @@ void RendererAPI::Clear()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void RendererAPI::DrawIndexed(const std::shared_ptr<VertexArray>& vertexArray, uint32_t indexCount)
+void RendererAPI::DrawIndexed(const IndexBuffer& indexBuffer, uint32_t indexCount)
 {
-	vertexArray->Bind();
-	uint32_t count = indexCount ? indexCount : vertexArray->GetIndexBuffer()->GetCount();
-	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+	uint32_t count = indexCount ? indexCount : indexBuffer.GetCount();
+	glDrawElements(GL_TRIANGLES, count, indexBuffer.GetType(), (const void*)indexBuffer.GetOffset());
 }
 
+void RendererAPI::MultiDrawIndexedIndirect(const IndexBuffer& indexBuffer, uint32_t commandCount)
+{
+	if (commandCount == 0)
+		return;
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, indexBuffer.GetType(), nullptr, static_cast<GLsizei>(commandCount), 0);
+}
+
+void RendererAPI::MultiDrawIndexedIndirectCount(const IndexBuffer& indexBuffer, uint32_t commandCount)
+{
+	if (commandCount == 0)
+		return;
+
+	glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, indexBuffer.GetType(), nullptr, 0, static_cast<GLsizei>(commandCount), 0);
+}
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 
+#include "../Buffer/IndirectBuffer.h"
 #include "../Buffer/VertexArray.h"
 
 class RendererAPI
@@ -12,7 +13,15 @@ public:
 	void SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 	void SetClearColor(const glm::vec4& color);
 	void Clear();
-	void DrawIndexed(const std::shared_ptr<VertexArray>& vertexArray, uint32_t indexCount = 0);
+	// The draws read the bound vertex array, indexBuffer must be its index buffer
+	void DrawIndexed(const IndexBuffer& indexBuffer, uint32_t indexCount = 0);
+
+	// commandCount commands of the bound GL_DRAW_INDIRECT_BUFFER in one call, they index the index buffer
+	void MultiDrawIndexedIndirect(const IndexBuffer& indexBuffer, uint32_t commandCount);
+
+	// Same with the number of commands read from the first uint of the bound GL_PARAMETER_BUFFER
+	// (GL_ARB_indirect_parameters), at most commandCount
+	void MultiDrawIndexedIndirectCount(const IndexBuffer& indexBuffer, uint32_t commandCount);
 
 	static std::shared_ptr<RendererAPI> Get()
 	{
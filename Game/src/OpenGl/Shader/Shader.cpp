@@ -1,5 +1,6 @@
 #include "Shader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -14,6 +15,7 @@ Shader::Shader(const std::string& vertexShaderFilePath, const std::string& fragm
 	const GLuint fragmentShader = CompileShader(fragmentShaderSrc.c_str(), GL_FRAGMENT_SHADER);
 
     shaderProgram = CreateProgram(vertexShader, fragmentShader);
+    ReflectUniforms();
 }
 
 Shader::Shader(const std::string& name, const std::string& vertexShaderString, const std::string& fragmentShaderString): m_name(name)
@@ -22,6 +24,16 @@ Shader::Shader(const std::string& name, const std::string& vertexShaderString, c
     const GLuint fragmentShader = CompileShader(fragmentShaderString.c_str(), GL_FRAGMENT_SHADER);
 
     shaderProgram = CreateProgram(vertexShader, fragmentShader);
+    ReflectUniforms();
+}
+
+Shader::Shader(const std::string& computeShaderFilePath): m_name("")
+{
+    const std::string computeShaderSrc = ReadShaderFile(computeShaderFilePath);
+    const GLuint computeShader = CompileShader(computeShaderSrc.c_str(), GL_COMPUTE_SHADER);
+
+    shaderProgram = CreateProgram(computeShader);
+    ReflectUniforms();
 }
 
 Shader::~Shader() {
@@ -36,9 +48,65 @@ void Shader::Unbind() {
     glUseProgram(0);
 }
 
-GLint Shader::GetUniformLocation(const char* name) const
+void Shader::Dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ)
 {
-    return glGetUniformLocation(shaderProgram, name);
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+GLint Shader::GetUniformLocation(UniformName name) const
+{
+    const auto uniform = std::ranges::lower_bound(m_uniforms, name.GetHash(), {}, &ShaderUniform::hash);
+    return uniform != m_uniforms.end() && uniform->hash == name.GetHash() ? uniform->location : -1;
+}
+
+void Shader::ReflectUniforms()
+{
+    m_uniforms.clear();
+    if (!shaderProgram)
+        return;
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(shaderProgram, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    const auto add = [this](const std::string& name, GLint location, GLenum type)
+    {
+        m_uniforms.push_back({ name, UniformName(name).GetHash(), location, type });
+    };
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        constexpr GLenum properties[] = { GL_NAME_LENGTH, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+        GLint values[std::size(properties)];
+        glGetProgramResourceiv(shaderProgram, GL_UNIFORM, i, static_cast<GLsizei>(std::size(properties)), properties, static_cast<GLsizei>(std::size(values)), nullptr, values);
+
+        // Members of uniform blocks have no location
+        if (values[4] != -1 || values[1] < 0)
+            continue;
+
+        std::string name(values[0], '\0');
+        glGetProgramResourceName(shaderProgram, GL_UNIFORM, i, values[0], nullptr, name.data());
+        name.resize(values[0] - 1);
+
+        const auto type = static_cast<GLenum>(values[2]);
+        add(name, values[1], type);
+
+        if (!name.ends_with("[0]"))
+            continue;
+
+        // The locations of the other elements are not guaranteed to follow the first one
+        const std::string arrayName = name.substr(0, name.size() - 3);
+        add(arrayName, values[1], type);
+        for (GLint element = 1; element < values[3]; ++element)
+        {
+            const std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+            add(elementName, glGetUniformLocation(shaderProgram, elementName.c_str()), type);
+        }
+    }
+
+    std::ranges::sort(m_uniforms, {}, &ShaderUniform::hash);
+    const auto collision = std::ranges::adjacent_find(m_uniforms, {}, &ShaderUniform::hash);
+    if (collision != m_uniforms.end())
+        std::cerr << "Uniform name hash collision: " << collision->name << " and " << std::next(collision)->name << std::endl;
 }
 
 GLuint Shader::CompileShader(const char* src, GLenum shaderType) {
@@ -93,6 +161,31 @@ GLuint Shader::CreateProgram(GLuint vertexShader, GLuint fragmentShader)
     return shaderProgram;
 }
 
+GLuint Shader::CreateProgram(GLuint computeShader)
+{
+    GLuint shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, computeShader);
+    glLinkProgram(shaderProgram);
+
+    GLint success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+
+        GLsizei length;
+        glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &length);
+        std::string log(length + 1, '\0');
+
+        glGetProgramInfoLog(shaderProgram, length, &length, log.data());
+        std::cerr << "Compute shader program linking failed: " << log << std::endl;
+
+        return 0;
+    }
+
+    glDeleteShader(computeShader);
+
+    return shaderProgram;
+}
+
 std::string Shader::ReadShaderFile(const std::string& filePath)
 {
     std::string result;
@@ -114,44 +207,49 @@ std::string Shader::ReadShaderFile(const std::string& filePath)
     return result;
 }
 
-void Shader::SetInt(const std::string& name, int value)
+void Shader::SetInt(UniformName name, int value)
+{
+    glUniform1i(GetUniformLocation(name), value);
+}
+
+void Shader::SetInt2(UniformName name, const glm::ivec2& value)
 {
-    glUniform1i(GetUniformLocation(name.c_str()), value);
+    glUniform2i(GetUniformLocation(name), value.x, value.y);
 }
 
-void Shader::SetIntArray(const std::string& name, int* values, uint32_t count)
+void Shader::SetIntArray(UniformName name, int* values, uint32_t count)
 {
-    glUniform1iv(GetUniformLocation(name.c_str()), count, values);
+    glUniform1iv(GetUniformLocation(name), count, values);
 }
 
-void Shader::SetFloat(const std::string& name, float value)
+void Shader::SetFloat(UniformName name, float value)
 {
-    glUniform1f(GetUniformLocation(name.c_str()), value);
+    glUniform1f(GetUniformLocation(name), value);
 }
 
-void Shader::SetFloat2(const std::string& name, const glm::vec2& value)
+void Shader::SetFloat2(UniformName name, const glm::vec2& value)
 {
-    glUniform2f(GetUniformLocation(name.c_str()), value.x, value.y);
+    glUniform2f(GetUniformLocation(name), value.x, value.y);
 }
 
-void Shader::SetFloat3(const std::string& name, const glm::vec3& value)
+void Shader::SetFloat3(UniformName name, const glm::vec3& value)
 {
-    glUniform3f(GetUniformLocation(name.c_str()), value.x, value.y, value.z);
+    glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
 }
 
-void Shader::SetFloat4(const std::string& name, const glm::vec4& value)
+void Shader::SetFloat4(UniformName name, const glm::vec4& value)
 {
-    glUniform4f(GetUniformLocation(name.c_str()), value.x, value.y, value.z, value.w);
+    glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
 
-void Shader::SetMat3(const std::string& name, const glm::mat3& matrix)
+void Shader::SetMat3(UniformName name, const glm::mat3& matrix)
 {
-    glUniformMatrix3fv(GetUniformLocation(name.c_str()), 1, GL_FALSE, glm::value_ptr(matrix));
+    glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
-void Shader::SetMat4(const std::string& name, const glm::mat4& matrix)
+void Shader::SetMat4(UniformName name, const glm::mat4& matrix)
 {
-    glUniformMatrix4fv(GetUniformLocation(name.c_str()), 1, GL_FALSE, glm::value_ptr(matrix));
+    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
 // Shader library
@@ -180,6 +278,13 @@ std::shared_ptr<Shader> ShaderLibrary::Get(const std::string& name)
     return m_Shaders[name];
 }
 
+std::shared_ptr<Shader> ShaderLibrary::LoadCompute(const std::string& name, const std::string& computeShaderFilePath)
+{
+    auto shader = Shader::CreateCompute(computeShaderFilePath);
+    Add(name, shader);
+    return shader;
+}
+
 bool ShaderLibrary::Exists(const std::string& name) const
 {
     return m_Shaders.find(name) != m_Shaders.end();
@@ -2,33 +2,53 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/fwd.hpp>
 
+#include "UniformName.h"
+
+// Active uniform of a linked program. Every element of an array has its own entry, the first one also
+// goes by the name without [0]
+struct ShaderUniform
+{
+    std::string name;
+    uint64_t hash;
+    GLint location;
+    GLenum type;
+};
+
 class Shader {
 public:
     Shader(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
     Shader(const std::string& name, const std::string& vertexShaderString, const std::string& fragmentShaderString);
+    explicit Shader(const std::string& computeShaderFilePath);
     ~Shader();
 
     void Bind();
     void Unbind();
 
-    void SetInt(const std::string& name, int value);
+    // Only valid for compute shaders, the program must be bound
+    void Dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ = 1);
 
-    void SetIntArray(const std::string& name, int* values, uint32_t count);
+    // The setters look the location up in the table built at link time, unknown names are ignored like by GL
+    void SetInt(UniformName name, int value);
 
-    void SetFloat(const std::string& name, float value);
+    void SetInt2(UniformName name, const glm::ivec2& value);
 
-    void SetFloat2(const std::string& name, const glm::vec2& value);
+    void SetIntArray(UniformName name, int* values, uint32_t count);
 
-    void SetFloat3(const std::string& name, const glm::vec3& value);
+    void SetFloat(UniformName name, float value);
 
-    void SetFloat4(const std::string& name, const glm::vec4& value);
+    void SetFloat2(UniformName name, const glm::vec2& value);
 
-    void SetMat3(const std::string& name, const glm::mat3& matrix);
+    void SetFloat3(UniformName name, const glm::vec3& value);
 
-    void SetMat4(const std::string& name, const glm::mat4& matrix);
+    void SetFloat4(UniformName name, const glm::vec4& value);
+
+    void SetMat3(UniformName name, const glm::mat3& matrix);
+
+    void SetMat4(UniformName name, const glm::mat4& matrix);
 
     static std::shared_ptr<Shader> Create(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
     {
@@ -40,6 +60,19 @@ public:
         return std::make_shared<Shader>(name, vertexShaderFilePath, fragmentShaderFilePath);
     }
 
+    static std::shared_ptr<Shader> CreateCompute(const std::string& computeShaderFilePath)
+    {
+        return std::make_shared<Shader>(computeShaderFilePath);
+    }
+
+    // -1 when the program has no such active uniform
+    [[nodiscard]] GLint GetUniformLocation(UniformName name) const;
+
+    // Sorted by hash
+    [[nodiscard]] const std::vector<ShaderUniform>& GetUniforms() const { return m_uniforms; }
+
+    [[nodiscard]] GLuint GetRendererID() const { return shaderProgram; }
+
     std::string m_name;
 
 private:
@@ -47,12 +80,17 @@ private:
 
     GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader);
 
+    GLuint CreateProgram(GLuint computeShader);
+
     std::string ReadShaderFile(const std::string& filePath);
 
-    GLint GetUniformLocation(const char* name) const;
+    // Fills m_uniforms from the active uniforms of the program
+    void ReflectUniforms();
 
     GLuint shaderProgram;
 
+    std::vector<ShaderUniform> m_uniforms;
+
 };
 
 class ShaderLibrary
@@ -64,6 +102,8 @@ public:
     std::shared_ptr<Shader> Load(const std::string& name, const std::string& vertexShaderFilePath,
                                  const std::string& fragmentShaderFilePath);
 
+    std::shared_ptr<Shader> LoadCompute(const std::string& name, const std::string& computeShaderFilePath);
+
     std::shared_ptr<Shader> Get(const std::string& name);
 
     bool Exists(const std::string& name) const;
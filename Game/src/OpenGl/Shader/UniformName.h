@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../../Utils/Hash.h"
+
+// Hash of a uniform name, the key of the uniform table of a Shader. Hashed at compile time when declared
+// constexpr, keep one around for the names set on every draw.
+class UniformName
+{
+public:
+    constexpr UniformName(const char* name) : m_hash(Hash::Fnv1a(std::string_view(name))) {}
+    constexpr UniformName(std::string_view name) : m_hash(Hash::Fnv1a(name)) {}
+    UniformName(const std::string& name) : m_hash(Hash::Fnv1a(name)) {}
+
+    [[nodiscard]] constexpr uint64_t GetHash() const { return m_hash; }
+
+private:
+    uint64_t m_hash;
+};
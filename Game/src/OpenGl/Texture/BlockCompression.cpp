@@ -0,0 +1,275 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+#include "../../JobSystem/JobSystem.h"
+
+namespace
+{
+	constexpr uint32_t kBlockRowsPerJob = 4;
+
+	// BC7 weights of the 4 bit indices
+	constexpr std::array<int, 16> kBc7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint16_t ToRgb565(const int* color)
+	{
+		const int r = std::clamp((color[0] * 31 + 127) / 255, 0, 31);
+		const int g = std::clamp((color[1] * 63 + 127) / 255, 0, 63);
+		const int b = std::clamp((color[2] * 31 + 127) / 255, 0, 31);
+		return static_cast<uint16_t>(r << 11 | g << 5 | b);
+	}
+
+	void FromRgb565(uint16_t color, int* rgb)
+	{
+		const int r = color >> 11 & 31;
+		const int g = color >> 5 & 63;
+		const int b = color & 31;
+		rgb[0] = r << 3 | r >> 2;
+		rgb[1] = g << 2 | g >> 4;
+		rgb[2] = b << 3 | b >> 2;
+	}
+
+	// Writes the bits of a BC7 block from the least significant one
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* block) : m_block(block) { std::memset(block, 0, 16); }
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; ++i, ++m_position)
+			{
+				if (value >> i & 1)
+					m_block[m_position / 8] |= static_cast<uint8_t>(1 << (m_position % 8));
+			}
+		}
+
+	private:
+		uint8_t* m_block;
+		uint32_t m_position = 0;
+	};
+}
+
+GLenum BlockCompression::GetInternalFormat(TextureCompression compression)
+{
+	return compression == TextureCompression::BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_BPTC_UNORM;
+}
+
+size_t BlockCompression::GetBlockSize(TextureCompression compression)
+{
+	return compression == TextureCompression::BC1 ? 8 : 16;
+}
+
+size_t BlockCompression::GetImageSize(TextureCompression compression, uint32_t width, uint32_t height)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(compression);
+}
+
+void BlockCompression::EncodeBc1Block(const uint8_t* texels, uint8_t* block)
+{
+	// Endpoints at the corners of the color bounding box, inset by 1/16 against outliers
+	int low[3] = { 255, 255, 255 };
+	int high[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			low[c] = std::min<int>(low[c], texels[i * 4 + c]);
+			high[c] = std::max<int>(high[c], texels[i * 4 + c]);
+		}
+	}
+
+	for (int c = 0; c < 3; ++c)
+	{
+		const int inset = (high[c] - low[c]) / 16;
+		low[c] += inset;
+		high[c] -= inset;
+	}
+
+	uint16_t color0 = ToRgb565(high);
+	uint16_t color1 = ToRgb565(low);
+
+	// Four color mode needs color0 > color1, equal endpoints only use index 0
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	int palette[4][3];
+	FromRgb565(color0, palette[0]);
+	FromRgb565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int bestIndex = 0;
+			int bestError = std::numeric_limits<int>::max();
+			for (int p = 0; p < 4; ++p)
+			{
+				int error = 0;
+				for (int c = 0; c < 3; ++c)
+				{
+					const int difference = texels[i * 4 + c] - palette[p][c];
+					error += difference * difference;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+		}
+	}
+
+	block[0] = static_cast<uint8_t>(color0);
+	block[1] = static_cast<uint8_t>(color0 >> 8);
+	block[2] = static_cast<uint8_t>(color1);
+	block[3] = static_cast<uint8_t>(color1 >> 8);
+	for (int i = 0; i < 4; ++i)
+		block[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+void BlockCompression::EncodeBc7Block(const uint8_t* texels, uint8_t* block)
+{
+	int low[4] = { 255, 255, 255, 255 };
+	int high[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			low[c] = std::min<int>(low[c], texels[i * 4 + c]);
+			high[c] = std::max<int>(high[c], texels[i * 4 + c]);
+		}
+	}
+
+	// Mode 6 endpoints are 7 bits per channel plus a p-bit shared by the channels of the endpoint
+	int quantized[2][4];
+	int pBits[2];
+	int endpoints[2][4];
+	const int* targets[2] = { low, high };
+	for (int e = 0; e < 2; ++e)
+	{
+		int bestError = std::numeric_limits<int>::max();
+		for (int p = 0; p < 2; ++p)
+		{
+			int error = 0;
+			int values[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				values[c] = std::clamp((targets[e][c] - p + 1) / 2, 0, 127);
+				const int difference = (values[c] << 1 | p) - targets[e][c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBits[e] = p;
+				for (int c = 0; c < 4; ++c)
+				{
+					quantized[e][c] = values[c];
+					endpoints[e][c] = values[c] << 1 | p;
+				}
+			}
+		}
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; ++i)
+	{
+		int bestError = std::numeric_limits<int>::max();
+		for (int index = 0; index < 16; ++index)
+		{
+			const int weight = kBc7Weights[index];
+			int error = 0;
+			for (int c = 0; c < 4; ++c)
+			{
+				const int value = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+				const int difference = texels[i * 4 + c] - value;
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				indices[i] = index;
+			}
+		}
+	}
+
+	// The most significant bit of the first index is implicit and 0, swapping the endpoints clears it
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (int& index : indices)
+			index = 15 - index;
+	}
+
+	BitWriter writer(block);
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.Write(quantized[0][c], 7);
+		writer.Write(quantized[1][c], 7);
+	}
+	writer.Write(pBits[0], 1);
+	writer.Write(pBits[1], 1);
+
+	writer.Write(indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		writer.Write(indices[i], 4);
+}
+
+std::vector<uint8_t> BlockCompression::Encode(TextureCompression compression, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const size_t blockSize = GetBlockSize(compression);
+	std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+	const auto encodeRow = [&](uint32_t blockY)
+	{
+		uint8_t texels[16 * 4];
+		for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+		{
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+					std::memcpy(&texels[(y * 4 + x) * 4], &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * 4], 4);
+				}
+			}
+
+			uint8_t* block = &blocks[(static_cast<size_t>(blockY) * blocksX + blockX) * blockSize];
+			if (compression == TextureCompression::BC1)
+				EncodeBc1Block(texels, block);
+			else
+				EncodeBc7Block(texels, block);
+		}
+	};
+
+	if (blocksY <= kBlockRowsPerJob)
+	{
+		for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+			encodeRow(blockY);
+		return blocks;
+	}
+
+	JobCounter counter;
+	JobSystem::Get().Dispatch(blocksY, kBlockRowsPerJob, encodeRow, counter);
+	JobSystem::Get().Wait(counter);
+	return blocks;
+}
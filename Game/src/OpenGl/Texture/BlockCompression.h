@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+enum class TextureCompression : uint32_t
+{
+	// 4 bits per texel, opaque RGB
+	BC1,
+	// 8 bits per texel, RGBA
+	BC7,
+};
+
+// CPU encoders of the 4x4 blocks sampled by the GPU. Quality is traded for speed: BC1 fits the bounding
+// box of the block colors, BC7 only uses mode 6 (one RGBA subset, 4 bit indices).
+namespace BlockCompression
+{
+	[[nodiscard]] GLenum GetInternalFormat(TextureCompression compression);
+	[[nodiscard]] size_t GetBlockSize(TextureCompression compression);
+
+	// Bytes of a width x height image, the edge blocks are padded
+	[[nodiscard]] size_t GetImageSize(TextureCompression compression, uint32_t width, uint32_t height);
+
+	// texels are the 16 RGBA8 texels of the block, row by row
+	void EncodeBc1Block(const uint8_t* texels, uint8_t* block);
+	void EncodeBc7Block(const uint8_t* texels, uint8_t* block);
+
+	// RGBA8 image to blocks, the texels past the edges repeat the last row and column. Rows of blocks
+	// are encoded on the job system
+	[[nodiscard]] std::vector<uint8_t> Encode(TextureCompression compression, const uint8_t* pixels, uint32_t width, uint32_t height);
+}
@@ -0,0 +1,101 @@
+#include "HiZBuffer.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t kWorkGroupSize = 8;
+
+	uint32_t GroupCount(int size)
+	{
+		return (static_cast<uint32_t>(size) + kWorkGroupSize - 1) / kWorkGroupSize;
+	}
+}
+
+HiZBuffer::HiZBuffer(const std::shared_ptr<Shader>& reduceShader): m_shader(reduceShader)
+{
+}
+
+HiZBuffer::~HiZBuffer()
+{
+	Release();
+}
+
+void HiZBuffer::Build(const glm::mat4& viewProjection)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	const glm::ivec2 size(viewport[2], viewport[3]);
+	if (size.x <= 0 || size.y <= 0)
+		return;
+
+	if (size != m_size)
+		Resize(size);
+
+	// Depth of the read framebuffer, converted to the texture format by the copy
+	glCopyTextureSubImage2D(m_depth, 0, 0, 0, viewport[0], viewport[1], size.x, size.y);
+
+	m_shader->Bind();
+	m_shader->SetInt("u_Depth", 0);
+	glBindTextureUnit(0, m_depth);
+
+	glm::ivec2 sourceSize = size;
+	for (int level = 0; level < m_levelCount; ++level)
+	{
+		// Level 0 copies the depth texture, the others reduce the previous level
+		const glm::ivec2 levelSize = level == 0 ? size : glm::max(sourceSize / 2, glm::ivec2(1));
+		m_shader->SetInt("u_Level", level);
+		m_shader->SetInt2("u_SourceSize", sourceSize);
+		m_shader->SetInt2("u_LevelSize", levelSize);
+		if (level > 0)
+			glBindImageTexture(0, m_pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		m_shader->Dispatch(GroupCount(levelSize.x), GroupCount(levelSize.y));
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		sourceSize = levelSize;
+	}
+
+	// Sampled by the culling shader next
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	m_viewProjection = viewProjection;
+	m_valid = true;
+}
+
+void HiZBuffer::Resize(glm::ivec2 size)
+{
+	Release();
+
+	m_size = size;
+	m_levelCount = 1;
+	while ((std::max(size.x, size.y) >> m_levelCount) > 0)
+		++m_levelCount;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depth);
+	glTextureStorage2D(m_depth, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+	glTextureParameteri(m_depth, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depth, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depth, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_pyramid);
+	glTextureStorage2D(m_pyramid, m_levelCount, GL_R32F, size.x, size.y);
+	glTextureParameteri(m_pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTextureParameteri(m_pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void HiZBuffer::Release()
+{
+	if (m_depth)
+		glDeleteTextures(1, &m_depth);
+	if (m_pyramid)
+		glDeleteTextures(1, &m_pyramid);
+
+	m_depth = 0;
+	m_pyramid = 0;
+	m_size = glm::ivec2(0);
+	m_levelCount = 0;
+	m_valid = false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "../Shader/Shader.h"
+
+// Hierarchical depth: a R32F mip chain whose texels hold the farthest depth of the texels they cover
+// at level 0, built from the depth buffer of the bound framebuffer by a reduction compute shader.
+// Odd sizes fold their last row and column into the previous texel, so every level stays conservative.
+// Must be used from the thread owning the GL context.
+class HiZBuffer
+{
+public:
+	explicit HiZBuffer(const std::shared_ptr<Shader>& reduceShader);
+	~HiZBuffer();
+
+	HiZBuffer(const HiZBuffer&) = delete;
+	HiZBuffer& operator=(const HiZBuffer&) = delete;
+
+	// Copies the depth of the current viewport, viewProjection is the matrix the depth was rendered with
+	void Build(const glm::mat4& viewProjection);
+
+	// Dropped when the depth no longer matches the scene, the next Build makes it valid again
+	void Invalidate() { m_valid = false; }
+
+	[[nodiscard]] bool IsValid() const { return m_valid; }
+
+	[[nodiscard]] GLuint GetRendererID() const { return m_pyramid; }
+	[[nodiscard]] glm::ivec2 GetSize() const { return m_size; }
+	[[nodiscard]] int GetLevelCount() const { return m_levelCount; }
+	[[nodiscard]] const glm::mat4& GetViewProjection() const { return m_viewProjection; }
+
+	static std::shared_ptr<HiZBuffer> Create(const std::shared_ptr<Shader>& reduceShader)
+	{
+		return std::make_shared<HiZBuffer>(reduceShader);
+	}
+
+private:
+	void Resize(glm::ivec2 size);
+	void Release();
+
+	std::shared_ptr<Shader> m_shader;
+
+	GLuint m_depth = 0;
+	GLuint m_pyramid = 0;
+	glm::ivec2 m_size = glm::ivec2(0);
+	int m_levelCount = 0;
+
+	glm::mat4 m_viewProjection = glm::mat4(1.f);
+	bool m_valid = false;
+};
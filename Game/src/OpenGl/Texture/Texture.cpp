@@ -21,6 +21,7 @@ Texture2D::Texture2D(uint32_t width, uint32_t height) : m_Width(width), m_Height
 
 Texture2D::Texture2D(const std::string& name, const std::string& path)
 	: m_Name(name)
+	, m_UniformName(name)
     , m_Path(path)
 {
 	int width, height, channels;
@@ -3,6 +3,8 @@
 #include <string>
 #include <gl/glew.h>
 
+#include "../Shader/UniformName.h"
+
 class Texture
 {
 public:
@@ -36,6 +38,8 @@ public:
 
 	const std::string& GetPath() const override { return m_Path; }
     const std::string& GetName() const { return m_Name; }
+	// Sampler uniform the texture is bound to, hashed once
+	const UniformName& GetUniformName() const { return m_UniformName; }
 
 	void SetData(void* data, uint32_t size) override;
 
@@ -59,6 +63,7 @@ public:
 
 private:
     std::string m_Name;
+	UniformName m_UniformName = "";
 	std::string m_Path;
 	bool m_IsLoaded = false;
 	uint32_t m_Width, m_Height;
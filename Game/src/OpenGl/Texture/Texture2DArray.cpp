@@ -0,0 +1,87 @@
+#include "Texture2DArray.h"
+
+#include <algorithm>
+
+#include "TextureCache.h"
+
+namespace
+{
+	constexpr float kMaxAnisotropy = 16.f;
+}
+
+Texture2DArray::Texture2DArray(const std::vector<TextureLayerDesc>& layers, uint32_t width, uint32_t height, TextureCompression compression)
+	: m_width(width), m_height(height), m_levelCount(TextureCache::GetLevelCount(width, height)), m_compression(compression)
+{
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_rendererID);
+	glTextureStorage3D(m_rendererID, static_cast<GLsizei>(m_levelCount), BlockCompression::GetInternalFormat(m_compression), m_width, m_height, static_cast<GLsizei>(std::max<size_t>(layers.size(), 1)));
+
+	// One block repeated, cheap enough for the first frame
+	for (size_t i = 0; i < layers.size(); ++i)
+	{
+		m_layers.push_back({ layers[i] });
+		SetLayer(static_cast<uint32_t>(i), TextureCache::CreateSolid(layers[i].fallbackColor, m_width, m_height, m_compression));
+	}
+
+	glTextureParameteri(m_rendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(m_rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(m_rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(m_rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// Core since 4.6, the terrain is mostly seen at grazing angles
+	GLfloat maxAnisotropy = 1.f;
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+	glTextureParameterf(m_rendererID, GL_TEXTURE_MAX_ANISOTROPY, std::min(maxAnisotropy, kMaxAnisotropy));
+}
+
+Texture2DArray::~Texture2DArray()
+{
+	glDeleteTextures(1, &m_rendererID);
+}
+
+void Texture2DArray::Bind(uint32_t slot) const
+{
+	glBindTextureUnit(slot, m_rendererID);
+}
+
+void Texture2DArray::SetLayer(uint32_t layer, const CompressedImage& image)
+{
+	for (uint32_t level = 0; level < m_levelCount && level < image.levels.size(); ++level)
+	{
+		const std::span<const uint8_t> blocks = image.levels[level];
+		glCompressedTextureSubImage3D(m_rendererID, static_cast<GLint>(level), 0, 0, static_cast<GLint>(layer),
+			static_cast<GLsizei>(std::max(m_width >> level, 1u)), static_cast<GLsizei>(std::max(m_height >> level, 1u)), 1,
+			BlockCompression::GetInternalFormat(m_compression), static_cast<GLsizei>(blocks.size()), blocks.data());
+	}
+}
+
+int Texture2DArray::GetLayerIndex(const std::string& name) const
+{
+	const auto layer = std::ranges::find(m_layers, name, [](const Layer& layer) -> const std::string& { return layer.desc.name; });
+	return layer != m_layers.end() ? static_cast<int>(layer - m_layers.begin()) : -1;
+}
+
+TextureCompression Texture2DArray::SelectCompression(const std::vector<TextureLayerDesc>& layers)
+{
+	for (const TextureLayerDesc& layer : layers)
+	{
+		uint32_t width, height;
+		bool hasAlpha = false;
+		if (layer.fallbackColor.a != 255 || (TextureCache::GetSourceInfo(layer.path, width, height, hasAlpha) && hasAlpha))
+			return TextureCompression::BC7;
+	}
+
+	return TextureCompression::BC1;
+}
+
+uint32_t Texture2DArray::GetLayerCount(LayerState state) const
+{
+	return static_cast<uint32_t>(std::ranges::count(m_layers, state, &Layer::state));
+}
+
+size_t Texture2DArray::GetLayerSize() const
+{
+	size_t size = 0;
+	for (uint32_t level = 0; level < m_levelCount; ++level)
+		size += BlockCompression::GetImageSize(m_compression, std::max(m_width >> level, 1u), std::max(m_height >> level, 1u));
+	return size;
+}
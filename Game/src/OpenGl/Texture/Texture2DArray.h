@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "BlockCompression.h"
+
+struct CompressedImage;
+
+// Layer of a Texture2DArray loaded from an image, filled with its fallback color until the image is resident
+// or when it cannot be read. Layers of higher priority are loaded first
+struct TextureLayerDesc
+{
+	std::string name;
+	std::string path;
+	glm::u8vec4 fallbackColor = glm::u8vec4(255, 0, 255, 255);
+	int priority = 0;
+};
+
+// Block compressed 2D texture array with a full mip chain, trilinear and anisotropic filtering, repeated. Created
+// with every layer at its fallback color, the images are loaded afterwards (see TextureStreamer) and resized to
+// the size of the array, so materials of any size share one binding.
+// Must be used from the thread owning the GL context.
+class Texture2DArray
+{
+public:
+	enum class LayerState : uint8_t
+	{
+		Placeholder,
+		Resident,
+		Missing,
+	};
+
+	Texture2DArray(const std::vector<TextureLayerDesc>& layers, uint32_t width, uint32_t height, TextureCompression compression);
+	~Texture2DArray();
+
+	Texture2DArray(const Texture2DArray&) = delete;
+	Texture2DArray& operator=(const Texture2DArray&) = delete;
+
+	void Bind(uint32_t slot = 0) const;
+
+	// Uploads every level of a layer from client memory, the image must match the array
+	void SetLayer(uint32_t layer, const CompressedImage& image);
+
+	void SetLayerState(uint32_t layer, LayerState state) { m_layers[layer].state = state; }
+
+	[[nodiscard]] GLuint GetRendererID() const { return m_rendererID; }
+	[[nodiscard]] uint32_t GetWidth() const { return m_width; }
+	[[nodiscard]] uint32_t GetHeight() const { return m_height; }
+	[[nodiscard]] uint32_t GetLayerCount() const { return static_cast<uint32_t>(m_layers.size()); }
+	[[nodiscard]] uint32_t GetLevelCount() const { return m_levelCount; }
+	[[nodiscard]] TextureCompression GetCompression() const { return m_compression; }
+	[[nodiscard]] const TextureLayerDesc& GetLayerDesc(uint32_t layer) const { return m_layers[layer].desc; }
+	[[nodiscard]] LayerState GetLayerState(uint32_t layer) const { return m_layers[layer].state; }
+
+	// -1 when no layer has this name
+	[[nodiscard]] int GetLayerIndex(const std::string& name) const;
+
+	[[nodiscard]] uint32_t GetLayerCount(LayerState state) const;
+
+	// Compressed, of every level of a layer
+	[[nodiscard]] size_t GetLayerSize() const;
+
+	// Of every layer
+	[[nodiscard]] size_t GetMemorySize() const { return GetLayerSize() * m_layers.size(); }
+
+	// BC7 when an image or a fallback color of the layers has alpha, BC1 otherwise. Only reads the image headers,
+	// missing images count as opaque
+	static TextureCompression SelectCompression(const std::vector<TextureLayerDesc>& layers);
+
+	static std::shared_ptr<Texture2DArray> Create(const std::vector<TextureLayerDesc>& layers, uint32_t width, uint32_t height, TextureCompression compression)
+	{
+		return std::make_shared<Texture2DArray>(layers, width, height, compression);
+	}
+
+private:
+	struct Layer
+	{
+		TextureLayerDesc desc;
+		LayerState state = LayerState::Placeholder;
+	};
+
+	GLuint m_rendererID = 0;
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	uint32_t m_levelCount = 0;
+	TextureCompression m_compression = TextureCompression::BC1;
+	std::vector<Layer> m_layers;
+};
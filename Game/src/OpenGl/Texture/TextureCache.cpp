@@ -0,0 +1,307 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <stb_image.h>
+
+#include "../../Utils/Hash.h"
+#include "../../Utils/MappedFile.h"
+
+namespace
+{
+	constexpr char kMagic[4] = { 'T', 'X', 'C', 'B' };
+
+	float MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Bilinear, RGBA8
+	std::vector<uint8_t> Resize(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t newWidth, uint32_t newHeight)
+	{
+		std::vector<uint8_t> result(static_cast<size_t>(newWidth) * newHeight * 4);
+		for (uint32_t y = 0; y < newHeight; ++y)
+		{
+			// Texel centers of the result mapped on the source
+			const float sourceY = std::clamp((y + 0.5f) * height / newHeight - 0.5f, 0.f, static_cast<float>(height - 1));
+			const auto y0 = static_cast<uint32_t>(sourceY);
+			const uint32_t y1 = std::min(y0 + 1, height - 1);
+			const float ty = sourceY - y0;
+
+			for (uint32_t x = 0; x < newWidth; ++x)
+			{
+				const float sourceX = std::clamp((x + 0.5f) * width / newWidth - 0.5f, 0.f, static_cast<float>(width - 1));
+				const auto x0 = static_cast<uint32_t>(sourceX);
+				const uint32_t x1 = std::min(x0 + 1, width - 1);
+				const float tx = sourceX - x0;
+
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const float top = pixels[(y0 * width + x0) * 4 + c] * (1.f - tx) + pixels[(y0 * width + x1) * 4 + c] * tx;
+					const float bottom = pixels[(y1 * width + x0) * 4 + c] * (1.f - tx) + pixels[(y1 * width + x1) * 4 + c] * tx;
+					result[(static_cast<size_t>(y) * newWidth + x) * 4 + c] = static_cast<uint8_t>(std::lround(top * (1.f - ty) + bottom * ty));
+				}
+			}
+		}
+		return result;
+	}
+
+	// Next level of a mip chain, the average of 2x2 texels. The last row and column of odd sizes are reused
+	std::vector<uint8_t> Downsample(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+	{
+		const uint32_t newWidth = std::max(width / 2, 1u);
+		const uint32_t newHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> result(static_cast<size_t>(newWidth) * newHeight * 4);
+		for (uint32_t y = 0; y < newHeight; ++y)
+		{
+			const uint32_t y0 = std::min(y * 2, height - 1);
+			const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+			for (uint32_t x = 0; x < newWidth; ++x)
+			{
+				const uint32_t x0 = std::min(x * 2, width - 1);
+				const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const uint32_t sum = pixels[(static_cast<size_t>(y0) * width + x0) * 4 + c] + pixels[(static_cast<size_t>(y0) * width + x1) * 4 + c]
+						+ pixels[(static_cast<size_t>(y1) * width + x0) * 4 + c] + pixels[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+					result[(static_cast<size_t>(y) * newWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+}
+
+size_t CompressedImage::GetSize() const
+{
+	size_t size = 0;
+	for (const auto& level : levels)
+		size += level.size();
+	return size;
+}
+
+TextureCache::TextureCache(std::filesystem::path directory) : m_directory(std::move(directory))
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+}
+
+TextureCache& TextureCache::Get()
+{
+	static TextureCache instance("./cache/textures");
+	return instance;
+}
+
+std::vector<uint8_t> TextureCache::ReadSource(const std::string& path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file)
+		return {};
+
+	return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+bool TextureCache::GetSourceInfo(std::span<const uint8_t> source, uint32_t& width, uint32_t& height, bool& hasAlpha)
+{
+	int x, y, channels;
+	if (source.empty() || !stbi_info_from_memory(source.data(), static_cast<int>(source.size()), &x, &y, &channels))
+		return false;
+
+	width = static_cast<uint32_t>(x);
+	height = static_cast<uint32_t>(y);
+	hasAlpha = channels == 2 || channels == 4;
+	return true;
+}
+
+bool TextureCache::GetSourceInfo(const std::string& path, uint32_t& width, uint32_t& height, bool& hasAlpha)
+{
+	int x, y, channels;
+	if (!stbi_info(path.c_str(), &x, &y, &channels))
+		return false;
+
+	width = static_cast<uint32_t>(x);
+	height = static_cast<uint32_t>(y);
+	hasAlpha = channels == 2 || channels == 4;
+	return true;
+}
+
+CompressedImage TextureCache::Load(std::span<const uint8_t> source, uint32_t width, uint32_t height, TextureCompression compression)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	uint64_t key = Hash::Fnv1a(source.data(), source.size());
+	key = Hash::Combine(key, width);
+	key = Hash::Combine(key, height);
+	key = Hash::Combine(key, compression);
+	key = Hash::Combine(key, kVersion);
+
+	std::ostringstream name;
+	name << std::hex << key << ".txc";
+	const std::filesystem::path path = m_directory / name.str();
+
+	if (CompressedImage image = Read(path, key))
+	{
+		std::lock_guard lock(m_mutex);
+		++m_stats.hitCount;
+		m_stats.loadMilliseconds += MillisecondsSince(start);
+		return image;
+	}
+
+	// Same orientation as the uncompressed textures
+	int sourceWidth, sourceHeight, channels;
+	stbi_set_flip_vertically_on_load_thread(1);
+	stbi_uc* decoded = stbi_load_from_memory(source.data(), static_cast<int>(source.size()), &sourceWidth, &sourceHeight, &channels, 4);
+	if (!decoded)
+		return {};
+
+	std::vector<uint8_t> pixels;
+	if (static_cast<uint32_t>(sourceWidth) == width && static_cast<uint32_t>(sourceHeight) == height)
+		pixels.assign(decoded, decoded + static_cast<size_t>(width) * height * 4);
+	else
+		pixels = Resize(decoded, sourceWidth, sourceHeight, width, height);
+	stbi_image_free(decoded);
+
+	CompressedImage image;
+	const auto file = Encode(pixels, key, width, height, compression, image);
+
+	// Written next to its final name first, a concurrent reader never sees half a file
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	{
+		std::ofstream output(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		output.write(reinterpret_cast<const char*>(file->data()), static_cast<std::streamsize>(file->size()));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::cerr << "Failed to write texture cache file: " << path << std::endl;
+		std::filesystem::remove(temporaryPath, error);
+	}
+
+	std::lock_guard lock(m_mutex);
+	++m_stats.missCount;
+	m_stats.encodeMilliseconds += MillisecondsSince(start);
+	return image;
+}
+
+CompressedImage TextureCache::CreateSolid(const glm::u8vec4& color, uint32_t width, uint32_t height, TextureCompression compression)
+{
+	uint8_t texels[16 * 4];
+	for (int i = 0; i < 16 * 4; ++i)
+		texels[i] = color[i % 4];
+
+	const size_t blockSize = BlockCompression::GetBlockSize(compression);
+	uint8_t block[16];
+	if (compression == TextureCompression::BC1)
+		BlockCompression::EncodeBc1Block(texels, block);
+	else
+		BlockCompression::EncodeBc7Block(texels, block);
+
+	// Level 0 is the largest, the others are its first blocks
+	const size_t blockCount = BlockCompression::GetImageSize(compression, width, height) / blockSize;
+	auto blocks = std::make_shared<std::vector<uint8_t>>(blockCount * blockSize);
+	for (size_t i = 0; i < blockCount; ++i)
+		std::memcpy(blocks->data() + i * blockSize, block, blockSize);
+
+	CompressedImage image{ compression, width, height, {}, blocks };
+	for (uint32_t level = 0; level < GetLevelCount(width, height); ++level)
+	{
+		const size_t size = BlockCompression::GetImageSize(compression, std::max(width >> level, 1u), std::max(height >> level, 1u));
+		image.levels.emplace_back(blocks->data(), size);
+	}
+	return image;
+}
+
+uint32_t TextureCache::GetLevelCount(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+}
+
+TextureCache::Stats TextureCache::GetStats() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_stats;
+}
+
+CompressedImage TextureCache::Read(const std::filesystem::path& path, uint64_t key)
+{
+	auto file = std::make_shared<MappedFile>(path);
+	if (!*file || file->GetSize() < sizeof(Header))
+		return {};
+
+	Header header;
+	std::memcpy(&header, file->GetData(), sizeof(Header));
+	if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.key != key
+		|| header.levelCount != GetLevelCount(header.width, header.height))
+		return {};
+
+	const size_t rangesEnd = sizeof(Header) + header.levelCount * sizeof(LevelRange);
+	if (file->GetSize() < rangesEnd)
+		return {};
+
+	CompressedImage image{ static_cast<TextureCompression>(header.compression), header.width, header.height, {}, file };
+	for (uint32_t level = 0; level < header.levelCount; ++level)
+	{
+		LevelRange range;
+		std::memcpy(&range, file->GetData() + sizeof(Header) + level * sizeof(LevelRange), sizeof(LevelRange));
+
+		const size_t expectedSize = BlockCompression::GetImageSize(image.compression, std::max(header.width >> level, 1u), std::max(header.height >> level, 1u));
+		if (range.size != expectedSize || range.offset < rangesEnd || range.offset + range.size > file->GetSize())
+			return {};
+
+		image.levels.emplace_back(file->GetData() + range.offset, range.size);
+	}
+	return image;
+}
+
+std::shared_ptr<std::vector<uint8_t>> TextureCache::Encode(const std::vector<uint8_t>& pixels, uint64_t key, uint32_t width, uint32_t height, TextureCompression compression, CompressedImage& image)
+{
+	const uint32_t levelCount = GetLevelCount(width, height);
+	std::vector<std::vector<uint8_t>> levels;
+	levels.reserve(levelCount);
+
+	std::vector<uint8_t> levelPixels = pixels;
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		const uint32_t levelWidth = std::max(width >> level, 1u);
+		const uint32_t levelHeight = std::max(height >> level, 1u);
+		if (level > 0)
+			levelPixels = Downsample(levelPixels, std::max(width >> (level - 1), 1u), std::max(height >> (level - 1), 1u));
+
+		levels.push_back(BlockCompression::Encode(compression, levelPixels.data(), levelWidth, levelHeight));
+	}
+
+	Header header{};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.key = key;
+	header.compression = static_cast<uint32_t>(compression);
+	header.width = width;
+	header.height = height;
+	header.levelCount = levelCount;
+
+	auto file = std::make_shared<std::vector<uint8_t>>(sizeof(Header) + levelCount * sizeof(LevelRange));
+	std::memcpy(file->data(), &header, sizeof(Header));
+
+	std::vector<LevelRange> ranges;
+	for (const auto& level : levels)
+	{
+		ranges.push_back({ file->size(), level.size() });
+		file->insert(file->end(), level.begin(), level.end());
+	}
+	std::memcpy(file->data() + sizeof(Header), ranges.data(), ranges.size() * sizeof(LevelRange));
+
+	image = { compression, width, height, {}, file };
+	for (const LevelRange& range : ranges)
+		image.levels.emplace_back(file->data() + range.offset, range.size);
+	return file;
+}
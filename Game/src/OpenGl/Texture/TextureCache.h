@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BlockCompression.h"
+
+// Block compressed mip chain of an image, level 0 first. The levels point into the storage
+struct CompressedImage
+{
+	TextureCompression compression = TextureCompression::BC1;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<std::span<const uint8_t>> levels;
+	std::shared_ptr<const void> storage;
+
+	explicit operator bool() const { return !levels.empty(); }
+
+	[[nodiscard]] size_t GetSize() const;
+};
+
+// Block compressed textures kept on disk, one file per source image, size and compression, named after the
+// hash of the source bytes and of those. A miss decodes the source, resizes it, builds its mips with a box
+// filter, encodes them and writes the file. A hit maps the file, its blocks are uploaded as they are.
+// The file is a Header, levelCount LevelRange, then the blocks of the levels. Thread safe.
+class TextureCache
+{
+public:
+	struct Stats
+	{
+		size_t hitCount = 0;
+		size_t missCount = 0;
+		float loadMilliseconds = 0.f;
+		float encodeMilliseconds = 0.f;
+	};
+
+	explicit TextureCache(std::filesystem::path directory);
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	// In ./cache/textures
+	static TextureCache& Get();
+
+	// Whole file, empty when it cannot be read
+	static std::vector<uint8_t> ReadSource(const std::string& path);
+
+	// False when the source is not an image stb can decode
+	static bool GetSourceInfo(std::span<const uint8_t> source, uint32_t& width, uint32_t& height, bool& hasAlpha);
+
+	// Same from the file, only its header is read
+	static bool GetSourceInfo(const std::string& path, uint32_t& width, uint32_t& height, bool& hasAlpha);
+
+	// Levels of the source resized to width x height, down to 1x1. Empty when the source cannot be decoded
+	CompressedImage Load(std::span<const uint8_t> source, uint32_t width, uint32_t height, TextureCompression compression);
+
+	// Every level filled with one color, nothing is cached
+	static CompressedImage CreateSolid(const glm::u8vec4& color, uint32_t width, uint32_t height, TextureCompression compression);
+
+	// Levels of a full mip chain
+	static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+	[[nodiscard]] Stats GetStats() const;
+
+private:
+	static constexpr uint32_t kVersion = 1;
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t compression;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levelCount;
+	};
+
+	struct LevelRange
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// Empty when the file is missing or does not match the key
+	static CompressedImage Read(const std::filesystem::path& path, uint64_t key);
+
+	// The file content, the levels of the image point into it
+	static std::shared_ptr<std::vector<uint8_t>> Encode(const std::vector<uint8_t>& pixels, uint64_t key, uint32_t width, uint32_t height, TextureCompression compression, CompressedImage& image);
+
+	std::filesystem::path m_directory;
+
+	mutable std::mutex m_mutex;
+	Stats m_stats;
+};
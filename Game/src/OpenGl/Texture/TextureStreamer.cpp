@@ -0,0 +1,143 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+TextureStreamer::~TextureStreamer()
+{
+	JobSystem::Get().Wait(m_jobs);
+}
+
+void TextureStreamer::Request(const std::shared_ptr<Texture2DArray>& texture)
+{
+	for (uint32_t layer = 0; layer < texture->GetLayerCount(); ++layer)
+		Request(texture, layer, texture->GetLayerDesc(layer).priority);
+}
+
+void TextureStreamer::Request(const std::shared_ptr<Texture2DArray>& texture, uint32_t layer, int priority)
+{
+	// Before the requests of the same priority, the queue is popped from the back
+	const auto position = std::ranges::lower_bound(m_queue, priority, {}, &PendingLayer::priority);
+	m_queue.insert(position, { texture, layer, priority, texture->GetLayerSize() });
+}
+
+void TextureStreamer::Update()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_resultMutex);
+		for (Result& result : m_results)
+			m_ready.push_back(std::move(result));
+		m_loadingCount -= m_results.size();
+		m_results.clear();
+	}
+
+	std::ranges::stable_sort(m_ready, std::ranges::greater(), [](const Result& result) { return result.pending.priority; });
+
+	size_t uploadedSize = 0;
+	size_t uploadedCount = 0;
+	for (; uploadedCount < m_ready.size(); ++uploadedCount)
+	{
+		Result& result = m_ready[uploadedCount];
+		if (uploadedSize > 0 && uploadedSize + result.pending.size > m_uploadBudget)
+			break;
+
+		uploadedSize += Upload(result);
+		m_pendingSize -= result.pending.size;
+	}
+	m_ready.erase(m_ready.begin(), m_ready.begin() + static_cast<std::ptrdiff_t>(uploadedCount));
+
+	// A few jobs at a time, the chunk jobs share the pool
+	const size_t maxLoading = std::max<size_t>(2, JobSystem::Get().GetWorkerCount() / 2);
+	while (!m_queue.empty() && m_loadingCount < maxLoading)
+	{
+		if (m_pendingSize > 0 && m_pendingSize + m_queue.back().size > m_stagingBudget)
+			break;
+
+		PendingLayer pending = std::move(m_queue.back());
+		m_queue.pop_back();
+		if (!pending.texture.expired())
+			Launch(std::move(pending));
+	}
+}
+
+TextureStreamer::Stats TextureStreamer::GetStats() const
+{
+	return { m_queue.size(), m_loadingCount + m_ready.size(), m_residentCount, m_failedCount, m_pendingSize, m_uploadedSize };
+}
+
+size_t TextureStreamer::Upload(Result& result)
+{
+	const auto texture = result.pending.texture.lock();
+	if (!texture)
+		return 0;
+
+	const uint32_t layer = result.pending.layer;
+	if (!result.loaded)
+	{
+		std::cerr << "Failed to load texture layer: " << texture->GetLayerDesc(layer).path << std::endl;
+		texture->SetLayerState(layer, Texture2DArray::LayerState::Missing);
+		++m_failedCount;
+		return 0;
+	}
+
+	if (result.staging)
+	{
+		const TextureCompression compression = texture->GetCompression();
+		size_t offset = 0;
+		for (uint32_t level = 0; level < texture->GetLevelCount(); ++level)
+		{
+			const uint32_t width = std::max(texture->GetWidth() >> level, 1u);
+			const uint32_t height = std::max(texture->GetHeight() >> level, 1u);
+			const size_t size = BlockCompression::GetImageSize(compression, width, height);
+			m_stagingRing->CopyToTextureLayer(result.staging, offset, size, texture->GetRendererID(), static_cast<GLint>(level), static_cast<GLint>(layer),
+				static_cast<GLsizei>(width), static_cast<GLsizei>(height), BlockCompression::GetInternalFormat(compression));
+			offset += size;
+		}
+		result.staging.Reset();
+	}
+	else
+		texture->SetLayer(layer, result.image);
+
+	texture->SetLayerState(layer, Texture2DArray::LayerState::Resident);
+	++m_residentCount;
+	m_uploadedSize += result.pending.size;
+	return result.pending.size;
+}
+
+void TextureStreamer::Launch(PendingLayer pending)
+{
+	const auto texture = pending.texture.lock();
+	std::string path = texture->GetLayerDesc(pending.layer).path;
+	++m_loadingCount;
+	m_pendingSize += pending.size;
+
+	JobSystem::Get().Execute([this, pending = std::move(pending), path = std::move(path), width = texture->GetWidth(), height = texture->GetHeight(),
+		compression = texture->GetCompression(), stagingRing = m_stagingRing]() mutable
+	{
+		Result result{ std::move(pending) };
+
+		const std::vector<uint8_t> source = TextureCache::ReadSource(path);
+		if (!source.empty())
+			result.image = TextureCache::Get().Load(source, width, height, compression);
+		result.loaded = static_cast<bool>(result.image);
+
+		if (result.loaded && stagingRing)
+			result.staging = stagingRing->Allocate(result.image.GetSize());
+
+		// The levels are written where the upload reads them, the decoded or mapped image is released right away
+		if (result.staging)
+		{
+			auto* data = static_cast<uint8_t*>(result.staging.GetData());
+			for (const auto& level : result.image.levels)
+			{
+				std::memcpy(data, level.data(), level.size());
+				data += level.size();
+			}
+			result.image = {};
+		}
+
+		std::lock_guard<std::mutex> lock(m_resultMutex);
+		m_results.push_back(std::move(result));
+	}, m_jobs);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Texture2DArray.h"
+#include "TextureCache.h"
+#include "../Buffer/StagingRing.h"
+#include "../../JobSystem/JobSystem.h"
+
+// Loads the layers of texture arrays on the job system, through the TextureCache, while the arrays show their
+// fallback colors. A job writes the blocks of its layer into the staging ring and Update uploads them from it
+// (the ring is the pixel unpack buffer), or from client memory when the ring is full.
+// Requests start by priority, as long as the layers loading or waiting for their upload fit in the staging budget,
+// and Update uploads at most the upload budget a frame, at least one layer. The storage of the arrays is allocated
+// whole when they are created, so the staging budget only bounds the memory held by the loads in flight, not
+// resident texture memory. Arrays destroyed meanwhile are skipped.
+// Must be used from the thread owning the GL context.
+class TextureStreamer
+{
+public:
+	struct Stats
+	{
+		size_t queuedCount = 0;
+		size_t loadingCount = 0;
+		size_t residentCount = 0;
+		size_t failedCount = 0;
+
+		// Of the layers loading or waiting for their upload
+		size_t pendingSize = 0;
+		size_t uploadedSize = 0;
+	};
+
+	TextureStreamer() = default;
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// The jobs write the blocks into the ring, null to upload from client memory
+	void SetStagingRing(const std::shared_ptr<StagingRing>& stagingRing) { m_stagingRing = stagingRing; }
+
+	void SetStagingBudget(size_t size) { m_stagingBudget = size; }
+	void SetUploadBudget(size_t sizePerFrame) { m_uploadBudget = sizePerFrame; }
+
+	// Every layer of the array, at the priority of its desc
+	void Request(const std::shared_ptr<Texture2DArray>& texture);
+	void Request(const std::shared_ptr<Texture2DArray>& texture, uint32_t layer, int priority);
+
+	// Once per frame: uploads the loaded layers and starts the next requests
+	void Update();
+
+	[[nodiscard]] Stats GetStats() const;
+
+private:
+	struct PendingLayer
+	{
+		std::weak_ptr<Texture2DArray> texture;
+		uint32_t layer = 0;
+		int priority = 0;
+
+		// Compressed size of the layer, counted against the staging budget
+		size_t size = 0;
+	};
+
+	struct Result
+	{
+		PendingLayer pending;
+
+		// Empty when the image could not be loaded
+		CompressedImage image;
+
+		// Every level back to back, the image is released once they are written here
+		StagingRing::Allocation staging;
+		bool loaded = false;
+	};
+
+	// Size uploaded, 0 when the layer failed or its array is gone
+	size_t Upload(Result& result);
+	void Launch(PendingLayer pending);
+
+	std::shared_ptr<StagingRing> m_stagingRing;
+	size_t m_stagingBudget = 64 << 20;
+	size_t m_uploadBudget = 8 << 20;
+
+	// Highest priority last
+	std::vector<PendingLayer> m_queue;
+	std::vector<Result> m_ready;
+
+	JobCounter m_jobs;
+	size_t m_loadingCount = 0;
+	size_t m_pendingSize = 0;
+	size_t m_residentCount = 0;
+	size_t m_failedCount = 0;
+	size_t m_uploadedSize = 0;
+
+	std::mutex m_resultMutex;
+	std::vector<Result> m_results;
+};
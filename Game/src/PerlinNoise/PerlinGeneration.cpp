@@ -1 +1,392 @@
 #include "PerlinGeneration.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../JobSystem/JobSystem.h"
+#include "../Utils/Hash.h"
+
+namespace
+{
+    constexpr int kMaxCoarseGridStep = 64;
+
+    // Measured bound of the Catmull-Rom error on one Perlin octave is about 3.5 * (step * rate)^3,
+    // doubled for the two interpolation passes
+    constexpr double kCubicErrorFactor = 8.0;
+
+    long long FloorDiv(long long value, long long divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    void CatmullRomWeights(double t, double weights[4])
+    {
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        weights[0] = 0.5 * (-t + 2.0 * t2 - t3);
+        weights[1] = 0.5 * (2.0 - 5.0 * t2 + 3.0 * t3);
+        weights[2] = 0.5 * (t + 4.0 * t2 - 3.0 * t3);
+        weights[3] = 0.5 * (-t2 + t3);
+    }
+}
+
+void CompiledSpline::Compile(const std::vector<SplinePoint>& points, bool smooth)
+{
+    m_points = points;
+    m_smooth = smooth;
+
+    m_breakpoints.clear();
+    m_valueStart.clear();
+    m_valueRange.clear();
+    m_heightStart.clear();
+    m_heightRange.clear();
+    m_tangentStart.clear();
+    m_tangentEnd.clear();
+
+    const size_t count = points.size();
+    if (count < 2)
+        return;
+
+    m_breakpoints.resize(count);
+    m_valueStart.resize(count);
+    m_valueRange.resize(count);
+    m_heightStart.resize(count);
+    m_heightRange.resize(count);
+    m_tangentStart.resize(count, 0.f);
+    m_tangentEnd.resize(count, 0.f);
+
+    float runningMax = points[0].value;
+    for (size_t i = 0; i < count; ++i)
+    {
+        runningMax = std::max(runningMax, points[i].value);
+        m_breakpoints[i] = runningMax;
+
+        // Below the first point the segment is degenerate, like the previous per-sample walk
+        const SplinePoint& previous = points[i == 0 ? 0 : i - 1];
+        const SplinePoint& current = points[i];
+        m_valueStart[i] = previous.value;
+        m_valueRange[i] = current.value - previous.value;
+        m_heightStart[i] = previous.height;
+        m_heightRange[i] = current.height - previous.height;
+    }
+
+    if (!smooth)
+        return;
+
+    // Fritsch-Carlson tangents keep the cubic monotone wherever the points are
+    std::vector<float> secants(count - 1);
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        const float range = m_valueRange[i + 1];
+        secants[i] = range > 0.f ? m_heightRange[i + 1] / range : 0.f;
+    }
+
+    std::vector<float> tangents(count);
+    tangents[0] = secants[0];
+    tangents[count - 1] = secants[count - 2];
+    for (size_t i = 1; i + 1 < count; ++i)
+    {
+        tangents[i] = secants[i - 1] * secants[i] <= 0.f ? 0.f : (secants[i - 1] + secants[i]) * 0.5f;
+    }
+
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        if (secants[i] == 0.f)
+        {
+            tangents[i] = 0.f;
+            tangents[i + 1] = 0.f;
+            continue;
+        }
+
+        const float alpha = tangents[i] / secants[i];
+        const float beta = tangents[i + 1] / secants[i];
+        const float length = alpha * alpha + beta * beta;
+        if (length > 9.f)
+        {
+            const float tau = 3.f / std::sqrt(length);
+            tangents[i] = tau * alpha * secants[i];
+            tangents[i + 1] = tau * beta * secants[i];
+        }
+    }
+
+    for (size_t i = 1; i < count; ++i)
+    {
+        m_tangentStart[i] = tangents[i - 1];
+        m_tangentEnd[i] = tangents[i];
+    }
+}
+
+void CompiledSpline::Apply(const float* in, float* out, size_t count) const
+{
+    if (!IsEnabled())
+    {
+        if (in != out)
+            std::copy(in, in + count, out);
+        return;
+    }
+
+    const size_t breakpointCount = m_breakpoints.size();
+    const size_t lastSegment = breakpointCount - 1;
+    const float* breakpoints = m_breakpoints.data();
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        const float value = in[k];
+
+        // Index of the first breakpoint above the value, found without branches
+        size_t segment = 0;
+        for (size_t i = 0; i < breakpointCount; ++i)
+            segment += value >= breakpoints[i];
+        segment = std::min(segment, lastSegment);
+
+        const float linear = (value - m_valueStart[segment]) * m_heightRange[segment] / m_valueRange[segment] + m_heightStart[segment];
+        if (!m_smooth)
+        {
+            out[k] = linear;
+            continue;
+        }
+
+        const float range = m_valueRange[segment];
+        const float t = range > 0.f ? (value - m_valueStart[segment]) / range : -1.f;
+        if (t < 0.f || t > 1.f)
+        {
+            // Outside of the segment, extrapolate linearly
+            out[k] = linear;
+            continue;
+        }
+
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        const float startHeight = m_heightStart[segment];
+        const float endHeight = startHeight + m_heightRange[segment];
+        out[k] = (2.f * t3 - 3.f * t2 + 1.f) * startHeight
+            + (t3 - 2.f * t2 + t) * range * m_tangentStart[segment]
+            + (-2.f * t3 + 3.f * t2) * endHeight
+            + (t3 - t2) * range * m_tangentEnd[segment];
+    }
+}
+
+std::vector<SplineSegment> CompiledSpline::GetSegments() const
+{
+    std::vector<SplineSegment> segments(m_breakpoints.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        segments[i].breakpoint = m_breakpoints[i];
+        segments[i].valueStart = m_valueStart[i];
+        segments[i].valueRange = m_valueRange[i];
+        segments[i].heightStart = m_heightStart[i];
+        segments[i].heightRange = m_heightRange[i];
+        segments[i].tangentStart = m_tangentStart[i];
+        segments[i].tangentEnd = m_tangentEnd[i];
+    }
+    return segments;
+}
+
+void CompiledSpline::GetOutputRange(float inputMin, float inputMax, float& outputMin, float& outputMax) const
+{
+    // The segments are monotone cubics or lines and extrapolate linearly, their extremes are at the range ends
+    // or at the points. The samples in between only guard against rounding
+    constexpr int kSampleCount = 256;
+    std::vector<float> inputs;
+    inputs.reserve(kSampleCount + m_points.size() + 2);
+    for (int i = 0; i <= kSampleCount; ++i)
+        inputs.push_back(inputMin + (inputMax - inputMin) * static_cast<float>(i) / kSampleCount);
+    for (const SplinePoint& point : m_points)
+    {
+        if (point.value > inputMin && point.value < inputMax)
+            inputs.push_back(point.value);
+    }
+
+    std::vector<float> outputs(inputs.size());
+    Apply(inputs.data(), outputs.data(), inputs.size());
+
+    // The degenerate segment below the first point yields NaN, no height comes out of it
+    std::erase_if(outputs, [](float output) { return std::isnan(output); });
+    if (outputs.empty())
+    {
+        outputMin = outputMax = 0.f;
+        return;
+    }
+
+    const auto [minOutput, maxOutput] = std::minmax_element(outputs.begin(), outputs.end());
+    outputMin = *minOutput;
+    outputMax = *maxOutput;
+}
+
+bool CompiledSpline::IsCompiledFrom(const std::vector<SplinePoint>& points, bool smooth) const
+{
+    if (smooth != m_smooth || points.size() != m_points.size())
+        return false;
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (points[i].value != m_points[i].value || points[i].height != m_points[i].height)
+            return false;
+    }
+
+    return true;
+}
+
+float NoiseSettings::GetNoiseAmplitude() const
+{
+    float amplitude = 0.f;
+    float octaveAmplitude = 1.f;
+    for (int i = 0; i < octaves; ++i)
+    {
+        amplitude += std::abs(octaveAmplitude);
+        octaveAmplitude *= persistence;
+    }
+    return amplitude;
+}
+
+int NoiseSettings::GetCoarseGridStep(int lod) const
+{
+    if (!coarseGrid)
+        return 1;
+
+    // Noise units travelled between two samples by the first octave
+    const double rate = std::abs(static_cast<double>(GetSampleFrequency())) / std::max(1, lod);
+
+    int bestStep = 1;
+    for (int step = 2; step <= kMaxCoarseGridStep; step *= 2)
+    {
+        double error = 0.0;
+        double amplitude = 1.0;
+        double octaveRate = rate;
+        for (int octave = 0; octave < octaves; ++octave)
+        {
+            const double phase = step * octaveRate;
+            error += std::abs(amplitude) * phase * phase * phase;
+            amplitude *= persistence;
+            octaveRate *= 2.0;
+        }
+
+        if (error * kCubicErrorFactor > coarseGridMaxError)
+            break;
+
+        bestStep = step;
+    }
+
+    return bestStep;
+}
+
+bool NoiseSettings::SampleNoise(const siv::PerlinNoise& perlin, const NoiseGrid& grid, double* values, const CancellationToken* token) const
+{
+    const float f = GetSampleFrequency();
+    const int lod = grid.lod;
+    const int step = GetCoarseGridStep(lod);
+
+    if (step <= 1)
+    {
+        std::vector<double> xs(grid.samplesX), zs(grid.samplesX);
+
+        const auto startX = static_cast<float>(grid.startX);
+        const auto startZ = static_cast<float>(grid.startZ);
+        for (int z = 0; z < grid.samplesZ; ++z)
+        {
+            if (CancellationToken::IsCancelled(token))
+                return false;
+
+            for (int x = 0; x < grid.samplesX; ++x)
+            {
+                const auto x1 = x / (float)lod + startX;
+                const auto z1 = z / (float)lod + startZ;
+
+                xs[x] = x1 * f;
+                zs[x] = z1 * f;
+            }
+
+            GetNoiseValues(perlin, xs.data(), zs.data(), values + z * static_cast<size_t>(grid.samplesX), grid.samplesX);
+        }
+        return true;
+    }
+
+    // The lattice is aligned on global sample indices so neighbouring chunks share their nodes
+    const long long globalX = static_cast<long long>(grid.startX) * lod;
+    const long long globalZ = static_cast<long long>(grid.startZ) * lod;
+
+    const long long firstNodeX = FloorDiv(globalX, step) - 1;
+    const long long firstNodeZ = FloorDiv(globalZ, step) - 1;
+    const int nodesX = static_cast<int>(FloorDiv(globalX + grid.samplesX - 1, step) + 2 - firstNodeX + 1);
+    const int nodesZ = static_cast<int>(FloorDiv(globalZ + grid.samplesZ - 1, step) + 2 - firstNodeZ + 1);
+
+    std::vector<double> xs(nodesX), zs(nodesX), nodes(static_cast<size_t>(nodesX) * nodesZ);
+    for (int z = 0; z < nodesZ; ++z)
+    {
+        if (CancellationToken::IsCancelled(token))
+            return false;
+
+        const float z1 = static_cast<float>((firstNodeZ + z) * step) / lod;
+        for (int x = 0; x < nodesX; ++x)
+        {
+            const float x1 = static_cast<float>((firstNodeX + x) * step) / lod;
+
+            xs[x] = x1 * f;
+            zs[x] = z1 * f;
+        }
+
+        GetNoiseValues(perlin, xs.data(), zs.data(), nodes.data() + z * static_cast<size_t>(nodesX), nodesX);
+    }
+
+    // Separable bicubic: interpolate every lattice row along x, then every sample column along z
+    std::vector<double> rows(static_cast<size_t>(nodesZ) * grid.samplesX);
+    for (int x = 0; x < grid.samplesX; ++x)
+    {
+        const long long global = globalX + x;
+        const long long cell = FloorDiv(global, step);
+        const int base = static_cast<int>(cell - firstNodeX - 1);
+
+        double weights[4];
+        CatmullRomWeights(static_cast<double>(global - cell * step) / step, weights);
+
+        for (int z = 0; z < nodesZ; ++z)
+        {
+            const double* node = nodes.data() + z * static_cast<size_t>(nodesX) + base;
+            rows[z * static_cast<size_t>(grid.samplesX) + x] = weights[0] * node[0] + weights[1] * node[1] + weights[2] * node[2] + weights[3] * node[3];
+        }
+    }
+
+    if (CancellationToken::IsCancelled(token))
+        return false;
+
+    for (int z = 0; z < grid.samplesZ; ++z)
+    {
+        const long long global = globalZ + z;
+        const long long cell = FloorDiv(global, step);
+        const int base = static_cast<int>(cell - firstNodeZ - 1);
+
+        double weights[4];
+        CatmullRomWeights(static_cast<double>(global - cell * step) / step, weights);
+
+        const double* row0 = rows.data() + base * static_cast<size_t>(grid.samplesX);
+        const double* row1 = row0 + grid.samplesX;
+        const double* row2 = row1 + grid.samplesX;
+        const double* row3 = row2 + grid.samplesX;
+        double* out = values + z * static_cast<size_t>(grid.samplesX);
+        for (int x = 0; x < grid.samplesX; ++x)
+        {
+            out[x] = weights[0] * row0[x] + weights[1] * row1[x] + weights[2] * row2[x] + weights[3] * row3[x];
+        }
+    }
+
+    return true;
+}
+
+uint64_t NoiseSettings::GetNoiseHash() const
+{
+    uint64_t hash = Hash::Combine(Hash::kFnvOffset, seed);
+    hash = Hash::Combine(hash, frequency);
+    hash = Hash::Combine(hash, octaves);
+    hash = Hash::Combine(hash, persistence);
+    hash = Hash::Combine(hash, coarseGrid);
+    return Hash::Combine(hash, coarseGridMaxError);
+}
+
+uint64_t NoiseSettings::GetRemapHash() const
+{
+    uint64_t hash = Hash::Fnv1a(splinePoints.data(), splinePoints.size() * sizeof(SplinePoint));
+    hash = Hash::Combine(hash, smoothSpline);
+    hash = Hash::Combine(hash, ridgeNoise);
+    hash = Hash::Combine(hash, terraces);
+    return Hash::Combine(hash, terraceCount);
+}
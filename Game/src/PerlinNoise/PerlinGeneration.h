@@ -1,14 +1,77 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "../libs/noise/PerlinNoise.h"
 
+class CancellationToken;
+
+// Define a struct to hold data for each row of the table
+struct SplinePoint {
+    float value = 0.f;
+    float height = 0.f;
+};
+
+// One segment of a compiled spline, laid out for a std430 buffer
+struct SplineSegment {
+    float breakpoint = 0.f;
+    float valueStart = 0.f;
+    float valueRange = 0.f;
+    float heightStart = 0.f;
+    float heightRange = 0.f;
+    float tangentStart = 0.f;
+    float tangentEnd = 0.f;
+    float padding = 0.f;
+};
+
+// Spline points compiled into flat per-segment arrays so a whole row can be remapped
+// with a branchless segment search instead of walking the points for every sample
+class CompiledSpline
+{
+public:
+    void Compile(const std::vector<SplinePoint>& points, bool smooth);
+
+    // Remaps count values, in and out may alias
+    void Apply(const float* in, float* out, size_t count) const;
+
+    [[nodiscard]] bool IsCompiledFrom(const std::vector<SplinePoint>& points, bool smooth) const;
+
+    [[nodiscard]] bool IsEnabled() const { return m_points.size() > 1; }
+
+    [[nodiscard]] bool IsSmooth() const { return m_smooth; }
+
+    [[nodiscard]] std::vector<SplineSegment> GetSegments() const;
+
+    // Smallest and largest output for the inputs in [inputMin, inputMax]
+    void GetOutputRange(float inputMin, float inputMax, float& outputMin, float& outputMax) const;
+
+private:
+    std::vector<SplinePoint> m_points;
+    bool m_smooth = false;
+
+    // Running maximum of the point values: the first point above a value is also the first breakpoint above it
+    std::vector<float> m_breakpoints;
+
+    // Segment i goes from point i - 1 to point i
+    std::vector<float> m_valueStart, m_valueRange;
+    std::vector<float> m_heightStart, m_heightRange;
+    std::vector<float> m_tangentStart, m_tangentEnd;
+};
+
+// Samples of a chunk: sample (i, j) lies at world position (startX + i / lod, startZ + j / lod)
+struct NoiseGrid
+{
+    int startX = 0;
+    int startZ = 0;
+    int samplesX = 0;
+    int samplesZ = 0;
+    int lod = 1;
+};
+
 struct NoiseSettings
 {
-    // Define a struct to hold data for each row of the table
-    struct RowData {
-        float value = 0.f;
-        float height = 0.f;
-    };
+    using RowData = SplinePoint;
 
     // Define a vector to hold all of the row data
     std::vector<RowData> splinePoints;
@@ -24,10 +87,52 @@ struct NoiseSettings
     bool terraces = false;
     int terraceCount = 5;
 
+    // Monotone cubic interpolation between spline points instead of linear
+    bool smoothSpline = false;
+
+    // Low frequency layers are evaluated on a coarse lattice and upsampled with bicubic interpolation,
+    // the lattice step is the largest one whose estimated error stays under coarseGridMaxError
+    bool coarseGrid = true;
+    float coarseGridMaxError = 0.0005f;
+
+    CompiledSpline spline;
+
+    // Must be called after any change of splinePoints, before generating from several threads
+    void CompileSpline()
+    {
+        spline.Compile(splinePoints, smoothSpline);
+    }
+
     [[nodiscard]] float GetNoiseValue(const siv::PerlinNoise& perlin, float x, float z) const
     {
         return perlin.octave2D(x, z, octaves, persistence);
     }
+
+    void GetNoiseValues(const siv::PerlinNoise& perlin, const double* xs, const double* zs, double* values, size_t count) const
+    {
+        perlin.octave2DBatch(xs, zs, values, count, octaves, persistence);
+    }
+
+    // Bound of the absolute noise value, the sum of the octave amplitudes
+    [[nodiscard]] float GetNoiseAmplitude() const;
+
+    [[nodiscard]] float GetSampleFrequency() const
+    {
+        return frequency * 0.001f;
+    }
+
+    // Lattice step in samples used by SampleNoise, 1 when the layer is evaluated at every sample
+    [[nodiscard]] int GetCoarseGridStep(int lod) const;
+
+    // Fills grid.samplesX * grid.samplesZ noise values, row by row.
+    // Returns false when the token got cancelled, the values are then incomplete
+    bool SampleNoise(const siv::PerlinNoise& perlin, const NoiseGrid& grid, double* values, const CancellationToken* token = nullptr) const;
+
+    // Hash of the settings read by SampleNoise
+    [[nodiscard]] uint64_t GetNoiseHash() const;
+
+    // Hash of the settings used to remap the noise into heights: spline, ridges and terraces
+    [[nodiscard]] uint64_t GetRemapHash() const;
 };
 
 
@@ -50,7 +155,11 @@ const NoiseSettings continentalnessNoiseSettings{
     .seed = 0,
     .ridgeNoise = false,
     .terraces = false,
-    .terraceCount = 1
+    .terraceCount = 1,
+    .smoothSpline = false,
+    .coarseGrid = true,
+    .coarseGridMaxError = 0.0005f,
+    .spline = {}
 };
 
 const NoiseSettings erosionNoiseSettings{
@@ -73,5 +182,9 @@ const NoiseSettings erosionNoiseSettings{
     .seed = 0,
     .ridgeNoise = false,
     .terraces = false,
-    .terraceCount = 1
+    .terraceCount = 1,
+    .smoothSpline = false,
+    .coarseGrid = true,
+    .coarseGridMaxError = 0.0005f,
+    .spline = {}
 };
\ No newline at end of file
@@ -1,29 +1,135 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <vector>
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GeoMipmap.h"
+#include "Rtin.h"
 #include "HeightMap/HeightMap.h"
+#include "../JobSystem/JobSystem.h"
+#include "../OpenGl/Buffer/Buffer.h"
+#include "../OpenGl/Buffer/StagingRing.h"
+#include "../Utils/Hash.h"
 
 
 class VertexArray;
 struct NoiseSettings;
 
+// Sample of the chunk grid and its height, 6 bytes. The height is an unsigned normalized 16 bit value over
+// the vertex height range of its chunk, GetTransform places the grid and that range in the world
+struct ChunkVertex
+{
+	uint16_t x;
+	uint16_t z;
+	uint16_t height;
+
+	// Same as PackHeight in the generation compute shader, a flat range packs every height to 0
+	static uint16_t PackHeight(float height, float minHeight, float heightScale)
+	{
+		const float normalized = heightScale > 0.f ? (height - minHeight) / heightScale : 0.f;
+		return static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.f, 1.f) * 65535.f));
+	}
+
+	// Same as the normalized attribute read by the shaders
+	static float UnpackHeight(uint16_t height, float minHeight, float heightScale)
+	{
+		return minHeight + static_cast<float>(height) / 65535.f * heightScale;
+	}
+};
+
+static_assert(sizeof(ChunkVertex) == 6);
+
 
 class Chunk
 {
 public:
-    Chunk(int x, int z, int width, int height, int lod, NoiseSettings& continentalnessSettings, NoiseSettings& erosionSettings, bool blend): x(x), z(z), width(width), height(height), lod(lod), m_heightMap(width, height, x, z, lod, continentalnessSettings, erosionSettings, blend)
+	Chunk() = default;
+
+    Chunk(int x, int z, int width, int height, int lod, const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend, bool generateVertices, bool adaptiveErrors): x(x), z(z), width(width), height(height), lod(lod)
     {
-		GenerateVertices();
-		GenerateIndices();
+		Update(continentalnessSettings, erosionSettings, blend, generateVertices, adaptiveErrors);
     }
 
+	// Chunk without vertices, they are written on the GPU or by a later Update.
+	// The indices are shared by all the chunks of a size, see IndexBufferCache
+	Chunk(int x, int z, int width, int height, int lod): x(x), z(z), width(width), height(height), lod(lod)
+	{
+	}
+
+	// Reruns only the stages (noise -> remap -> blend -> mesh) whose inputs changed since the last call.
+	// Returns true when the vertices changed and have to be uploaded again. A cancelled update returns
+	// false, the stages it finished stay cached and the others are rerun by the next update.
+	// Without generateVertices the chunk only keeps its heights (see ChunkInstancer) and releases its vertices.
+	// The RTIN errors of the adaptive mesh are only kept with adaptiveErrors
+	bool Update(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend, bool generateVertices, bool adaptiveErrors, const CancellationToken* token = nullptr)
+	{
+		const NoiseGrid grid{ x * (width - 1), z * (height - 1), width * lod, height * lod, lod };
+		const uint64_t gridKey = Hash::Combine(Hash::kFnvOffset, grid);
+
+		// Ridges and terraces of both layers follow the continentalness settings
+		const uint64_t shapeKey = Hash::Combine(Hash::Combine(Hash::kFnvOffset, continentalnessSettings.ridgeNoise), continentalnessSettings.terraces);
+
+		const uint64_t continentalnessKey = UpdateLayer(continentalnessSettings, continentalnessSettings, grid, gridKey, shapeKey, m_continentalnessStages, token);
+		if (continentalnessKey == 0)
+			return false;
+
+		// The erosion layer is only generated while blending, its stages stay cached otherwise
+		uint64_t blendKey = Hash::Combine(continentalnessKey, blend);
+		if (blend)
+		{
+			const uint64_t erosionKey = UpdateLayer(erosionSettings, continentalnessSettings, grid, gridKey, shapeKey, m_erosionStages, token);
+			if (erosionKey == 0)
+				return false;
+
+			blendKey = Hash::Combine(Hash::Combine(blendKey, erosionKey), erosionSettings.factor);
+		}
+
+		if (CancellationToken::IsCancelled(token))
+			return false;
+
+		// Same heights, only the vertices and the RTIN errors follow a change of the flags
+		if (blendKey == m_blendKey)
+		{
+			UpdateAdaptiveErrors(adaptiveErrors);
+			if (generateVertices != m_vertices.empty())
+				return false;
+
+			GenerateVertices(generateVertices);
+			return true;
+		}
+
+		m_blendKey = blendKey;
+		m_heightMap.mapWidth = width;
+		m_heightMap.mapHeight = height;
+		m_heightMap.Blend(m_continentalnessStages.heights, m_erosionStages.heights, blend, erosionSettings.factor);
+
+		const auto [minHeight, maxHeight] = std::minmax_element(m_heightMap.begin(), m_heightMap.end());
+		m_minHeight = *minHeight;
+		m_maxHeight = *maxHeight;
+		SetVertexHeightRange(m_minHeight, m_maxHeight);
+		GenerateVertices(generateVertices);
+
+		m_levelErrors = GeoMipmap::ComputeLevelErrors(m_heightMap.data(), width, height, lod);
+		m_adaptiveErrors.clear();
+		UpdateAdaptiveErrors(adaptiveErrors);
+		return true;
+	}
+
 	HeightMap& GetHeightMap()
 	{
 		return m_heightMap;
 	}
 
+	[[nodiscard]] const HeightMap& GetHeightMap() const
+	{
+		return m_heightMap;
+	}
+
 	void SetHeightMap(const HeightMap& heightMap)
 	{
 		m_heightMap = heightMap;
@@ -34,14 +140,55 @@ public:
 	    m_vertexArray = vertexArray;
     }
 
-	std::vector<float>& GetVertices()
+	std::vector<ChunkVertex>& GetVertices()
 	{
 		return m_vertices;
 	}
 
-	std::vector<uint32_t>& GetIndices()
+	[[nodiscard]] const std::vector<ChunkVertex>& GetVertices() const
+	{
+		return m_vertices;
+	}
+
+	// Grid positions are read as floats and the height normalized to [0, 1], the shader scales them by the
+	// sample spacing and the vertex height range
+	static BufferLayout GetVertexLayout()
+	{
+		return {
+			{ ShaderDataType::UShort2, "a_GridPosition" },
+			{ ShaderDataType::UShort, "a_Height", true },
+		};
+	}
+
+	// From the grid of samples and the normalized heights to the world
+	[[nodiscard]] glm::mat4 GetTransform() const
+	{
+		const glm::mat4 translation = glm::translate(glm::mat4(1.f), glm::vec3(static_cast<float>(x * (width - 1)), m_vertexMinHeight, static_cast<float>(z * (height - 1))));
+		return glm::scale(translation, glm::vec3(1.f / static_cast<float>(lod), m_vertexHeightScale, 1.f / static_cast<float>(lod)));
+	}
+
+	// Heights the vertices are normalized over: the heights of Update, or for the vertices written on the GPU
+	// the range of the settings (see GpuChunkGenerator)
+	void SetVertexHeightRange(float minHeight, float maxHeight)
+	{
+		m_vertexMinHeight = minHeight;
+		m_vertexHeightScale = maxHeight - minHeight;
+	}
+
+	[[nodiscard]] float GetVertexMinHeight() const { return m_vertexMinHeight; }
+
+	[[nodiscard]] float GetVertexHeightScale() const { return m_vertexHeightScale; }
+
+	// Copies the vertices into mapped upload memory from any thread, empty when there are none or the ring is full
+	[[nodiscard]] StagingRing::Allocation StageVertices(StagingRing& ring) const
 	{
-		return m_indices;
+		if (m_vertices.empty())
+			return {};
+
+		StagingRing::Allocation allocation = ring.Allocate(sizeof(ChunkVertex) * m_vertices.size());
+		if (allocation)
+			std::memcpy(allocation.GetData(), m_vertices.data(), allocation.GetSize());
+		return allocation;
 	}
 
 	const std::shared_ptr<VertexArray>& GetVertexArray()
@@ -49,49 +196,133 @@ public:
 		return m_vertexArray;
 	}
 
-private:
+	[[nodiscard]] size_t GetVertexCount() const
+	{
+		return static_cast<size_t>(width) * lod * height * lod;
+	}
 
-	void GenerateVertices()
+	[[nodiscard]] float GetMinHeight() const { return m_minHeight; }
+
+	[[nodiscard]] float GetMaxHeight() const { return m_maxHeight; }
+
+	// Height range of chunks without CPU heights: HeightMap::GetHeightBounds until the GPU reduced theirs
+	void SetHeightBounds(float minHeight, float maxHeight)
 	{
-		m_vertices.clear();
-		m_vertices.resize(width * lod * height * lod * 5);
+		m_minHeight = minHeight;
+		m_maxHeight = maxHeight;
+	}
 
-		const float startX = x * width + x * -1.f;
-		const float startZ = z * height + z * -1.f;
+	// Geomipmap levels, chunks generated on the GPU have no heights on the CPU and only use the full grid
+	[[nodiscard]] int GetLevelCount() const { return m_levelErrors.empty() ? 1 : static_cast<int>(m_levelErrors.size()); }
 
-		for (int z = 0; z < height * lod; ++z)
+	[[nodiscard]] float GetLevelError(int level) const { return m_levelErrors.empty() ? 0.f : m_levelErrors[level]; }
+
+	// Changes whenever the heights of the chunk change
+	[[nodiscard]] uint64_t GetHeightKey() const { return m_blendKey; }
+
+	// World bounds, vertically from the heights generated by Update or the range given to SetHeightBounds
+	[[nodiscard]] glm::vec3 GetBoundsMin() const
+	{
+		return { static_cast<float>(x * (width - 1)), m_minHeight, static_cast<float>(z * (height - 1)) };
+	}
+
+	[[nodiscard]] glm::vec3 GetBoundsMax() const
+	{
+		return { static_cast<float>(x * (width - 1) + width - 1), m_maxHeight, static_cast<float>(z * (height - 1) + height - 1) };
+	}
+
+	// Distance from position to the bounds of the chunk, 0 inside
+	[[nodiscard]] float GetDistance(const glm::vec3& position) const
+	{
+		return glm::length(glm::max(glm::max(GetBoundsMin() - position, position - GetBoundsMax()), glm::vec3(0.f)));
+	}
+
+	// Chunks generated on the GPU have no heights on the CPU to build an adaptive mesh from, the others only
+	// while generated with ChunkGenerationParameters::adaptiveErrors
+	[[nodiscard]] bool HasAdaptiveMesh() const { return !m_adaptiveErrors.empty(); }
+
+	// Vertices (same layout as GetVertices) and triangles of the RTIN mesh within maxError of the heights
+	void GenerateAdaptiveMesh(float maxError, std::vector<ChunkVertex>& vertices, std::vector<uint32_t>& indices) const
+	{
+		std::vector<uint32_t> samples;
+		Rtin::Extract(m_adaptiveErrors, width, height, lod, maxError, samples, indices);
+
+		const auto rowSize = static_cast<uint32_t>(width * lod);
+		vertices.resize(samples.size());
+		for (size_t i = 0; i < samples.size(); ++i)
+			vertices[i] = { static_cast<uint16_t>(samples[i] % rowSize), static_cast<uint16_t>(samples[i] / rowSize), ChunkVertex::PackHeight(m_heightMap[samples[i]], m_vertexMinHeight, m_vertexHeightScale) };
+	}
+
+private:
+	// Products of the noise and remap stages of one layer with the key they were built from
+	struct LayerStages
+	{
+		uint64_t noiseKey = 0;
+		uint64_t remapKey = 0;
+		std::vector<float> noise;
+		std::vector<float> heights;
+	};
+
+	// Returns the key of the layer heights, which changes whenever the layer has to be blended again, 0 when cancelled
+	static uint64_t UpdateLayer(const NoiseSettings& settings, const NoiseSettings& shapeSettings, const NoiseGrid& grid, uint64_t gridKey, uint64_t shapeKey, LayerStages& stages, const CancellationToken* token)
+	{
+		const uint64_t noiseKey = Hash::Combine(gridKey, settings.GetNoiseHash());
+		if (noiseKey != stages.noiseKey)
 		{
-			for (int x = 0; x < width * lod; ++x)
-			{
-				const size_t index = (x + z * width * lod) * 5;
+			if (!HeightMap::SampleLayer(settings, grid, stages.noise, token))
+				return 0;
+			stages.noiseKey = noiseKey;
+		}
 
-				auto x1 = x / (float)lod + startX;
-				auto z1 = z / (float)lod + startZ;
+		if (CancellationToken::IsCancelled(token))
+			return 0;
 
-				m_vertices[index] = x1;
-				m_vertices[index + 1] = m_heightMap[x + z * width * lod];
-				m_vertices[index + 2] = z1;
-                m_vertices[index + 3] = (float)(x1 / 10);
-                m_vertices[index + 4] = (float)(z1 / 10);
-			}
+		const uint64_t remapKey = Hash::Combine(Hash::Combine(noiseKey, settings.GetRemapHash()), shapeKey);
+		if (remapKey != stages.remapKey)
+		{
+			HeightMap::RemapLayer(settings, shapeSettings, stages.noise, stages.heights);
+			stages.remapKey = remapKey;
 		}
+
+		return remapKey;
+	}
+
+	// The errors are computed again only when missing, they are released when the adaptive mesh is turned off
+	void UpdateAdaptiveErrors(bool adaptiveErrors)
+	{
+		if (!adaptiveErrors)
+			std::vector<float>().swap(m_adaptiveErrors);
+		else if (m_adaptiveErrors.empty())
+			m_adaptiveErrors = Rtin::ComputeErrors(m_heightMap.data(), width, height, lod);
 	}
 
-	void GenerateIndices()
+	void GenerateVertices(bool generateVertices)
 	{
-		m_indices.clear();
-		m_indices.resize((width * lod - 1 * lod) * (height * lod - 1 * lod) * 6);
-		for (int z = 0; z < height * lod - 1 * lod; ++z)
+		if (!generateVertices)
 		{
-			for (int x = 0; x < width * lod - 1 * lod; ++x)
+			m_vertices = {};
+			return;
+		}
+
+		const size_t vertexCount = GetVertexCount();
+
+		// Grid positions only depend on the chunk size, keep them when it did not change
+		if (m_vertices.size() == vertexCount)
+		{
+			for (size_t i = 0; i < vertexCount; ++i)
+				m_vertices[i].height = ChunkVertex::PackHeight(m_heightMap[i], m_vertexMinHeight, m_vertexHeightScale);
+			return;
+		}
+
+		m_vertices.clear();
+		m_vertices.resize(vertexCount);
+
+		for (int z = 0; z < height * lod; ++z)
+		{
+			for (int x = 0; x < width * lod; ++x)
 			{
-				const size_t index = (x + z * (width * lod - 1 * lod)) * 6;
-				m_indices[index] = x + z * width * lod;
-				m_indices[index + 1] = x + (z + 1) * width * lod;
-				m_indices[index + 2] = x + 1 + z * width * lod;
-				m_indices[index + 3] = x + 1 + z * width * lod;
-				m_indices[index + 4] = x + (z + 1) * width * lod;
-				m_indices[index + 5] = x + 1 + (z + 1) * width * lod;
+				const size_t index = x + z * width * lod;
+				m_vertices[index] = { static_cast<uint16_t>(x), static_cast<uint16_t>(z), ChunkVertex::PackHeight(m_heightMap[index], m_vertexMinHeight, m_vertexHeightScale) };
 			}
 		}
 	}
@@ -104,10 +335,20 @@ public:
 	int lod = 1;
 
 private:
-    std::vector<float> m_vertices;
-    std::vector<uint32_t> m_indices;
+    std::vector<ChunkVertex> m_vertices;
 
 	HeightMap m_heightMap;
+
+	LayerStages m_continentalnessStages;
+	LayerStages m_erosionStages;
+	uint64_t m_blendKey = 0;
+
+	float m_minHeight = 0.f;
+	float m_maxHeight = 0.f;
+	float m_vertexMinHeight = 0.f;
+	float m_vertexHeightScale = 0.f;
+	std::vector<float> m_levelErrors;
+	std::vector<float> m_adaptiveErrors;
     std::shared_ptr<VertexArray> m_vertexArray;
 
 
@@ -0,0 +1,315 @@
+#include "ChunkArena.h"
+
+#include <algorithm>
+#include <set>
+
+#include "Chunk.h"
+#include "GeoMipmap.h"
+#include "../OpenGl/Renderer/Renderer.h"
+
+namespace
+{
+	constexpr uint32_t kVertexSize = sizeof(ChunkVertex);
+
+	// 128 vertices are 768 bytes, a multiple of any shader storage offset alignment up to 256
+	constexpr uint32_t kVertexAlignment = 128;
+	constexpr uint32_t kInitialVertexCapacity = 1 << 16;
+
+	uint32_t AlignVertices(size_t count)
+	{
+		return static_cast<uint32_t>((count + kVertexAlignment - 1) / kVertexAlignment * kVertexAlignment);
+	}
+}
+
+void ChunkArena::Update(const std::vector<const Chunk*>& chunks)
+{
+	++m_frame;
+
+	std::set<SizeKey> usedSizes;
+	for (const Chunk* chunk : chunks)
+	{
+		Allocation& allocation = Allocate(*chunk);
+		allocation.frame = m_frame;
+
+		const std::vector<ChunkVertex>& vertices = chunk->GetVertices();
+		if (!vertices.empty() && allocation.heightKey != chunk->GetHeightKey())
+		{
+			m_vertexBuffer->SetData(vertices.data(), static_cast<uint32_t>(sizeof(ChunkVertex) * vertices.size()), allocation.firstVertex * kVertexSize);
+			allocation.heightKey = chunk->GetHeightKey();
+		}
+
+		usedSizes.insert({ chunk->width, chunk->height, chunk->lod });
+		GetIndexRanges(chunk->width, chunk->height, chunk->lod);
+	}
+
+	m_allocations.EraseIf([this](ChunkCoord, const Allocation& allocation)
+	{
+		if (allocation.frame == m_frame)
+			return false;
+
+		FreeVertices(allocation.firstVertex, allocation.vertexCount);
+		return true;
+	});
+
+	// Index ranges of the sizes no chunk has anymore are dropped and the variants built for the others packed again
+	if (std::erase_if(m_indexRanges, [&usedSizes](const auto& entry) { return !usedSizes.contains(entry.first); }) > 0)
+	{
+		std::vector<std::pair<SizeKey, int>> variants;
+		for (const auto& [size, ranges] : m_indexRanges)
+		{
+			for (size_t variant = 0; variant < ranges.size(); ++variant)
+			{
+				if (ranges[variant].count > 0)
+					variants.emplace_back(size, static_cast<int>(variant));
+			}
+		}
+
+		m_indexRanges.clear();
+		m_indices.clear();
+		for (const auto& [size, variant] : variants)
+		{
+			const auto& [width, height, lod] = size;
+			GetIndexRange(width, height, lod, variant);
+		}
+	}
+}
+
+void ChunkArena::Upload(const Chunk& chunk, const StagingRing::Allocation& staging, StagingRing& stagingRing)
+{
+	Allocation& allocation = Allocate(chunk);
+	stagingRing.Copy(staging, m_vertexBuffer->GetRendererID(), m_vertexBuffer->GetOffset() + static_cast<GLintptr>(allocation.firstVertex) * kVertexSize);
+	allocation.heightKey = chunk.GetHeightKey();
+
+	GetIndexRanges(chunk.width, chunk.height, chunk.lod);
+}
+
+ChunkArena::VertexRange ChunkArena::GetVertexRange(const Chunk& chunk)
+{
+	Allocation& allocation = Allocate(chunk);
+
+	// Written on the GPU, the next CPU vertices of the chunk are uploaded whatever their key
+	allocation.heightKey = 0;
+
+	GetIndexRanges(chunk.width, chunk.height, chunk.lod);
+	// The whole allocation, the compute shader writes vertices in pairs of three words and an odd last one
+	// spills into the padding
+	return { m_vertexBuffer->GetRendererID(), m_vertexBuffer->GetOffset() + static_cast<GLintptr>(allocation.firstVertex) * kVertexSize, static_cast<GLsizeiptr>(allocation.vertexCount) * kVertexSize };
+}
+
+uint32_t ChunkArena::GetIndexCount(const Chunk& chunk, int variant)
+{
+	return m_indexRanges.contains({ chunk.width, chunk.height, chunk.lod }) ? GetIndexRange(chunk.width, chunk.height, chunk.lod, variant).count : 0;
+}
+
+void ChunkArena::BeginFrame()
+{
+	m_frameCommands.clear();
+	m_frameBounds.clear();
+	m_framePlacements.clear();
+}
+
+void ChunkArena::AddDraw(const Chunk& chunk, int variant)
+{
+	const Allocation* allocation = m_allocations.Find({ chunk.x, chunk.z });
+	if (!allocation || !m_indexRanges.contains({ chunk.width, chunk.height, chunk.lod }))
+		return;
+
+	// Building the range can move the index buffer, its offset is read after
+	const IndexRange range = GetIndexRange(chunk.width, chunk.height, chunk.lod, variant);
+	const auto indexOffset = static_cast<uint32_t>(m_indexBuffer->GetOffset() / sizeof(uint32_t));
+
+	// baseInstance numbers the draws, so a shader can find per chunk data with gl_BaseInstance
+	m_frameCommands.push_back({ range.count, 1, indexOffset + range.firstIndex, static_cast<int32_t>(allocation->firstVertex), static_cast<uint32_t>(m_frameCommands.size()) });
+	m_frameBounds.push_back(chunk.GetBoundsMin());
+	m_frameBounds.push_back(chunk.GetBoundsMax());
+
+	// A ChunkPlacement of the MapIndirect shader: the grid, then the range its vertex heights are normalized over
+	const glm::vec3 origin = chunk.GetBoundsMin();
+	m_framePlacements.emplace_back(origin.x, origin.z, 1.f / static_cast<float>(chunk.lod), 0.f);
+	m_framePlacements.emplace_back(chunk.GetVertexMinHeight(), chunk.GetVertexHeightScale(), 0.f, 0.f);
+}
+
+void ChunkArena::Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform)
+{
+	if (!m_vertexArray || m_frameCommands.empty())
+		return;
+
+	if (!m_commands)
+		m_commands = IndirectBuffer::Create();
+
+	m_commands->SetCommands(m_frameCommands);
+	Renderer::SubmitIndirect(shader, m_vertexArray, m_commands, textures, transform, UploadPlacements());
+}
+
+DrawState ChunkArena::UploadPlacements()
+{
+	if (!m_placements)
+		m_placements = ShaderStorageBuffer::Create(sizeof(glm::vec4) * 2 * 64, kPlacementBinding);
+
+	m_placements->SetData(m_framePlacements.data(), static_cast<uint32_t>(m_framePlacements.size() * sizeof(glm::vec4)));
+
+	DrawState state;
+	state.storageBuffer = m_placements->GetRendererID();
+	state.storageBinding = kPlacementBinding;
+	return state;
+}
+
+void ChunkArena::Clear()
+{
+	m_vertexBuffer.reset();
+	m_indexBuffer.reset();
+	m_vertexArray.reset();
+	m_commands.reset();
+	m_placements.reset();
+
+	m_vertexCapacity = 0;
+	m_usedVertexCount = 0;
+	m_freeVertices.clear();
+	m_allocations.Clear();
+	m_indexRanges.clear();
+	m_indices.clear();
+	m_frameCommands.clear();
+	m_frameBounds.clear();
+}
+
+ChunkArena::Allocation& ChunkArena::Allocate(const Chunk& chunk)
+{
+	const uint32_t vertexCount = AlignVertices(chunk.GetVertexCount());
+
+	Allocation* allocation = m_allocations.Find({ chunk.x, chunk.z });
+	if (allocation && allocation->vertexCount == vertexCount)
+		return *allocation;
+
+	if (allocation)
+		FreeVertices(allocation->firstVertex, allocation->vertexCount);
+	else
+		allocation = &m_allocations.Insert({ chunk.x, chunk.z });
+
+	allocation->firstVertex = AllocateVertices(vertexCount);
+	allocation->vertexCount = vertexCount;
+	allocation->heightKey = 0;
+	return *allocation;
+}
+
+uint32_t ChunkArena::AllocateVertices(uint32_t count)
+{
+	// First fit, chunks mostly share one size so the free ranges are reused whole
+	for (auto range = m_freeVertices.begin(); range != m_freeVertices.end(); ++range)
+	{
+		if (range->second < count)
+			continue;
+
+		const uint32_t firstVertex = range->first;
+		const uint32_t remaining = range->second - count;
+		m_freeVertices.erase(range);
+		if (remaining > 0)
+			m_freeVertices.emplace(firstVertex + count, remaining);
+
+		m_usedVertexCount += count;
+		return firstVertex;
+	}
+
+	GrowVertices(m_vertexCapacity + count);
+	return AllocateVertices(count);
+}
+
+void ChunkArena::FreeVertices(uint32_t firstVertex, uint32_t count)
+{
+	m_usedVertexCount -= count;
+	AddFreeRange(firstVertex, count);
+}
+
+void ChunkArena::AddFreeRange(uint32_t firstVertex, uint32_t count)
+{
+	auto next = m_freeVertices.lower_bound(firstVertex);
+	if (next != m_freeVertices.end() && firstVertex + count == next->first)
+	{
+		count += next->second;
+		next = m_freeVertices.erase(next);
+	}
+
+	if (next != m_freeVertices.begin())
+	{
+		const auto previous = std::prev(next);
+		if (previous->first + previous->second == firstVertex)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+
+	m_freeVertices.emplace(firstVertex, count);
+}
+
+void ChunkArena::GrowVertices(uint32_t minimumCapacity)
+{
+	const uint32_t capacity = std::max({ minimumCapacity, m_vertexCapacity * 2, kInitialVertexCapacity });
+
+	auto vertexBuffer = VertexBuffer::Create(capacity * kVertexSize);
+	vertexBuffer->SetLayout(Chunk::GetVertexLayout());
+
+	// The allocations keep their offsets, the old vertices are copied on the GPU
+	if (m_vertexBuffer)
+		glCopyNamedBufferSubData(m_vertexBuffer->GetRendererID(), vertexBuffer->GetRendererID(), m_vertexBuffer->GetOffset(), vertexBuffer->GetOffset(), static_cast<GLsizeiptr>(m_vertexCapacity) * kVertexSize);
+	m_vertexBuffer = vertexBuffer;
+
+	AddFreeRange(m_vertexCapacity, capacity - m_vertexCapacity);
+	m_vertexCapacity = capacity;
+
+	RebuildVertexArray();
+}
+
+std::vector<ChunkArena::IndexRange>& ChunkArena::GetIndexRanges(int width, int height, int lod)
+{
+	auto& ranges = m_indexRanges[{ width, height, lod }];
+	if (ranges.empty())
+		ranges.resize(static_cast<size_t>(GeoMipmap::GetLevelCount(width, height, lod)) * GeoMipmap::kStitchVariants);
+	return ranges;
+}
+
+const ChunkArena::IndexRange& ChunkArena::GetIndexRange(int width, int height, int lod, int variant)
+{
+	IndexRange& range = GetIndexRanges(width, height, lod)[variant];
+	if (range.count > 0)
+		return range;
+
+	const int level = variant / GeoMipmap::kStitchVariants;
+	const auto stitchMask = static_cast<uint8_t>(variant % GeoMipmap::kStitchVariants);
+	const auto indices = GeoMipmap::GenerateIndices<uint32_t>(width, height, lod, level, stitchMask);
+	range = { static_cast<uint32_t>(m_indices.size()), static_cast<uint32_t>(indices.size()) };
+	m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+
+	// Growing moves the indices, the commands already added this frame follow them
+	const GLintptr previousOffset = m_indexBuffer ? m_indexBuffer->GetOffset() : 0;
+	UploadIndices();
+	if (m_indexBuffer->GetOffset() != previousOffset)
+	{
+		const auto delta = static_cast<int64_t>(m_indexBuffer->GetOffset() - previousOffset) / static_cast<int64_t>(sizeof(uint32_t));
+		for (DrawElementsIndirectCommand& command : m_frameCommands)
+			command.firstIndex = static_cast<uint32_t>(command.firstIndex + delta);
+	}
+	return range;
+}
+
+void ChunkArena::UploadIndices()
+{
+	// The vertex array follows the index range when it is moved to grow
+	if (m_indexBuffer)
+	{
+		m_indexBuffer->SetData(m_indices.data(), static_cast<uint32_t>(m_indices.size()));
+		return;
+	}
+
+	m_indexBuffer = IndexBuffer::Create(m_indices.data(), static_cast<uint32_t>(m_indices.size()));
+	RebuildVertexArray();
+}
+
+void ChunkArena::RebuildVertexArray()
+{
+	if (!m_vertexBuffer || !m_indexBuffer)
+		return;
+
+	m_vertexArray = VertexArray::Create();
+	m_vertexArray->AddVertexBuffer(m_vertexBuffer);
+	m_vertexArray->SetIndexBuffer(m_indexBuffer);
+}
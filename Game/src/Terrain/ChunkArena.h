@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkMap.h"
+#include "../OpenGl/Buffer/IndirectBuffer.h"
+#include "../OpenGl/Buffer/ShaderStorageBuffer.h"
+#include "../OpenGl/Buffer/StagingRing.h"
+#include "../OpenGl/Buffer/VertexArray.h"
+#include "../OpenGl/Renderer/RenderQueue.h"
+#include "../OpenGl/Shader/Shader.h"
+#include "../OpenGl/Texture/Texture.h"
+
+class Chunk;
+
+// Geometry of all the chunks packed into one vertex buffer and one index buffer, drawn by a single
+// glMultiDrawElementsIndirect. A chunk is a range of the vertex buffer (its base vertex) and draws the
+// index range of its size and geomipmap variant (its first index), stored once for all the chunks of that size
+// the first time a chunk draws it.
+// Must be used from the thread owning the GL context.
+class ChunkArena
+{
+public:
+	// Shader storage binding of the placement of each draw, read with gl_BaseInstance by the MapIndirect shader
+	static constexpr uint32_t kPlacementBinding = 3;
+
+	// Vertices of a chunk in the vertex buffer, in bytes
+	struct VertexRange
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	// Uploads the vertices of the chunks whose heights changed and releases the chunks missing from the list.
+	// Chunks without CPU vertices only get their range, written on the GPU through GetVertexRange
+	void Update(const std::vector<const Chunk*>& chunks);
+
+	// Copies the vertices a worker staged for the chunk, Update then skips them
+	void Upload(const Chunk& chunk, const StagingRing::Allocation& staging, StagingRing& stagingRing);
+
+	// Allocated when missing, the offset is aligned for glBindBufferRange on a shader storage buffer.
+	// Allocating another chunk can move the vertices to a new buffer, which invalidates the range
+	VertexRange GetVertexRange(const Chunk& chunk);
+
+	// Indices drawn by a chunk of Update at a geomipmap variant (see GeoMipmap::MeshSelection), built when missing
+	uint32_t GetIndexCount(const Chunk& chunk, int variant);
+
+	// Commands of the frame: BeginFrame, one AddDraw per chunk of Update to draw, then Draw
+	void BeginFrame();
+	void AddDraw(const Chunk& chunk, int variant);
+	void Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform);
+
+	// Uploads the origin, sample spacing and vertex height range of the chunks of the frame, returns the state binding them for
+	// the draw. Draw does it for its own draw
+	DrawState UploadPlacements();
+
+	void Clear();
+
+	// Commands of the frame and the bounds of their chunks (min then max), for culling them on the GPU
+	[[nodiscard]] const std::vector<DrawElementsIndirectCommand>& GetFrameCommands() const { return m_frameCommands; }
+	[[nodiscard]] const std::vector<glm::vec3>& GetFrameBounds() const { return m_frameBounds; }
+	[[nodiscard]] const std::shared_ptr<VertexArray>& GetVertexArray() const { return m_vertexArray; }
+
+	[[nodiscard]] size_t GetDrawCount() const { return m_frameCommands.size(); }
+	[[nodiscard]] size_t GetUsedVertexCount() const { return m_usedVertexCount; }
+	[[nodiscard]] size_t GetVertexCapacity() const { return m_vertexCapacity; }
+
+private:
+	struct Allocation
+	{
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint64_t heightKey = 0;
+		uint32_t frame = 0;
+	};
+
+	// Not built yet while count is 0
+	struct IndexRange
+	{
+		uint32_t firstIndex = 0;
+		uint32_t count = 0;
+	};
+
+	using SizeKey = std::tuple<int, int, int>;
+
+	Allocation& Allocate(const Chunk& chunk);
+	uint32_t AllocateVertices(uint32_t count);
+	void FreeVertices(uint32_t firstVertex, uint32_t count);
+	void AddFreeRange(uint32_t firstVertex, uint32_t count);
+	void GrowVertices(uint32_t minimumCapacity);
+
+	// Every variant of a size, only the ones GetIndexRange built have indices
+	std::vector<IndexRange>& GetIndexRanges(int width, int height, int lod);
+	const IndexRange& GetIndexRange(int width, int height, int lod, int variant);
+	void UploadIndices();
+	void RebuildVertexArray();
+
+	std::shared_ptr<VertexBuffer> m_vertexBuffer;
+	std::shared_ptr<IndexBuffer> m_indexBuffer;
+	std::shared_ptr<VertexArray> m_vertexArray;
+	std::shared_ptr<IndirectBuffer> m_commands;
+
+	uint32_t m_vertexCapacity = 0;
+	size_t m_usedVertexCount = 0;
+
+	// First vertex -> vertex count of the free ranges, coalesced
+	std::map<uint32_t, uint32_t> m_freeVertices;
+
+	ChunkMap<Allocation> m_allocations;
+	uint32_t m_frame = 0;
+
+	// Geomipmap variants of the chunk sizes in use, indices are relative to the first vertex of a chunk
+	std::map<SizeKey, std::vector<IndexRange>> m_indexRanges;
+	std::vector<uint32_t> m_indices;
+
+	std::vector<DrawElementsIndirectCommand> m_frameCommands;
+	std::vector<glm::vec3> m_frameBounds;
+	std::vector<glm::vec4> m_framePlacements;
+	std::shared_ptr<ShaderStorageBuffer> m_placements;
+};
@@ -0,0 +1,274 @@
+#include "ChunkInstancer.h"
+
+#include <algorithm>
+
+#include "Chunk.h"
+#include "GeoMipmap.h"
+#include "../OpenGl/Renderer/Renderer.h"
+
+namespace
+{
+	constexpr uint32_t kInitialLayerCapacity = 16;
+	constexpr uint32_t kInitialInstanceCapacity = 256;
+}
+
+ChunkInstancer::~ChunkInstancer()
+{
+	glDeleteTextures(1, &m_heights);
+}
+
+void ChunkInstancer::Update(const std::vector<const Chunk*>& chunks)
+{
+	++m_frame;
+
+	for (const Chunk* chunk : chunks)
+	{
+		if (chunk->GetHeightMap().empty())
+			continue;
+
+		if (chunk->width != m_width || chunk->height != m_height || chunk->lod != m_lod)
+			Reset(chunk->width, chunk->height, chunk->lod);
+
+		Layer* layer = m_layers.Find({ chunk->x, chunk->z });
+		if (!layer)
+		{
+			uint32_t index;
+			if (!AllocateLayer(index))
+				continue;
+
+			layer = &m_layers.Insert({ chunk->x, chunk->z });
+			layer->index = index;
+			layer->heightKey = 0;
+		}
+
+		layer->frame = m_frame;
+		if (layer->heightKey != chunk->GetHeightKey())
+		{
+			glTextureSubImage3D(m_heights, 0, 0, 0, static_cast<GLint>(layer->index), m_samples.x, m_samples.y, 1, GL_RED, GL_FLOAT, chunk->GetHeightMap().data());
+			layer->heightKey = chunk->GetHeightKey();
+		}
+	}
+
+	m_layers.EraseIf([this](ChunkCoord, const Layer& layer)
+	{
+		if (layer.frame == m_frame)
+			return false;
+
+		m_freeLayers.push_back(layer.index);
+		--m_layerCount;
+		return true;
+	});
+}
+
+uint32_t ChunkInstancer::GetIndexCount(int variant)
+{
+	return variant < static_cast<int>(m_indexRanges.size()) ? GetIndexRange(variant).count : 0;
+}
+
+void ChunkInstancer::BeginFrame()
+{
+	m_frameInstances.clear();
+	m_frameCommands.clear();
+}
+
+bool ChunkInstancer::AddDraw(const Chunk& chunk, int variant)
+{
+	const Layer* layer = m_layers.Find({ chunk.x, chunk.z });
+	if (!layer || variant >= static_cast<int>(m_indexRanges.size()))
+		return false;
+
+	// Built before Draw reads the offset of the index buffer
+	GetIndexRange(variant);
+
+	m_frameInstances.push_back({ variant, { chunk.x * (chunk.width - 1), chunk.z * (chunk.height - 1), static_cast<int32_t>(layer->index) } });
+	return true;
+}
+
+void ChunkInstancer::Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform)
+{
+	if (!m_grid || m_frameInstances.empty())
+		return;
+
+	// The instances of a variant are contiguous, one command draws them all
+	std::ranges::stable_sort(m_frameInstances, {}, &std::pair<int, Instance>::first);
+
+	const auto indexOffset = static_cast<uint32_t>(m_indexBuffer->GetOffset() / sizeof(uint32_t));
+	m_instances.clear();
+	m_frameCommands.clear();
+	int commandVariant = -1;
+	for (const auto& [variant, instance] : m_frameInstances)
+	{
+		if (variant != commandVariant)
+		{
+			const IndexRange& range = m_indexRanges[variant];
+			m_frameCommands.push_back({ range.count, 0, indexOffset + range.firstIndex, 0, static_cast<uint32_t>(m_instances.size()) });
+			commandVariant = variant;
+		}
+
+		++m_frameCommands.back().instanceCount;
+		m_instances.push_back(instance);
+	}
+
+	if (m_instances.size() > m_instanceCapacity)
+	{
+		m_instanceCapacity = std::max(static_cast<uint32_t>(m_instances.size()), m_instanceCapacity * 2);
+		m_instanceBuffer = VertexBuffer::Create(static_cast<uint32_t>(m_instanceCapacity * sizeof(Instance)));
+		m_instanceBuffer->SetLayout({
+			{ ShaderDataType::Int2, "a_ChunkOffset" },
+			{ ShaderDataType::Int, "a_Layer" },
+		});
+		RebuildVertexArray();
+	}
+	m_instanceBuffer->SetData(m_instances.data(), static_cast<uint32_t>(m_instances.size() * sizeof(Instance)));
+
+	if (!m_commands)
+		m_commands = IndirectBuffer::Create();
+	m_commands->SetCommands(m_frameCommands);
+
+	const TextureBinding heights[] = { { m_heights, "u_Heights" } };
+	const UniformValue uniforms[] = { { "u_SampleSpacing", 1.f / static_cast<float>(m_lod) } };
+
+	DrawState state;
+	state.textures = heights;
+	state.uniforms = uniforms;
+	Renderer::SubmitIndirect(shader, m_vertexArray, m_commands, textures, transform, state);
+}
+
+void ChunkInstancer::Clear()
+{
+	glDeleteTextures(1, &m_heights);
+	m_heights = 0;
+
+	m_width = m_height = m_lod = 0;
+	m_layerCapacity = 0;
+	m_layerCount = 0;
+	m_freeLayers.clear();
+	m_layers.Clear();
+
+	m_grid.reset();
+	m_indexBuffer.reset();
+	m_indexRanges.clear();
+	m_indices.clear();
+	m_instanceBuffer.reset();
+	m_instanceCapacity = 0;
+	m_vertexArray.reset();
+	m_commands.reset();
+	m_frameInstances.clear();
+	m_frameCommands.clear();
+}
+
+size_t ChunkInstancer::GetMemorySize() const
+{
+	const size_t heights = static_cast<size_t>(m_samples.x) * m_samples.y * m_layerCapacity * sizeof(float);
+	const size_t grid = m_grid ? static_cast<size_t>(m_grid->GetSize()) : 0;
+	const size_t indices = m_indexBuffer ? m_indexBuffer->GetCount() * sizeof(uint32_t) : 0;
+	return heights + grid + indices;
+}
+
+void ChunkInstancer::Reset(int width, int height, int lod)
+{
+	Clear();
+
+	m_width = width;
+	m_height = height;
+	m_lod = lod;
+	m_samples = { width * lod, height * lod };
+
+	// Sample positions within the chunk, 4 bytes each and shared by all the instances
+	std::vector<uint16_t> grid;
+	grid.reserve(static_cast<size_t>(m_samples.x) * m_samples.y * 2);
+	for (int z = 0; z < m_samples.y; ++z)
+	{
+		for (int x = 0; x < m_samples.x; ++x)
+		{
+			grid.push_back(static_cast<uint16_t>(x));
+			grid.push_back(static_cast<uint16_t>(z));
+		}
+	}
+
+	m_grid = VertexBuffer::Create(grid.data(), static_cast<uint32_t>(grid.size() * sizeof(uint16_t)));
+	m_grid->SetLayout({ { ShaderDataType::UShort2, "a_GridPosition" } });
+
+	m_indexRanges.resize(static_cast<size_t>(GeoMipmap::GetLevelCount(width, height, lod)) * GeoMipmap::kStitchVariants);
+	GetIndexRange(0);
+
+	m_instanceCapacity = kInitialInstanceCapacity;
+	m_instanceBuffer = VertexBuffer::Create(static_cast<uint32_t>(m_instanceCapacity * sizeof(Instance)));
+	m_instanceBuffer->SetLayout({
+		{ ShaderDataType::Int2, "a_ChunkOffset" },
+		{ ShaderDataType::Int, "a_Layer" },
+	});
+	RebuildVertexArray();
+}
+
+const ChunkInstancer::IndexRange& ChunkInstancer::GetIndexRange(int variant)
+{
+	IndexRange& range = m_indexRanges[variant];
+	if (range.count > 0)
+		return range;
+
+	const int level = variant / GeoMipmap::kStitchVariants;
+	const auto stitchMask = static_cast<uint8_t>(variant % GeoMipmap::kStitchVariants);
+	const auto indices = GeoMipmap::GenerateIndices<uint32_t>(m_width, m_height, m_lod, level, stitchMask);
+	range = { static_cast<uint32_t>(m_indices.size()), static_cast<uint32_t>(indices.size()) };
+	m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+
+	// The vertex array follows the index buffer when it grows
+	if (m_indexBuffer)
+		m_indexBuffer->SetData(m_indices.data(), static_cast<uint32_t>(m_indices.size()));
+	else
+		m_indexBuffer = IndexBuffer::Create(m_indices.data(), static_cast<uint32_t>(m_indices.size()));
+	return range;
+}
+
+bool ChunkInstancer::AllocateLayer(uint32_t& index)
+{
+	if (m_freeLayers.empty())
+	{
+		GLint maxLayers = 0;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		if (m_layerCapacity >= static_cast<uint32_t>(maxLayers))
+			return false;
+
+		GrowLayers();
+	}
+
+	index = m_freeLayers.back();
+	m_freeLayers.pop_back();
+	++m_layerCount;
+	return true;
+}
+
+void ChunkInstancer::GrowLayers()
+{
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	const uint32_t capacity = std::min(std::max(m_layerCapacity * 2, kInitialLayerCapacity), static_cast<uint32_t>(maxLayers));
+
+	GLuint heights;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &heights);
+	glTextureStorage3D(heights, 1, GL_R32F, m_samples.x, m_samples.y, static_cast<GLsizei>(capacity));
+	glTextureParameteri(heights, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(heights, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// The layers keep their index, the old heights are copied on the GPU
+	if (m_heights)
+	{
+		glCopyImageSubData(m_heights, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, heights, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, m_samples.x, m_samples.y, static_cast<GLsizei>(m_layerCapacity));
+		glDeleteTextures(1, &m_heights);
+	}
+	m_heights = heights;
+
+	// Handed out from the lowest index
+	for (uint32_t layer = capacity; layer > m_layerCapacity; --layer)
+		m_freeLayers.push_back(layer - 1);
+	m_layerCapacity = capacity;
+}
+
+void ChunkInstancer::RebuildVertexArray()
+{
+	m_vertexArray = VertexArray::Create();
+	m_vertexArray->AddVertexBuffer(m_grid);
+	m_vertexArray->AddVertexBuffer(m_instanceBuffer, 1);
+	m_vertexArray->SetIndexBuffer(m_indexBuffer);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ChunkMap.h"
+#include "../OpenGl/Buffer/IndirectBuffer.h"
+#include "../OpenGl/Buffer/VertexArray.h"
+#include "../OpenGl/Shader/Shader.h"
+#include "../OpenGl/Texture/Texture.h"
+
+class Chunk;
+
+// Draws every chunk as an instance of one grid mesh, its heights read in the vertex shader from its layer
+// of a GL_TEXTURE_2D_ARRAY. An instance is only the chunk offset and its layer, the chunks sharing a geomipmap
+// variant are one instanced command of a single glMultiDrawElementsIndirect. The chunks need no vertices,
+// see ChunkGenerationParameters::generateVertices. Only one chunk size is drawn at a time, Update starts over when it changes.
+// Chunks beyond GL_MAX_ARRAY_TEXTURE_LAYERS get no layer and are not drawn.
+// Must be used from the thread owning the GL context.
+class ChunkInstancer
+{
+public:
+	ChunkInstancer() = default;
+	~ChunkInstancer();
+
+	ChunkInstancer(const ChunkInstancer&) = delete;
+	ChunkInstancer& operator=(const ChunkInstancer&) = delete;
+
+	// Uploads the heights of the chunks that changed and releases the layers of the chunks missing from the list.
+	// Chunks without CPU heights (generated on the GPU) are skipped
+	void Update(const std::vector<const Chunk*>& chunks);
+
+	// Indices drawn by a chunk of Update at a geomipmap variant (see GeoMipmap::MeshSelection), built when missing
+	uint32_t GetIndexCount(int variant);
+
+	// Instances of the frame: BeginFrame, one AddDraw per chunk of Update to draw, then Draw.
+	// The height array is bound after the given textures. AddDraw fails for a chunk without a layer
+	void BeginFrame();
+	bool AddDraw(const Chunk& chunk, int variant);
+	void Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform);
+
+	void Clear();
+
+	[[nodiscard]] size_t GetInstanceCount() const { return m_frameInstances.size(); }
+	[[nodiscard]] size_t GetCommandCount() const { return m_frameCommands.size(); }
+	[[nodiscard]] size_t GetLayerCount() const { return m_layerCount; }
+	[[nodiscard]] size_t GetLayerCapacity() const { return m_layerCapacity; }
+
+	// Heights and shared grid, the whole mesh data of the chunks
+	[[nodiscard]] size_t GetMemorySize() const;
+
+private:
+	struct Layer
+	{
+		uint32_t index = 0;
+		uint64_t heightKey = 0;
+		uint32_t frame = 0;
+	};
+
+	// Per instance attributes, a_ChunkOffset and a_Layer of the MapInstanced shader
+	struct Instance
+	{
+		int32_t x;
+		int32_t z;
+		int32_t layer;
+	};
+
+	// Not built yet while count is 0
+	struct IndexRange
+	{
+		uint32_t firstIndex = 0;
+		uint32_t count = 0;
+	};
+
+	// Builds the grid and the full grid indices of the chunk size, every layer is released
+	void Reset(int width, int height, int lod);
+
+	// The other geomipmap variants are appended the first time a chunk draws them
+	const IndexRange& GetIndexRange(int variant);
+
+	// False when the array reached the layer limit of the GL
+	bool AllocateLayer(uint32_t& index);
+	void GrowLayers();
+	void RebuildVertexArray();
+
+	int m_width = 0;
+	int m_height = 0;
+	int m_lod = 0;
+	glm::ivec2 m_samples{ 0 };
+
+	GLuint m_heights = 0;
+	uint32_t m_layerCapacity = 0;
+	uint32_t m_layerCount = 0;
+	std::vector<uint32_t> m_freeLayers;
+	ChunkMap<Layer> m_layers;
+	uint32_t m_frame = 0;
+
+	std::shared_ptr<VertexBuffer> m_grid;
+	std::shared_ptr<IndexBuffer> m_indexBuffer;
+	std::vector<IndexRange> m_indexRanges;
+	std::vector<uint32_t> m_indices;
+
+	std::shared_ptr<VertexBuffer> m_instanceBuffer;
+	uint32_t m_instanceCapacity = 0;
+	std::shared_ptr<VertexArray> m_vertexArray;
+	std::shared_ptr<IndirectBuffer> m_commands;
+
+	// Variant of every instance of the frame, sorted by Draw
+	std::vector<std::pair<int, Instance>> m_frameInstances;
+	std::vector<Instance> m_instances;
+	std::vector<DrawElementsIndirectCommand> m_frameCommands;
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct ChunkCoord
+{
+	int x = 0;
+	int z = 0;
+
+	bool operator==(const ChunkCoord&) const = default;
+};
+
+// Open addressing hash map from chunk coordinates to Value with linear probing.
+// Erase shifts the following entries back instead of leaving tombstones, so lookups stay short
+// while the streamer keeps loading and evicting. Pointers to values are invalidated by Insert and Erase.
+template<typename Value>
+class ChunkMap
+{
+public:
+	explicit ChunkMap(size_t capacity = 64)
+	{
+		size_t slotCount = 16;
+		while (slotCount < capacity * 2)
+			slotCount *= 2;
+		m_slots.resize(slotCount);
+	}
+
+	Value* Find(ChunkCoord coord)
+	{
+		const size_t index = FindSlot(coord);
+		return m_slots[index].occupied ? &m_slots[index].value : nullptr;
+	}
+
+	const Value* Find(ChunkCoord coord) const
+	{
+		const size_t index = FindSlot(coord);
+		return m_slots[index].occupied ? &m_slots[index].value : nullptr;
+	}
+
+	// Returns the value of coord, default constructed when it was missing
+	Value& Insert(ChunkCoord coord)
+	{
+		// Keep the load factor under 1/2
+		if ((m_size + 1) * 2 > m_slots.size())
+			Rehash(m_slots.size() * 2);
+
+		Slot& slot = m_slots[FindSlot(coord)];
+		if (!slot.occupied)
+		{
+			slot.coord = coord;
+			slot.occupied = true;
+			slot.value = Value{};
+			++m_size;
+		}
+
+		return slot.value;
+	}
+
+	bool Erase(ChunkCoord coord)
+	{
+		size_t hole = FindSlot(coord);
+		if (!m_slots[hole].occupied)
+			return false;
+
+		const size_t mask = m_slots.size() - 1;
+		for (size_t next = (hole + 1) & mask; m_slots[next].occupied; next = (next + 1) & mask)
+		{
+			// An entry can fill the hole if its home slot is not between the hole and itself
+			const size_t home = HomeSlot(m_slots[next].coord);
+			if (((next - home) & mask) >= ((next - hole) & mask))
+			{
+				m_slots[hole].coord = m_slots[next].coord;
+				m_slots[hole].value = std::move(m_slots[next].value);
+				hole = next;
+			}
+		}
+
+		m_slots[hole].occupied = false;
+		m_slots[hole].value = Value{};
+		--m_size;
+		return true;
+	}
+
+	void Clear()
+	{
+		for (auto& slot : m_slots)
+		{
+			slot.occupied = false;
+			slot.value = Value{};
+		}
+		m_size = 0;
+	}
+
+	// function(ChunkCoord, Value&), the map must not be modified meanwhile
+	template<typename Function>
+	void ForEach(Function&& function)
+	{
+		for (auto& slot : m_slots)
+		{
+			if (slot.occupied)
+				function(slot.coord, slot.value);
+		}
+	}
+
+	template<typename Predicate>
+	size_t EraseIf(Predicate&& predicate)
+	{
+		std::vector<ChunkCoord> erased;
+		ForEach([&](ChunkCoord coord, Value& value)
+		{
+			if (predicate(coord, value))
+				erased.push_back(coord);
+		});
+
+		for (const ChunkCoord coord : erased)
+			Erase(coord);
+
+		return erased.size();
+	}
+
+	[[nodiscard]] size_t Size() const { return m_size; }
+
+	[[nodiscard]] size_t Capacity() const { return m_slots.size(); }
+
+private:
+	struct Slot
+	{
+		ChunkCoord coord;
+		bool occupied = false;
+		Value value{};
+	};
+
+	[[nodiscard]] size_t HomeSlot(ChunkCoord coord) const
+	{
+		const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+
+		// Fibonacci hashing spreads neighbouring coordinates over the whole table
+		return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (m_slots.size() - 1);
+	}
+
+	// Slot holding coord, or the empty slot where it would be inserted
+	[[nodiscard]] size_t FindSlot(ChunkCoord coord) const
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t index = HomeSlot(coord);
+		while (m_slots[index].occupied && !(m_slots[index].coord == coord))
+			index = (index + 1) & mask;
+
+		return index;
+	}
+
+	void Rehash(size_t slotCount)
+	{
+		std::vector<Slot> slots(slotCount);
+		std::swap(slots, m_slots);
+
+		for (auto& slot : slots)
+		{
+			if (!slot.occupied)
+				continue;
+
+			Slot& target = m_slots[FindSlot(slot.coord)];
+			target.coord = slot.coord;
+			target.occupied = true;
+			target.value = std::move(slot.value);
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size = 0;
+};
@@ -0,0 +1,147 @@
+#include "ChunkRegenerator.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	// A request starts once the parameters stayed the same for this long...
+	constexpr auto kDebounceDelay = std::chrono::milliseconds(100);
+
+	// ...or after this long while the user keeps dragging, unless a regeneration is still running
+	constexpr auto kMaxLatency = std::chrono::milliseconds(250);
+}
+
+ChunkRegenerator::~ChunkRegenerator()
+{
+	Cancel();
+}
+
+void ChunkRegenerator::Request(const ChunkGenerationParameters& parameters)
+{
+	const auto now = Clock::now();
+	if (!m_hasPendingRequest)
+		m_firstRequestTime = now;
+
+	m_pendingParameters = parameters;
+	m_hasPendingRequest = true;
+	m_lastRequestTime = now;
+}
+
+bool ChunkRegenerator::Poll(std::vector<Chunk>& chunks, std::vector<size_t>& chunksToUpload, std::vector<StagingRing::Allocation>& staging, bool& rebuilt)
+{
+	std::erase_if(m_cancelled, [](const std::unique_ptr<Task>& task) { return task->counter.IsDone(); });
+
+	if (m_hasPendingRequest)
+	{
+		const auto now = Clock::now();
+		const bool settled = now - m_lastRequestTime >= kDebounceDelay;
+		const bool overdue = !m_current && now - m_firstRequestTime >= kMaxLatency;
+		if (settled || overdue)
+			Launch(chunks);
+	}
+
+	// Jobs of cancelled tasks may still be copying chunks, they must stop before chunks is swapped
+	if (!m_current || !m_current->counter.IsDone() || !m_cancelled.empty())
+		return false;
+
+	chunks.swap(m_current->chunks);
+	rebuilt = m_current->rebuild;
+
+	chunksToUpload.clear();
+	staging.clear();
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		if (rebuilt || m_current->needsUpload[i])
+		{
+			chunksToUpload.push_back(i);
+			staging.push_back(std::move(m_current->staging[i]));
+		}
+	}
+
+	// The replaced chunks are released here, on the thread owning their buffers
+	m_current.reset();
+	return true;
+}
+
+void ChunkRegenerator::Cancel()
+{
+	m_hasPendingRequest = false;
+
+	if (m_current)
+	{
+		m_current->token.Cancel();
+		m_cancelled.push_back(std::move(m_current));
+	}
+
+	for (const auto& task : m_cancelled)
+		JobSystem::Get().Wait(task->counter);
+	m_cancelled.clear();
+}
+
+bool ChunkRegenerator::MatchesLayout(const std::vector<Chunk>& chunks, const ChunkGenerationParameters& parameters)
+{
+	if (chunks.size() != static_cast<size_t>(parameters.nbChunksX) * parameters.nbChunksZ)
+		return false;
+
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		const Chunk& chunk = chunks[i];
+		if (chunk.x != static_cast<int>(i) / parameters.nbChunksZ || chunk.z != static_cast<int>(i) % parameters.nbChunksZ
+			|| chunk.width != parameters.chunkSize || chunk.height != parameters.chunkSize || chunk.lod != parameters.lod)
+			return false;
+	}
+
+	return true;
+}
+
+void ChunkRegenerator::Launch(const std::vector<Chunk>& chunks)
+{
+	if (m_current)
+	{
+		m_current->token.Cancel();
+		m_cancelled.push_back(std::move(m_current));
+	}
+
+	auto task = std::make_unique<Task>();
+	task->parameters = std::move(m_pendingParameters);
+	task->parameters.continentalnessSettings.CompileSpline();
+	task->parameters.erosionSettings.CompileSpline();
+	m_hasPendingRequest = false;
+
+	const auto& parameters = task->parameters;
+	const size_t chunkCount = static_cast<size_t>(parameters.nbChunksX) * parameters.nbChunksZ;
+	task->rebuild = !MatchesLayout(chunks, parameters);
+	task->chunks.resize(chunkCount);
+	task->needsUpload.resize(chunkCount);
+	task->staging.resize(chunkCount);
+	task->stagingRing = m_stagingRing;
+
+	// The jobs only see the task and the current chunks, both outlive them (see m_cancelled)
+	Task* job = task.get();
+	const std::vector<Chunk>* source = &chunks;
+	JobSystem::Get().Dispatch(static_cast<uint32_t>(chunkCount), 1, [job, source](uint32_t index)
+	{
+		if (job->token.IsCancelled())
+			return;
+
+		const auto& parameters = job->parameters;
+		Chunk& chunk = job->chunks[index];
+		if (job->rebuild)
+		{
+			const int x = static_cast<int>(index) / parameters.nbChunksZ;
+			const int z = static_cast<int>(index) % parameters.nbChunksZ;
+			chunk = Chunk{ x, z, parameters.chunkSize, parameters.chunkSize, parameters.lod };
+		}
+		else
+		{
+			chunk = (*source)[index];
+		}
+
+		job->needsUpload[index] = chunk.Update(parameters.continentalnessSettings, parameters.erosionSettings, parameters.blend, parameters.generateVertices, parameters.adaptiveErrors, &job->token);
+		if (job->stagingRing && (job->rebuild || job->needsUpload[index]) && !job->token.IsCancelled())
+			job->staging[index] = chunk.StageVertices(*job->stagingRing);
+	}, task->counter);
+
+	m_current = std::move(task);
+}
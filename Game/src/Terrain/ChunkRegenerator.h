@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Chunk.h"
+#include "../JobSystem/JobSystem.h"
+#include "../PerlinNoise/PerlinGeneration.h"
+
+// Everything a regeneration reads, copied on request so the UI can keep editing its own settings
+struct ChunkGenerationParameters
+{
+	NoiseSettings continentalnessSettings;
+	NoiseSettings erosionSettings;
+	bool blend = true;
+
+	int nbChunksX = 0;
+	int nbChunksZ = 0;
+	int chunkSize = 0;
+	int lod = 1;
+
+	// Off when the chunks are drawn from their heights only, see Chunk::Update
+	bool generateVertices = true;
+
+	// On while the chunks may be drawn as adaptive meshes, see Chunk::HasAdaptiveMesh
+	bool adaptiveErrors = false;
+};
+
+// Regenerates the chunks on the job system from the latest requested parameters.
+// Requests are debounced while the user keeps editing, a newer request cancels the one in flight
+// and the chunks of a finished regeneration are swapped in by Poll on the main thread.
+class ChunkRegenerator
+{
+public:
+	ChunkRegenerator() = default;
+	~ChunkRegenerator();
+
+	ChunkRegenerator(const ChunkRegenerator&) = delete;
+	ChunkRegenerator& operator=(const ChunkRegenerator&) = delete;
+
+	void Request(const ChunkGenerationParameters& parameters);
+
+	// The jobs write the vertices of the chunks they update into the ring, null to upload from the chunks
+	void SetStagingRing(const std::shared_ptr<StagingRing>& stagingRing) { m_stagingRing = stagingRing; }
+
+	// Must be called every frame from the thread owning chunks, which must not be modified elsewhere while IsBusy().
+	// Returns true when a regeneration got swapped into chunks, chunksToUpload then holds the chunks whose
+	// vertices changed and rebuilt tells whether the chunks are new and still need their buffers.
+	// staging[i] holds the vertices of chunksToUpload[i] when they were written into the staging ring
+	bool Poll(std::vector<Chunk>& chunks, std::vector<size_t>& chunksToUpload, std::vector<StagingRing::Allocation>& staging, bool& rebuilt);
+
+	// Drops the pending request and blocks until the jobs in flight stopped
+	void Cancel();
+
+	[[nodiscard]] bool IsBusy() const { return m_hasPendingRequest || m_current || !m_cancelled.empty(); }
+
+	// True when chunks were generated from the layout of the parameters and only have to be updated
+	static bool MatchesLayout(const std::vector<Chunk>& chunks, const ChunkGenerationParameters& parameters);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Task
+	{
+		ChunkGenerationParameters parameters;
+		CancellationToken token;
+		JobCounter counter;
+
+		bool rebuild = false;
+		std::vector<Chunk> chunks;
+		std::vector<uint8_t> needsUpload;
+		std::vector<StagingRing::Allocation> staging;
+		std::shared_ptr<StagingRing> stagingRing;
+	};
+
+	void Launch(const std::vector<Chunk>& chunks);
+
+	std::unique_ptr<Task> m_current;
+	std::shared_ptr<StagingRing> m_stagingRing;
+
+	// Cancelled tasks are kept alive until their jobs stopped reading the chunks
+	std::vector<std::unique_ptr<Task>> m_cancelled;
+
+	ChunkGenerationParameters m_pendingParameters;
+	bool m_hasPendingRequest = false;
+	Clock::time_point m_firstRequestTime;
+	Clock::time_point m_lastRequestTime;
+};
@@ -0,0 +1,231 @@
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Camera/Frustum.h"
+
+namespace
+{
+	// Seconds of camera movement the load order anticipates
+	constexpr float kLookahead = 1.f;
+
+	// Smoothing of the measured camera velocity
+	constexpr float kVelocitySmoothing = 0.2f;
+
+	// Chunks out of the frustum are loaded as if they were this many chunks further
+	constexpr float kHiddenPenalty = 4.f;
+
+	// Updating a loaded chunk leaves no hole, new chunks go first
+	constexpr float kStalePenalty = 2.f;
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+	CancelJobs();
+}
+
+void ChunkStreamer::SetParameters(const ChunkGenerationParameters& parameters)
+{
+	const bool layoutChanged = parameters.chunkSize != m_parameters->chunkSize || parameters.lod != m_parameters->lod || parameters.generateVertices != m_parameters->generateVertices;
+
+	auto compiled = std::make_shared<ChunkGenerationParameters>(parameters);
+	compiled->continentalnessSettings.CompileSpline();
+	compiled->erosionSettings.CompileSpline();
+	HeightMap::GetHeightBounds(compiled->continentalnessSettings, compiled->erosionSettings, compiled->blend, m_minHeight, m_maxHeight);
+
+	// Loaded chunks stay displayed until their replacement is generated from the new parameters
+	m_token->Cancel();
+	m_token = std::make_shared<CancellationToken>();
+	m_parameters = std::move(compiled);
+	++m_generation;
+
+	if (layoutChanged)
+		Clear();
+}
+
+void ChunkStreamer::SetRadius(int radius, int evictionMargin)
+{
+	m_radius = std::max(1, radius);
+	m_evictionMargin = std::max(0, evictionMargin);
+}
+
+void ChunkStreamer::Update(const Camera& camera, float dt, const UploadFunction& upload)
+{
+	if (m_parameters->chunkSize < 2)
+		return;
+
+	const glm::vec2 position(camera.GetPosition().x, camera.GetPosition().z);
+	if (m_hasLastPosition && dt > 0.f)
+		m_velocity += ((position - m_lastPosition) / dt - m_velocity) * kVelocitySmoothing;
+	m_lastPosition = position;
+	m_hasLastPosition = true;
+
+	const float chunkWorldSize = static_cast<float>(GetChunkWorldSize());
+	m_center = { static_cast<int>(std::floor(position.x / chunkWorldSize)), static_cast<int>(std::floor(position.y / chunkWorldSize)) };
+
+	ApplyResults(upload);
+	Evict();
+	Schedule(camera);
+}
+
+void ChunkStreamer::Clear()
+{
+	CancelJobs();
+	m_chunks.Clear();
+	m_results.clear();
+	m_loadedCount = 0;
+}
+
+void ChunkStreamer::ApplyResults(const UploadFunction& upload)
+{
+	std::vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(m_resultMutex);
+		results.swap(m_results);
+	}
+
+	for (auto& result : results)
+	{
+		--m_pendingCount;
+
+		// Evicted, or evicted and requested again, while the job was running
+		StreamedChunk* streamed = m_chunks.Find(result.coord);
+		if (!streamed || streamed->ticket != result.ticket)
+			continue;
+
+		streamed->ticket = 0;
+		if (result.cancelled)
+		{
+			if (!streamed->loaded)
+				m_chunks.Erase(result.coord);
+			continue;
+		}
+
+		const bool isNew = !streamed->loaded;
+		streamed->chunk = std::move(result.chunk);
+		streamed->generation = result.generation;
+		streamed->loaded = true;
+
+		if (isNew)
+			++m_loadedCount;
+
+		if (isNew || result.changed)
+			upload(streamed->chunk, isNew, result.staging);
+	}
+}
+
+void ChunkStreamer::Evict()
+{
+	const int evictionRadius = m_radius + m_evictionMargin;
+	m_chunks.EraseIf([&](ChunkCoord coord, const StreamedChunk& streamed)
+	{
+		const int dx = coord.x - m_center.x;
+		const int dz = coord.z - m_center.z;
+		if (dx * dx + dz * dz <= evictionRadius * evictionRadius)
+			return false;
+
+		if (streamed.loaded)
+			--m_loadedCount;
+		return true;
+	});
+}
+
+void ChunkStreamer::Schedule(const Camera& camera)
+{
+	const size_t maxPending = std::max<size_t>(4, JobSystem::Get().GetWorkerCount() * 2);
+	if (m_pendingCount >= maxPending)
+		return;
+
+	const Frustum frustum = Frustum::FromViewProjection(camera.GetViewProjection());
+	const float chunkWorldSize = static_cast<float>(GetChunkWorldSize());
+	const glm::vec2 predicted = (m_lastPosition + m_velocity * kLookahead) / chunkWorldSize;
+
+	// Chunks kept by the hysteresis are not loaded anymore but still updated while they are displayed
+	const int evictionRadius = m_radius + m_evictionMargin;
+
+	std::vector<Candidate> candidates;
+	for (int z = m_center.z - evictionRadius; z <= m_center.z + evictionRadius; ++z)
+	{
+		for (int x = m_center.x - evictionRadius; x <= m_center.x + evictionRadius; ++x)
+		{
+			const int dx = x - m_center.x;
+			const int dz = z - m_center.z;
+			const int distance = dx * dx + dz * dz;
+			if (distance > evictionRadius * evictionRadius)
+				continue;
+
+			const ChunkCoord coord{ x, z };
+			const StreamedChunk* streamed = m_chunks.Find(coord);
+			if (streamed ? streamed->ticket != 0 || streamed->generation == m_generation : distance > m_radius * m_radius)
+				continue;
+
+			// Distance in chunks from the chunk centre to where the camera is heading
+			float priority = glm::length(glm::vec2(x + 0.5f, z + 0.5f) - predicted);
+
+			// Not generated yet, any height the settings can produce
+			const glm::vec3 min(x * chunkWorldSize, m_minHeight, z * chunkWorldSize);
+			const glm::vec3 max(min.x + chunkWorldSize, m_maxHeight, min.z + chunkWorldSize);
+			if (!frustum.IntersectsAabb(min, max))
+				priority += kHiddenPenalty;
+
+			if (streamed)
+				priority += kStalePenalty;
+
+			candidates.push_back({ coord, priority });
+		}
+	}
+
+	const size_t launchCount = std::min(candidates.size(), maxPending - m_pendingCount);
+	std::partial_sort(candidates.begin(), candidates.begin() + launchCount, candidates.end(), [](const Candidate& a, const Candidate& b)
+	{
+		return a.priority < b.priority;
+	});
+
+	for (size_t i = 0; i < launchCount; ++i)
+		Launch(candidates[i].coord, m_chunks.Insert(candidates[i].coord));
+}
+
+void ChunkStreamer::Launch(ChunkCoord coord, StreamedChunk& streamed)
+{
+	const uint64_t ticket = m_nextTicket++;
+	streamed.ticket = ticket;
+	++m_pendingCount;
+
+	// Loaded chunks are updated from a copy so their cached stages are reused and the displayed one stays intact
+	Chunk chunk;
+	const bool isNew = !streamed.loaded;
+	if (!isNew)
+		chunk = streamed.chunk;
+
+	JobSystem::Get().Execute([this, coord, ticket, isNew, generation = m_generation, parameters = m_parameters, token = m_token, stagingRing = m_stagingRing, chunk = std::move(chunk)]() mutable
+	{
+		if (isNew)
+			chunk = Chunk{ coord.x, coord.z, parameters->chunkSize, parameters->chunkSize, parameters->lod };
+
+		Result result{ coord, ticket, generation };
+		result.changed = chunk.Update(parameters->continentalnessSettings, parameters->erosionSettings, parameters->blend, parameters->generateVertices, parameters->adaptiveErrors, token.get());
+		result.cancelled = token->IsCancelled();
+		if (stagingRing && (isNew || result.changed) && !result.cancelled)
+			result.staging = chunk.StageVertices(*stagingRing);
+		result.chunk = std::move(chunk);
+
+		std::lock_guard<std::mutex> lock(m_resultMutex);
+		m_results.push_back(std::move(result));
+	}, m_jobs);
+}
+
+void ChunkStreamer::CancelJobs()
+{
+	m_token->Cancel();
+	JobSystem::Get().Wait(m_jobs);
+	m_token = std::make_shared<CancellationToken>();
+
+	// The results still reference buffers of loaded chunks, release them here
+	std::lock_guard<std::mutex> lock(m_resultMutex);
+	m_results.clear();
+	m_pendingCount = 0;
+
+	m_chunks.ForEach([](ChunkCoord, StreamedChunk& streamed) { streamed.ticket = 0; });
+	m_chunks.EraseIf([](ChunkCoord, const StreamedChunk& streamed) { return !streamed.loaded; });
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "ChunkRegenerator.h"
+#include "../Camera/Camera.h"
+#include "../JobSystem/JobSystem.h"
+
+// Keeps the chunks within a radius around the camera loaded, generating them on the job system.
+// Missing chunks are loaded first, visible ones and the ones ahead of the camera movement before the others,
+// and a chunk is only evicted once it is evictionMargin chunks further than the load radius.
+class ChunkStreamer
+{
+public:
+	struct StreamedChunk
+	{
+		Chunk chunk;
+
+		// Parameters generation the chunk was built from
+		uint32_t generation = 0;
+		bool loaded = false;
+
+		// Job building this chunk, 0 when none is running
+		uint64_t ticket = 0;
+	};
+
+	// Called on the main thread for every chunk generated by Update, isNew when it has no buffers yet.
+	// staging holds the vertices when the job wrote them into the staging ring, it is released after the call
+	using UploadFunction = std::function<void(Chunk& chunk, bool isNew, const StagingRing::Allocation& staging)>;
+
+	ChunkStreamer() = default;
+	~ChunkStreamer();
+
+	ChunkStreamer(const ChunkStreamer&) = delete;
+	ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+	// nbChunksX and nbChunksZ are ignored, a new chunk size or LOD drops every loaded chunk
+	void SetParameters(const ChunkGenerationParameters& parameters);
+
+	void SetRadius(int radius, int evictionMargin);
+
+	// The jobs write the vertices of the chunks they generate into the ring, null to upload from the chunks
+	void SetStagingRing(const std::shared_ptr<StagingRing>& stagingRing) { m_stagingRing = stagingRing; }
+
+	// Once per frame on the main thread
+	void Update(const Camera& camera, float dt, const UploadFunction& upload);
+
+	// Drops every chunk and waits for the jobs in flight
+	void Clear();
+
+	template<typename Function>
+	void ForEachLoaded(Function&& function)
+	{
+		m_chunks.ForEach([&](ChunkCoord, StreamedChunk& streamed)
+		{
+			if (streamed.loaded)
+				function(streamed.chunk);
+		});
+	}
+
+	[[nodiscard]] size_t GetLoadedCount() const { return m_loadedCount; }
+	[[nodiscard]] size_t GetPendingCount() const { return m_pendingCount; }
+	[[nodiscard]] ChunkCoord GetCenter() const { return m_center; }
+	[[nodiscard]] int GetRadius() const { return m_radius; }
+	[[nodiscard]] int GetEvictionMargin() const { return m_evictionMargin; }
+
+private:
+	struct Result
+	{
+		ChunkCoord coord;
+		uint64_t ticket = 0;
+		uint32_t generation = 0;
+		bool changed = false;
+		bool cancelled = false;
+		Chunk chunk;
+		StagingRing::Allocation staging;
+	};
+
+	struct Candidate
+	{
+		ChunkCoord coord;
+		float priority = 0.f;
+	};
+
+	void ApplyResults(const UploadFunction& upload);
+	void Evict();
+	void Schedule(const Camera& camera);
+	void Launch(ChunkCoord coord, StreamedChunk& streamed);
+	void CancelJobs();
+
+	[[nodiscard]] int GetChunkWorldSize() const { return m_parameters->chunkSize - 1; }
+
+	ChunkMap<StreamedChunk> m_chunks;
+
+	// Shared with the jobs, replaced rather than modified
+	std::shared_ptr<const ChunkGenerationParameters> m_parameters = std::make_shared<ChunkGenerationParameters>();
+	std::shared_ptr<CancellationToken> m_token = std::make_shared<CancellationToken>();
+	std::shared_ptr<StagingRing> m_stagingRing;
+	uint32_t m_generation = 1;
+
+	// Of the heights generated from m_parameters, bounds the chunks not loaded yet
+	float m_minHeight = 0.f;
+	float m_maxHeight = 0.f;
+
+	int m_radius = 8;
+	int m_evictionMargin = 2;
+
+	ChunkCoord m_center;
+	bool m_hasLastPosition = false;
+	glm::vec2 m_lastPosition{ 0.f };
+	glm::vec2 m_velocity{ 0.f };
+
+	JobCounter m_jobs;
+	uint64_t m_nextTicket = 1;
+	size_t m_pendingCount = 0;
+	size_t m_loadedCount = 0;
+
+	std::mutex m_resultMutex;
+	std::vector<Result> m_results;
+};
@@ -0,0 +1,306 @@
+#include "Clipmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "HeightMap/HeightMap.h"
+#include "../JobSystem/JobSystem.h"
+#include "../OpenGl/Renderer/Renderer.h"
+
+namespace
+{
+	int FloorDiv(int value, int divisor)
+	{
+		return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+	}
+
+	int FloorMod(int value, int divisor)
+	{
+		return value - FloorDiv(value, divisor) * divisor;
+	}
+
+	// Cells of the grid between holeStart and holeStart + holeSize along both axes are left out, a negative size keeps every cell
+	template<typename Index>
+	std::shared_ptr<IndexBuffer> CreateGridIndexBuffer(int gridSize, const glm::ivec2& holeStart, int holeSize)
+	{
+		const int rowSize = gridSize + 1;
+
+		std::vector<Index> indices;
+		indices.reserve(static_cast<size_t>(gridSize) * gridSize * 6);
+		for (int j = 0; j < gridSize; ++j)
+		{
+			for (int i = 0; i < gridSize; ++i)
+			{
+				const bool inHole = i >= holeStart.x && i < holeStart.x + holeSize && j >= holeStart.y && j < holeStart.y + holeSize;
+				if (inHole)
+					continue;
+
+				indices.push_back(static_cast<Index>(i + j * rowSize));
+				indices.push_back(static_cast<Index>(i + (j + 1) * rowSize));
+				indices.push_back(static_cast<Index>(i + 1 + j * rowSize));
+				indices.push_back(static_cast<Index>(i + 1 + j * rowSize));
+				indices.push_back(static_cast<Index>(i + (j + 1) * rowSize));
+				indices.push_back(static_cast<Index>(i + 1 + (j + 1) * rowSize));
+			}
+		}
+
+		return IndexBuffer::Create(indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+
+	std::shared_ptr<IndexBuffer> CreateGridIndexBuffer(int gridSize, const glm::ivec2& holeStart, int holeSize)
+	{
+		const size_t vertexCount = static_cast<size_t>(gridSize + 1) * (gridSize + 1);
+		return vertexCount <= 65536
+			? CreateGridIndexBuffer<uint16_t>(gridSize, holeStart, holeSize)
+			: CreateGridIndexBuffer<uint32_t>(gridSize, holeStart, holeSize);
+	}
+
+	// Evaluates the HeightMap stages of one layer at the grid positions of the region
+	void SampleLayer(const NoiseSettings& settings, const NoiseSettings& shapeSettings, int spacing, const glm::ivec2& start, const glm::ivec2& size, std::vector<float>& heights)
+	{
+		const siv::PerlinNoise perlin(settings.seed);
+		const float f = settings.GetSampleFrequency();
+
+		const size_t count = static_cast<size_t>(size.x) * size.y;
+		std::vector<double> xs(count), zs(count), values(count);
+		for (int z = 0; z < size.y; ++z)
+		{
+			for (int x = 0; x < size.x; ++x)
+			{
+				const size_t index = x + z * static_cast<size_t>(size.x);
+				const auto x1 = static_cast<float>((start.x + x) * spacing);
+				const auto z1 = static_cast<float>((start.y + z) * spacing);
+
+				xs[index] = x1 * f;
+				zs[index] = z1 * f;
+			}
+		}
+
+		settings.GetNoiseValues(perlin, xs.data(), zs.data(), values.data(), count);
+
+		const std::vector<float> noise(values.begin(), values.end());
+		HeightMap::RemapLayer(settings, shapeSettings, noise, heights);
+	}
+}
+
+Clipmap::Clipmap(int gridSize, int levelCount)
+	: m_gridSize(gridSize), m_levelCount(levelCount), m_textureSize(gridSize + 1), m_levels(levelCount)
+{
+	if (gridSize < 4 || gridSize % 4 != 0)
+		throw std::runtime_error("Clipmap grid size must be a multiple of 4");
+
+	if (levelCount < 1)
+		throw std::runtime_error("Clipmap needs at least one level");
+
+	// 4 bytes per vertex, the grid positions are read as floats
+	std::vector<uint16_t> vertices;
+	vertices.reserve(static_cast<size_t>(m_textureSize) * m_textureSize * 2);
+	for (int j = 0; j <= gridSize; ++j)
+	{
+		for (int i = 0; i <= gridSize; ++i)
+		{
+			vertices.push_back(static_cast<uint16_t>(i));
+			vertices.push_back(static_cast<uint16_t>(j));
+		}
+	}
+
+	const auto vertexBuffer = VertexBuffer::Create(vertices.data(), static_cast<uint32_t>(sizeof(uint16_t) * vertices.size()));
+	vertexBuffer->SetLayout({ { ShaderDataType::UShort2, "a_GridPosition" } });
+
+	m_grid = VertexArray::Create();
+	m_grid->AddVertexBuffer(vertexBuffer);
+	m_grid->SetIndexBuffer(CreateGridIndexBuffer(gridSize, glm::ivec2(0), -1));
+
+	// The finer level covers half of the grid, starting a quarter in or one cell further
+	for (int offsetZ = 0; offsetZ < 2; ++offsetZ)
+	{
+		for (int offsetX = 0; offsetX < 2; ++offsetX)
+		{
+			auto& ring = m_rings[GetRingVariant(offsetX, offsetZ)];
+			ring = VertexArray::Create();
+			ring->AddVertexBuffer(vertexBuffer);
+			ring->SetIndexBuffer(CreateGridIndexBuffer(gridSize, glm::ivec2(gridSize / 4 + offsetX, gridSize / 4 + offsetZ), gridSize / 2));
+		}
+	}
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_heightTexture);
+	glTextureStorage3D(m_heightTexture, 1, GL_R32F, m_textureSize, m_textureSize, levelCount);
+	glTextureParameteri(m_heightTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_heightTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+Clipmap::~Clipmap()
+{
+	glDeleteTextures(1, &m_heightTexture);
+}
+
+void Clipmap::SetSettings(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend)
+{
+	m_continentalnessSettings = continentalnessSettings;
+	m_erosionSettings = erosionSettings;
+	m_blend = blend;
+
+	m_continentalnessSettings.CompileSpline();
+	m_erosionSettings.CompileSpline();
+
+	for (auto& level : m_levels)
+		level.valid = false;
+}
+
+void Clipmap::Update(const glm::vec3& cameraPosition)
+{
+	const int cameraX = static_cast<int>(std::floor(cameraPosition.x));
+	const int cameraZ = static_cast<int>(std::floor(cameraPosition.z));
+
+	// Origins are even so that every level starts on a vertex of the coarser one
+	std::vector<Region> regions;
+	for (int level = 0; level < m_levelCount; ++level)
+	{
+		const int cellX = FloorDiv(cameraX, 1 << level);
+		const int cellZ = FloorDiv(cameraZ, 1 << level);
+		const glm::ivec2 origin(2 * FloorDiv(cellX, 2) - m_gridSize / 2, 2 * FloorDiv(cellZ, 2) - m_gridSize / 2);
+
+		AddExposedRegions(level, origin, regions);
+		m_levels[level].origin = origin;
+		m_levels[level].valid = true;
+	}
+
+	m_updatedSampleCount = 0;
+	if (regions.empty())
+		return;
+
+	JobCounter counter;
+	JobSystem::Get().Dispatch(static_cast<uint32_t>(regions.size()), 1, [this, &regions](uint32_t index)
+	{
+		GenerateRegion(regions[index]);
+	}, counter);
+	JobSystem::Get().Wait(counter);
+
+	for (const auto& region : regions)
+	{
+		UploadRegion(region);
+		m_updatedSampleCount += region.heights.size();
+	}
+}
+
+void Clipmap::Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform)
+{
+	const TextureBinding heights[] = { { m_heightTexture, "u_Heights" } };
+
+	for (int level = 0; level < m_levelCount; ++level)
+	{
+		const glm::ivec2 origin = m_levels[level].origin;
+		const UniformValue uniforms[] = {
+			{ "u_GridSize", m_gridSize },
+			{ "u_TextureSize", m_textureSize },
+			{ "u_Level", level },
+			{ "u_LevelOrigin", origin },
+			{ "u_LevelSpacing", static_cast<float>(1 << level) },
+		};
+
+		DrawState state;
+		state.textures = heights;
+		state.uniforms = uniforms;
+
+		if (level == 0)
+		{
+			Renderer::Submit(shader, m_grid, textures, transform, state);
+			continue;
+		}
+
+		// Cell of this level where the finer one starts, a quarter of the grid in plus 0 or 1
+		const glm::ivec2 inner = m_levels[level - 1].origin / 2 - origin - glm::ivec2(m_gridSize / 4);
+		Renderer::Submit(shader, m_rings[GetRingVariant(inner.x != 0, inner.y != 0)], textures, transform, state);
+	}
+}
+
+glm::vec2 Clipmap::GetOrigin() const
+{
+	const Level& coarsest = m_levels.back();
+	return glm::vec2(coarsest.origin) * static_cast<float>(1 << (m_levelCount - 1));
+}
+
+float Clipmap::GetExtent() const
+{
+	return static_cast<float>(m_gridSize) * static_cast<float>(1 << (m_levelCount - 1));
+}
+
+size_t Clipmap::GetTriangleCount() const
+{
+	const size_t cells = static_cast<size_t>(m_gridSize) * m_gridSize;
+	const size_t ringCells = cells - cells / 4;
+	return (cells + ringCells * (m_levelCount - 1)) * 2;
+}
+
+void Clipmap::AddExposedRegions(int level, const glm::ivec2& origin, std::vector<Region>& regions) const
+{
+	const int size = m_gridSize + 1;
+	const Level& current = m_levels[level];
+	const glm::ivec2 delta = origin - current.origin;
+
+	if (!current.valid || std::abs(delta.x) >= size || std::abs(delta.y) >= size)
+	{
+		regions.push_back({ level, origin, glm::ivec2(size) });
+		return;
+	}
+
+	// Columns entering the level, then the rows entering it over the columns it kept
+	if (delta.x > 0)
+		regions.push_back({ level, glm::ivec2(current.origin.x + size, origin.y), glm::ivec2(delta.x, size) });
+	else if (delta.x < 0)
+		regions.push_back({ level, origin, glm::ivec2(-delta.x, size) });
+
+	const int keptX = std::max(origin.x, current.origin.x);
+	const int keptWidth = size - std::abs(delta.x);
+	if (delta.y > 0)
+		regions.push_back({ level, glm::ivec2(keptX, current.origin.y + size), glm::ivec2(keptWidth, delta.y) });
+	else if (delta.y < 0)
+		regions.push_back({ level, glm::ivec2(keptX, origin.y), glm::ivec2(keptWidth, -delta.y) });
+}
+
+void Clipmap::GenerateRegion(Region& region) const
+{
+	const int spacing = 1 << region.level;
+
+	std::vector<float> continentalnessHeights, erosionHeights;
+	SampleLayer(m_continentalnessSettings, m_continentalnessSettings, spacing, region.start, region.size, continentalnessHeights);
+	if (!m_blend)
+	{
+		region.heights = std::move(continentalnessHeights);
+		return;
+	}
+
+	SampleLayer(m_erosionSettings, m_continentalnessSettings, spacing, region.start, region.size, erosionHeights);
+
+	region.heights.resize(continentalnessHeights.size());
+	for (size_t i = 0; i < region.heights.size(); ++i)
+		region.heights[i] = HeightMap::BlendWithSubstractiveErosionNoise(continentalnessHeights[i], erosionHeights[i], m_erosionSettings.factor);
+}
+
+void Clipmap::UploadRegion(const Region& region) const
+{
+	// Grid position p of a level is stored in texel p mod m_textureSize, a region wraps at most once per axis
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, region.size.x);
+
+	for (int z = 0; z < region.size.y;)
+	{
+		const int texelZ = FloorMod(region.start.y + z, m_textureSize);
+		const int rows = std::min(region.size.y - z, m_textureSize - texelZ);
+
+		for (int x = 0; x < region.size.x;)
+		{
+			const int texelX = FloorMod(region.start.x + x, m_textureSize);
+			const int columns = std::min(region.size.x - x, m_textureSize - texelX);
+
+			const float* data = region.heights.data() + x + z * static_cast<size_t>(region.size.x);
+			glTextureSubImage3D(m_heightTexture, 0, texelX, texelZ, region.level, columns, rows, 1, GL_RED, GL_FLOAT, data);
+			x += columns;
+		}
+
+		z += rows;
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
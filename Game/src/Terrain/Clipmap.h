@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "../OpenGl/Buffer/VertexArray.h"
+#include "../OpenGl/Shader/Shader.h"
+#include "../OpenGl/Texture/Texture.h"
+#include "../PerlinNoise/PerlinGeneration.h"
+
+// Geometry clipmap: nested square grids centred on the camera, the cells of level l are 2^l wide.
+// Every level draws the same static meshes, the full grid for the finest level and a ring around the
+// next finer level for the others, and reads its heights from its layer of a toroidally addressed texture.
+// Moving the camera only generates and uploads the rows and columns it exposes, draw calls and memory
+// depend on the grid size and level count only, not on the view distance.
+// Must be used from the thread owning the GL context.
+class Clipmap
+{
+public:
+	// gridSize is the number of cells along a level, a multiple of 4
+	Clipmap(int gridSize, int levelCount);
+	~Clipmap();
+
+	Clipmap(const Clipmap&) = delete;
+	Clipmap& operator=(const Clipmap&) = delete;
+
+	// Every level is generated again by the next Update
+	void SetSettings(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend);
+
+	// Recentres the levels on the camera and uploads the heights they expose
+	void Update(const glm::vec3& cameraPosition);
+
+	// One draw call per level, the height texture is bound after the given textures
+	void Draw(const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform);
+
+	[[nodiscard]] int GetGridSize() const { return m_gridSize; }
+	[[nodiscard]] int GetLevelCount() const { return m_levelCount; }
+
+	// World position of the corner of the coarsest level and its width
+	[[nodiscard]] glm::vec2 GetOrigin() const;
+	[[nodiscard]] float GetExtent() const;
+
+	// Height samples generated by the last Update
+	[[nodiscard]] size_t GetUpdatedSampleCount() const { return m_updatedSampleCount; }
+
+	[[nodiscard]] size_t GetTriangleCount() const;
+
+	static std::shared_ptr<Clipmap> Create(int gridSize, int levelCount)
+	{
+		return std::make_shared<Clipmap>(gridSize, levelCount);
+	}
+
+private:
+	struct Level
+	{
+		// Grid position of the first vertex, in cells of the level
+		glm::ivec2 origin{ 0 };
+		bool valid = false;
+	};
+
+	// Rectangle of grid positions of a level whose heights have to be generated
+	struct Region
+	{
+		int level;
+		glm::ivec2 start;
+		glm::ivec2 size;
+		std::vector<float> heights;
+	};
+
+	void AddExposedRegions(int level, const glm::ivec2& origin, std::vector<Region>& regions) const;
+	void GenerateRegion(Region& region) const;
+	void UploadRegion(const Region& region) const;
+
+	// Ring around the next finer level, which is offset by one cell along x and z when offsetX and offsetZ are set
+	static int GetRingVariant(bool offsetX, bool offsetZ) { return (offsetX ? 1 : 0) | (offsetZ ? 2 : 0); }
+
+	int m_gridSize;
+	int m_levelCount;
+	int m_textureSize;
+
+	GLuint m_heightTexture = 0;
+	std::shared_ptr<VertexArray> m_grid;
+	std::array<std::shared_ptr<VertexArray>, 4> m_rings;
+
+	std::vector<Level> m_levels;
+	size_t m_updatedSampleCount = 0;
+
+	NoiseSettings m_continentalnessSettings;
+	NoiseSettings m_erosionSettings;
+	bool m_blend = false;
+};
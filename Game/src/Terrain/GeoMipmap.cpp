@@ -0,0 +1,271 @@
+#include "GeoMipmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Chunk.h"
+#include "ChunkMap.h"
+
+namespace
+{
+	struct GridPoint
+	{
+		int x;
+		int z;
+	};
+
+	template<typename Index>
+	class TriangleWriter
+	{
+	public:
+		TriangleWriter(std::vector<Index>& indices, int rowSize): m_indices(indices), m_rowSize(rowSize) {}
+
+		// Same winding as the full grid triangles
+		void Add(GridPoint a, GridPoint b, GridPoint c)
+		{
+			const long long cross = static_cast<long long>(b.x - a.x) * (c.z - a.z) - static_cast<long long>(b.z - a.z) * (c.x - a.x);
+			if (cross > 0)
+				std::swap(b, c);
+
+			m_indices.push_back(Vertex(a));
+			m_indices.push_back(Vertex(b));
+			m_indices.push_back(Vertex(c));
+		}
+
+		// Triangulates the band between two polylines going the same direction along the edge
+		void Zip(const std::vector<GridPoint>& inner, const std::vector<GridPoint>& edge, bool alongX)
+		{
+			auto along = [alongX](GridPoint point) { return alongX ? point.x : point.z; };
+
+			size_t i = 0, j = 0;
+			while (i + 1 < inner.size() || j + 1 < edge.size())
+			{
+				const bool advanceEdge = j + 1 < edge.size() && (i + 1 == inner.size() || along(edge[j + 1]) <= along(inner[i + 1]));
+				if (advanceEdge)
+				{
+					Add(inner[i], edge[j], edge[j + 1]);
+					++j;
+				}
+				else
+				{
+					Add(inner[i], edge[j], inner[i + 1]);
+					++i;
+				}
+			}
+		}
+
+	private:
+		Index Vertex(GridPoint point) const { return static_cast<Index>(point.x + point.z * m_rowSize); }
+
+		std::vector<Index>& m_indices;
+		int m_rowSize;
+	};
+}
+
+int GeoMipmap::GetLevelCount(int width, int height, int lod)
+{
+	const int cells = std::min(width - 1, height - 1) * lod;
+
+	int levelCount = 1;
+	while (levelCount < kMaxLevelCount && (1 << levelCount) < cells)
+		++levelCount;
+
+	return levelCount;
+}
+
+std::vector<int> GeoMipmap::GetLevelPositions(int cells, int level)
+{
+	const int step = 1 << level;
+
+	std::vector<int> positions;
+	positions.reserve(cells / step + 2);
+	for (int position = 0; position < cells; position += step)
+		positions.push_back(position);
+	positions.push_back(cells);
+
+	return positions;
+}
+
+template<typename Index>
+std::vector<Index> GeoMipmap::GenerateIndices(int width, int height, int lod, int level, uint8_t stitchMask)
+{
+	const int rowSize = width * lod;
+	const int cellsX = (width - 1) * lod;
+	const int cellsZ = (height - 1) * lod;
+
+	const std::vector<int> xs = GetLevelPositions(cellsX, level);
+	const std::vector<int> zs = GetLevelPositions(cellsZ, level);
+	const int lastX = static_cast<int>(xs.size()) - 1;
+	const int lastZ = static_cast<int>(zs.size()) - 1;
+
+	std::vector<Index> indices;
+	indices.reserve(static_cast<size_t>(lastX) * lastZ * 6);
+	TriangleWriter<Index> writer(indices, rowSize);
+
+	// Stitched edges give their row of cells to a band zipped to the coarser samples
+	const int firstCellX = (stitchMask & NegativeX) ? 1 : 0;
+	const int endCellX = (stitchMask & PositiveX) ? lastX - 1 : lastX;
+	const int firstCellZ = (stitchMask & NegativeZ) ? 1 : 0;
+	const int endCellZ = (stitchMask & PositiveZ) ? lastZ - 1 : lastZ;
+
+	for (int j = firstCellZ; j < endCellZ; ++j)
+	{
+		for (int i = firstCellX; i < endCellX; ++i)
+		{
+			indices.push_back(static_cast<Index>(xs[i] + zs[j] * rowSize));
+			indices.push_back(static_cast<Index>(xs[i] + zs[j + 1] * rowSize));
+			indices.push_back(static_cast<Index>(xs[i + 1] + zs[j] * rowSize));
+			indices.push_back(static_cast<Index>(xs[i + 1] + zs[j] * rowSize));
+			indices.push_back(static_cast<Index>(xs[i] + zs[j + 1] * rowSize));
+			indices.push_back(static_cast<Index>(xs[i + 1] + zs[j + 1] * rowSize));
+		}
+	}
+
+	if (stitchMask == 0)
+		return indices;
+
+	const std::vector<int> coarseXs = GetLevelPositions(cellsX, level + 1);
+	const std::vector<int> coarseZs = GetLevelPositions(cellsZ, level + 1);
+
+	auto stitchAlongX = [&](int innerZ, int edgeZ)
+	{
+		std::vector<GridPoint> inner, edge;
+		for (int i = firstCellX; i <= endCellX; ++i)
+			inner.push_back({ xs[i], innerZ });
+		for (const int x : coarseXs)
+			edge.push_back({ x, edgeZ });
+		writer.Zip(inner, edge, true);
+	};
+
+	auto stitchAlongZ = [&](int innerX, int edgeX)
+	{
+		std::vector<GridPoint> inner, edge;
+		for (int j = firstCellZ; j <= endCellZ; ++j)
+			inner.push_back({ innerX, zs[j] });
+		for (const int z : coarseZs)
+			edge.push_back({ edgeX, z });
+		writer.Zip(inner, edge, false);
+	};
+
+	if (stitchMask & NegativeZ)
+		stitchAlongX(zs[1], 0);
+	if (stitchMask & PositiveZ)
+		stitchAlongX(zs[lastZ - 1], cellsZ);
+	if (stitchMask & NegativeX)
+		stitchAlongZ(xs[1], 0);
+	if (stitchMask & PositiveX)
+		stitchAlongZ(xs[lastX - 1], cellsX);
+
+	return indices;
+}
+
+template std::vector<uint16_t> GeoMipmap::GenerateIndices<uint16_t>(int, int, int, int, uint8_t);
+template std::vector<uint32_t> GeoMipmap::GenerateIndices<uint32_t>(int, int, int, int, uint8_t);
+
+std::vector<float> GeoMipmap::ComputeLevelErrors(const float* heights, int width, int height, int lod)
+{
+	const int rowSize = width * lod;
+	const int cellsX = (width - 1) * lod;
+	const int cellsZ = (height - 1) * lod;
+	const int levelCount = GetLevelCount(width, height, lod);
+
+	std::vector<float> errors(levelCount, 0.f);
+	for (int level = 1; level < levelCount; ++level)
+	{
+		const std::vector<int> xs = GetLevelPositions(cellsX, level);
+		const std::vector<int> zs = GetLevelPositions(cellsZ, level);
+
+		// The level cell holding every sample
+		std::vector<int> cellOfX(cellsX + 1), cellOfZ(cellsZ + 1);
+		for (int i = 0; i + 1 < static_cast<int>(xs.size()); ++i)
+			std::fill(cellOfX.begin() + xs[i], cellOfX.begin() + xs[i + 1] + 1, i);
+		for (int j = 0; j + 1 < static_cast<int>(zs.size()); ++j)
+			std::fill(cellOfZ.begin() + zs[j], cellOfZ.begin() + zs[j + 1] + 1, j);
+
+		float error = errors[level - 1];
+		for (int z = 0; z <= cellsZ; ++z)
+		{
+			const int j = cellOfZ[z];
+			const float tz = static_cast<float>(z - zs[j]) / static_cast<float>(zs[j + 1] - zs[j]);
+			const float* row0 = heights + zs[j] * static_cast<size_t>(rowSize);
+			const float* row1 = heights + zs[j + 1] * static_cast<size_t>(rowSize);
+
+			for (int x = 0; x <= cellsX; ++x)
+			{
+				const int i = cellOfX[x];
+				const float tx = static_cast<float>(x - xs[i]) / static_cast<float>(xs[i + 1] - xs[i]);
+
+				const float bottom = row0[xs[i]] + (row0[xs[i + 1]] - row0[xs[i]]) * tx;
+				const float top = row1[xs[i]] + (row1[xs[i + 1]] - row1[xs[i]]) * tx;
+				const float approximation = bottom + (top - bottom) * tz;
+
+				error = std::max(error, std::abs(heights[x + z * static_cast<size_t>(rowSize)] - approximation));
+			}
+		}
+
+		errors[level] = error;
+	}
+
+	return errors;
+}
+
+void GeoMipmap::SelectLevels(const std::vector<const Chunk*>& chunks, const glm::vec3& cameraPosition, float errorFactor, float maxPixelError, std::vector<MeshSelection>& selections)
+{
+	std::vector<int> levels(chunks.size());
+	ChunkMap<int> indices(chunks.size());
+
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		const Chunk& chunk = *chunks[i];
+		indices.Insert({ chunk.x, chunk.z }) = static_cast<int>(i) + 1;
+
+		const float distance = chunk.GetDistance(cameraPosition);
+
+		int level = 0;
+		while (level + 1 < chunk.GetLevelCount() && chunk.GetLevelError(level + 1) * errorFactor <= maxPixelError * distance)
+			++level;
+
+		levels[i] = level;
+	}
+
+	auto forEachNeighbour = [&](const Chunk& chunk, auto&& function)
+	{
+		const ChunkCoord neighbours[] = { { chunk.x - 1, chunk.z }, { chunk.x + 1, chunk.z }, { chunk.x, chunk.z - 1 }, { chunk.x, chunk.z + 1 } };
+		const uint8_t edges[] = { NegativeX, PositiveX, NegativeZ, PositiveZ };
+		for (int n = 0; n < 4; ++n)
+		{
+			if (const int* index = indices.Find(neighbours[n]))
+				function(*index - 1, edges[n]);
+		}
+	};
+
+	// Only ever lowers levels, so it settles after at most kMaxLevelCount passes
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			forEachNeighbour(*chunks[i], [&](int neighbour, uint8_t)
+			{
+				if (levels[i] > levels[neighbour] + 1)
+				{
+					levels[i] = levels[neighbour] + 1;
+					changed = true;
+				}
+			});
+		}
+	}
+
+	selections.resize(chunks.size());
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		uint8_t stitchMask = 0;
+		forEachNeighbour(*chunks[i], [&](int neighbour, uint8_t edge)
+		{
+			if (levels[neighbour] > levels[i])
+				stitchMask |= edge;
+		});
+
+		selections[i] = { levels[i], stitchMask };
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Chunk;
+
+// Geomipmapping of the chunk grids: level L keeps one sample out of 2^L along both axes (plus the last one)
+// and draws from the same vertex buffer with another index buffer. Neighbouring chunks differ by one level
+// at most, the finer one stitches its edges to the samples of the coarser one so no crack opens between them.
+namespace GeoMipmap
+{
+	// Bits of the stitch mask, set for the edges next to a coarser chunk
+	enum Edge : uint8_t
+	{
+		NegativeX = 1 << 0,
+		PositiveX = 1 << 1,
+		NegativeZ = 1 << 2,
+		PositiveZ = 1 << 3,
+	};
+
+	constexpr int kStitchVariants = 16;
+	constexpr int kMaxLevelCount = 7;
+
+	// Levels keeping at least one sample inside the chunk
+	int GetLevelCount(int width, int height, int lod);
+
+	// Sample indices kept by a level along an axis of cells cells
+	std::vector<int> GetLevelPositions(int cells, int level);
+
+	// Triangles of a chunk of width * lod by height * lod samples at a level, level 0 without stitching is the full grid
+	template<typename Index>
+	std::vector<Index> GenerateIndices(int width, int height, int lod, int level, uint8_t stitchMask);
+
+	// Largest height difference between the full grid and each level, non decreasing
+	std::vector<float> ComputeLevelErrors(const float* heights, int width, int height, int lod);
+
+	struct MeshSelection
+	{
+		int level = 0;
+		uint8_t stitchMask = 0;
+
+		[[nodiscard]] int GetVariant() const { return level * kStitchVariants + stitchMask; }
+	};
+
+	// Picks for every chunk the coarsest level whose error projects to at most maxPixelError pixels, then
+	// refines chunks until neighbours differ by one level at most. errorFactor is the viewport height / (2 * tan(fov / 2))
+	void SelectLevels(const std::vector<const Chunk*>& chunks, const glm::vec3& cameraPosition, float errorFactor, float maxPixelError, std::vector<MeshSelection>& selections);
+}
@@ -0,0 +1,95 @@
+#include "GpuChunkCuller.h"
+
+#include "ChunkArena.h"
+#include "../OpenGl/Renderer/Renderer.h"
+
+namespace
+{
+	constexpr uint32_t kDrawBinding = 0;
+	constexpr uint32_t kCommandBinding = 1;
+	constexpr uint32_t kParameterBinding = 2;
+
+	constexpr uint32_t kWorkGroupSize = 64;
+}
+
+GpuChunkCuller::GpuChunkCuller(const std::shared_ptr<Shader>& cullShader): m_shader(cullShader)
+{
+	m_draws = ShaderStorageBuffer::Create(sizeof(ChunkDraw) * 64, kDrawBinding);
+	m_commands = IndirectBuffer::Create();
+
+	const uint32_t zero = 0;
+	glCreateBuffers(static_cast<GLsizei>(m_parameterBuffers.size()), m_parameterBuffers.data());
+	for (const GLuint parameterBuffer : m_parameterBuffers)
+		glNamedBufferData(parameterBuffer, sizeof(uint32_t), &zero, GL_DYNAMIC_DRAW);
+}
+
+GpuChunkCuller::~GpuChunkCuller()
+{
+	glDeleteBuffers(static_cast<GLsizei>(m_parameterBuffers.size()), m_parameterBuffers.data());
+}
+
+void GpuChunkCuller::Cull(const ChunkArena& arena, const Frustum& frustum, const HiZBuffer* hiZ)
+{
+	const auto& commands = arena.GetFrameCommands();
+	const auto& bounds = arena.GetFrameBounds();
+
+	m_chunkDraws.resize(commands.size());
+	for (size_t i = 0; i < commands.size(); ++i)
+		m_chunkDraws[i] = { glm::vec4(bounds[2 * i], 0.f), glm::vec4(bounds[2 * i + 1], 0.f), commands[i], {} };
+
+	++m_frame;
+	const GLuint parameterBuffer = m_parameterBuffers[m_frame % kParameterBufferCount];
+
+	// The oldest count was written kParameterBufferCount - 1 frames ago, reading it seldom waits
+	const GLuint oldestBuffer = m_parameterBuffers[(m_frame + 1) % kParameterBufferCount];
+	glGetNamedBufferSubData(oldestBuffer, 0, sizeof(uint32_t), &m_visibleCount);
+
+	const uint32_t zero = 0;
+	glNamedBufferSubData(parameterBuffer, 0, sizeof(uint32_t), &zero);
+
+	m_commands->Reserve(static_cast<uint32_t>(commands.size()));
+	if (commands.empty())
+		return;
+
+	m_draws->SetData(m_chunkDraws.data(), static_cast<uint32_t>(m_chunkDraws.size() * sizeof(ChunkDraw)));
+
+	m_shader->Bind();
+	m_draws->Bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, m_commands->GetRendererID());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kParameterBinding, parameterBuffer);
+
+	m_shader->SetInt("u_ChunkCount", static_cast<int>(commands.size()));
+	for (int i = 0; i < Frustum::Count; ++i)
+		m_shader->SetFloat4("u_FrustumPlanes[" + std::to_string(i) + "]", frustum.planes[i]);
+	m_shader->SetInt("u_Compact", IsCompactionSupported());
+
+	const bool occlusion = hiZ && hiZ->IsValid();
+	m_shader->SetInt("u_Occlusion", occlusion);
+	if (occlusion)
+	{
+		glBindTextureUnit(0, hiZ->GetRendererID());
+		m_shader->SetInt("u_HiZ", 0);
+		m_shader->SetMat4("u_HiZViewProjection", hiZ->GetViewProjection());
+		m_shader->SetInt2("u_HiZSize", hiZ->GetSize());
+		m_shader->SetInt("u_HiZLevelCount", hiZ->GetLevelCount());
+	}
+
+	m_shader->Dispatch((static_cast<uint32_t>(commands.size()) + kWorkGroupSize - 1) / kWorkGroupSize, 1);
+
+	// The commands and the count are read by the draw next
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuChunkCuller::Draw(ChunkArena& arena, const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform)
+{
+	if (!arena.GetVertexArray())
+		return;
+
+	// Compaction keeps the base instance of the commands, the placements stay indexed by it
+	const DrawState placements = arena.UploadPlacements();
+
+	if (IsCompactionSupported())
+		Renderer::SubmitIndirectCount(shader, arena.GetVertexArray(), m_commands, m_parameterBuffers[m_frame % kParameterBufferCount], textures, transform, placements);
+	else
+		Renderer::SubmitIndirect(shader, arena.GetVertexArray(), m_commands, textures, transform, placements);
+}
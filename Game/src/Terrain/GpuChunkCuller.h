@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "../Camera/Frustum.h"
+#include "../OpenGl/Buffer/IndirectBuffer.h"
+#include "../OpenGl/Buffer/ShaderStorageBuffer.h"
+#include "../OpenGl/Shader/Shader.h"
+#include "../OpenGl/Texture/HiZBuffer.h"
+#include "../OpenGl/Texture/Texture.h"
+
+class ChunkArena;
+
+// Culls the draws of a ChunkArena in a compute shader, against the frustum and the hierarchical depth of
+// the previous frame, and draws the visible ones with the count the shader wrote (GL_ARB_indirect_parameters).
+// Without the extension the culled commands are kept with no instance instead of being compacted.
+// Must be used from the thread owning the GL context.
+class GpuChunkCuller
+{
+public:
+	explicit GpuChunkCuller(const std::shared_ptr<Shader>& cullShader);
+	~GpuChunkCuller();
+
+	GpuChunkCuller(const GpuChunkCuller&) = delete;
+	GpuChunkCuller& operator=(const GpuChunkCuller&) = delete;
+
+	// hiZ is skipped when null or not built yet
+	void Cull(const ChunkArena& arena, const Frustum& frustum, const HiZBuffer* hiZ);
+
+	void Draw(ChunkArena& arena, const std::shared_ptr<Shader>& shader, const std::vector<std::shared_ptr<Texture2D>>& textures, const glm::mat4& transform);
+
+	// Draws left by a Cull a few frames ago, read back without waiting for the current one
+	[[nodiscard]] uint32_t GetVisibleCount() const { return m_visibleCount; }
+
+	[[nodiscard]] static bool IsCompactionSupported() { return GLEW_ARB_indirect_parameters; }
+
+	static std::shared_ptr<GpuChunkCuller> Create(const std::shared_ptr<Shader>& cullShader)
+	{
+		return std::make_shared<GpuChunkCuller>(cullShader);
+	}
+
+private:
+	// Layout of the ChunkDraw struct of the culling shader (std430)
+	struct ChunkDraw
+	{
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		DrawElementsIndirectCommand command;
+		uint32_t padding[3];
+	};
+
+	static constexpr size_t kParameterBufferCount = 3;
+
+	std::shared_ptr<Shader> m_shader;
+	std::shared_ptr<ShaderStorageBuffer> m_draws;
+	std::shared_ptr<IndirectBuffer> m_commands;
+
+	// One draw count per frame in flight, the oldest is read back for GetVisibleCount
+	std::array<GLuint, kParameterBufferCount> m_parameterBuffers{};
+	size_t m_frame = 0;
+	uint32_t m_visibleCount = 0;
+
+	std::vector<ChunkDraw> m_chunkDraws;
+};
@@ -0,0 +1,221 @@
+#include "GpuChunkGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <glm/glm.hpp>
+
+#include "Chunk.h"
+#include "ChunkArena.h"
+#include "../OpenGl/Buffer/VertexArray.h"
+
+namespace
+{
+	constexpr uint32_t kPermutationBinding = 0;
+	constexpr uint32_t kSplineBinding = 1;
+	constexpr uint32_t kVertexBinding = 2;
+	constexpr uint32_t kBoundsBinding = 3;
+
+	// Work group of the compute shader, every invocation writes two vertices
+	constexpr uint32_t kWorkGroupSize = 64;
+
+	// Reverse of OrderedBits in the shader
+	float FromOrderedBits(uint32_t bits)
+	{
+		bits = (bits & 0x80000000u) != 0 ? bits & 0x7FFFFFFFu : ~bits;
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+GpuChunkGenerator::GpuChunkGenerator(const std::shared_ptr<Shader>& computeShader): m_shader(computeShader)
+{
+	m_permutations = ShaderStorageBuffer::Create(sizeof(int32_t) * 512, kPermutationBinding);
+	m_splines = ShaderStorageBuffer::Create(sizeof(SplineSegment) * 32, kSplineBinding);
+	m_bounds = ShaderStorageBuffer::Create(sizeof(uint32_t) * 2 * 64, kBoundsBinding);
+}
+
+GpuChunkGenerator::~GpuChunkGenerator()
+{
+	if (m_boundsFence)
+		glDeleteSync(m_boundsFence);
+}
+
+void GpuChunkGenerator::SetSettings(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend)
+{
+	std::vector<int32_t> permutations(512);
+	const auto continentalnessPermutation = siv::PerlinNoise(continentalnessSettings.seed).serialize();
+	const auto erosionPermutation = siv::PerlinNoise(erosionSettings.seed).serialize();
+	std::copy(continentalnessPermutation.begin(), continentalnessPermutation.end(), permutations.begin());
+	std::copy(erosionPermutation.begin(), erosionPermutation.end(), permutations.begin() + 256);
+	m_permutations->SetData(permutations.data(), static_cast<uint32_t>(permutations.size() * sizeof(int32_t)));
+
+	std::vector<SplineSegment> segments = continentalnessSettings.spline.GetSegments();
+	const int continentalnessCount = static_cast<int>(segments.size());
+	const std::vector<SplineSegment> erosionSegments = erosionSettings.spline.GetSegments();
+	segments.insert(segments.end(), erosionSegments.begin(), erosionSegments.end());
+
+	// An empty buffer cannot be bound, keep at least one segment
+	if (segments.empty())
+		segments.emplace_back();
+	m_splines->SetData(segments.data(), static_cast<uint32_t>(segments.size() * sizeof(SplineSegment)));
+
+	HeightMap::GetHeightBounds(continentalnessSettings, erosionSettings, blend, m_minHeight, m_maxHeight);
+
+	m_shader->Bind();
+	SetLayer("u_Continentalness", continentalnessSettings, 0, continentalnessCount);
+	SetLayer("u_Erosion", erosionSettings, continentalnessCount, static_cast<int>(erosionSegments.size()));
+
+	// Like HeightMap, ridges and terraces are driven by the continentalness settings for both layers
+	m_shader->SetInt("u_RidgeNoise", continentalnessSettings.ridgeNoise);
+	m_shader->SetInt("u_Terraces", continentalnessSettings.terraces);
+	m_shader->SetInt("u_Blend", blend);
+	m_shader->SetFloat("u_ErosionFactor", erosionSettings.factor);
+
+	// Every height of the settings can be stored, see Chunk::SetVertexHeightRange
+	m_shader->SetFloat("u_VertexMinHeight", m_minHeight);
+	m_shader->SetFloat("u_VertexHeightScale", m_maxHeight - m_minHeight);
+}
+
+void GpuChunkGenerator::Generate(std::vector<Chunk>& chunks)
+{
+	Begin(chunks);
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		const auto& vertexBuffer = chunks[i].GetVertexArray()->GetVertexBuffers()[0];
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kVertexBinding, vertexBuffer->GetRendererID(), vertexBuffer->GetOffset(), vertexBuffer->GetSize());
+		Dispatch(chunks[i], static_cast<int>(i));
+	}
+	End();
+}
+
+void GpuChunkGenerator::Generate(std::vector<Chunk>& chunks, ChunkArena& arena)
+{
+	// Growing the arena moves its vertices to a new buffer, every range is allocated before the first dispatch
+	for (const auto& chunk : chunks)
+		arena.GetVertexRange(chunk);
+
+	Begin(chunks);
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		const ChunkArena::VertexRange range = arena.GetVertexRange(chunks[i]);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kVertexBinding, range.buffer, range.offset, range.size);
+		Dispatch(chunks[i], static_cast<int>(i));
+	}
+	End();
+}
+
+bool GpuChunkGenerator::ResolveBounds(std::vector<Chunk>& chunks, bool wait)
+{
+	if (!m_boundsFence)
+		return false;
+
+	const GLenum status = glClientWaitSync(m_boundsFence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return false;
+
+	glDeleteSync(m_boundsFence);
+	m_boundsFence = nullptr;
+
+	// The chunks were regenerated on the CPU or rebuilt meanwhile, their bounds come from elsewhere
+	if (chunks.size() != m_boundsChunks.size())
+		return false;
+
+	std::vector<uint32_t> bounds(chunks.size() * 2);
+	glGetNamedBufferSubData(m_bounds->GetRendererID(), 0, static_cast<GLsizeiptr>(bounds.size() * sizeof(uint32_t)), bounds.data());
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		if (chunks[i].x == m_boundsChunks[i].x && chunks[i].z == m_boundsChunks[i].y && chunks[i].GetHeightMap().empty())
+			chunks[i].SetHeightBounds(FromOrderedBits(bounds[i * 2]), FromOrderedBits(bounds[i * 2 + 1]));
+	}
+	return true;
+}
+
+void GpuChunkGenerator::Begin(std::vector<Chunk>& chunks)
+{
+	// Empty ranges, every work group of a chunk narrows its own
+	std::vector<uint32_t> bounds(std::max<size_t>(chunks.size(), 1) * 2);
+	for (size_t i = 0; i < bounds.size(); i += 2)
+	{
+		bounds[i] = 0xFFFFFFFFu;
+		bounds[i + 1] = 0;
+	}
+	m_bounds->SetData(bounds.data(), static_cast<uint32_t>(bounds.size() * sizeof(uint32_t)));
+
+	m_boundsChunks.clear();
+	for (Chunk& chunk : chunks)
+	{
+		chunk.SetHeightBounds(m_minHeight, m_maxHeight);
+		chunk.SetVertexHeightRange(m_minHeight, m_maxHeight);
+		m_boundsChunks.emplace_back(chunk.x, chunk.z);
+	}
+
+	m_shader->Bind();
+	m_permutations->Bind();
+	m_splines->Bind();
+	m_bounds->Bind();
+}
+
+void GpuChunkGenerator::Dispatch(const Chunk& chunk, int boundsIndex)
+{
+	const glm::ivec2 samples(chunk.width * chunk.lod, chunk.height * chunk.lod);
+	m_shader->SetInt2("u_ChunkStart", glm::ivec2(chunk.x * (chunk.width - 1), chunk.z * (chunk.height - 1)));
+	m_shader->SetInt2("u_Samples", samples);
+	m_shader->SetInt("u_Lod", chunk.lod);
+	m_shader->SetInt("u_BoundsIndex", boundsIndex);
+
+	const uint32_t pairCount = (static_cast<uint32_t>(samples.x * samples.y) + 1) / 2;
+	m_shader->Dispatch((pairCount + kWorkGroupSize - 1) / kWorkGroupSize, 1);
+}
+
+void GpuChunkGenerator::End()
+{
+	// The vertex buffers are read as attributes (and maybe read back) after this
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	if (m_boundsFence)
+		glDeleteSync(m_boundsFence);
+	m_boundsFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+float GpuChunkGenerator::Validate(Chunk& chunk, const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend)
+{
+	const size_t vertexCount = chunk.GetVertexCount();
+	std::vector<ChunkVertex> vertices(vertexCount);
+
+	const auto& vertexBuffer = chunk.GetVertexArray()->GetVertexBuffers()[0];
+	glGetNamedBufferSubData(vertexBuffer->GetRendererID(), vertexBuffer->GetOffset(), static_cast<GLsizeiptr>(vertices.size() * sizeof(ChunkVertex)), vertices.data());
+
+	// The GPU evaluates every sample, compare against the dense CPU path
+	NoiseSettings continentalness = continentalnessSettings;
+	NoiseSettings erosion = erosionSettings;
+	continentalness.coarseGrid = false;
+	erosion.coarseGrid = false;
+
+	const HeightMap heightMap(chunk.width, chunk.height, chunk.x, chunk.z, chunk.lod, continentalness, erosion, blend);
+
+	const auto rowSize = static_cast<size_t>(chunk.width * chunk.lod);
+	float maxDifference = 0.f;
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		if (vertices[i].x != i % rowSize || vertices[i].z != i / rowSize)
+			return std::numeric_limits<float>::infinity();
+
+		maxDifference = std::max(maxDifference, std::abs(ChunkVertex::UnpackHeight(vertices[i].height, chunk.GetVertexMinHeight(), chunk.GetVertexHeightScale()) - heightMap[i]));
+	}
+
+	return maxDifference;
+}
+
+void GpuChunkGenerator::SetLayer(const std::string& name, const NoiseSettings& settings, int splineOffset, int splineCount)
+{
+	m_shader->SetFloat(name + ".frequency", settings.frequency);
+	m_shader->SetInt(name + ".octaves", settings.octaves);
+	m_shader->SetFloat(name + ".persistence", settings.persistence);
+	m_shader->SetInt(name + ".splineOffset", splineOffset);
+	m_shader->SetInt(name + ".splineCount", splineCount);
+	m_shader->SetInt(name + ".smoothSpline", settings.spline.IsSmooth());
+	m_shader->SetInt(name + ".terraceCount", settings.terraceCount);
+}
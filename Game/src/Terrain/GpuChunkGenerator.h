@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "../OpenGl/Buffer/ShaderStorageBuffer.h"
+#include "../OpenGl/Shader/Shader.h"
+#include "../PerlinNoise/PerlinGeneration.h"
+
+class Chunk;
+class ChunkArena;
+
+// Runs the HeightMap pipeline in a compute shader and writes the chunk vertices straight
+// into their vertex buffers, nothing is generated on or uploaded from the CPU. The shader also reduces
+// the height range of every chunk, read back without stalling once the GPU is done (see ResolveBounds).
+class GpuChunkGenerator
+{
+public:
+	explicit GpuChunkGenerator(const std::shared_ptr<Shader>& computeShader);
+	~GpuChunkGenerator();
+
+	GpuChunkGenerator(const GpuChunkGenerator&) = delete;
+	GpuChunkGenerator& operator=(const GpuChunkGenerator&) = delete;
+
+	// Uploads the permutations and the compiled splines, the splines must be compiled
+	void SetSettings(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend);
+
+	// Every chunk needs a vertex array whose first vertex buffer can hold GetVertexCount() vertices rounded up to
+	// an even count, the vertices are written in pairs.
+	// The chunks are bounded by the height range of the settings until ResolveBounds, their vertex heights are
+	// normalized over it
+	void Generate(std::vector<Chunk>& chunks);
+
+	// Writes the vertices of every chunk into its range of the arena instead
+	void Generate(std::vector<Chunk>& chunks, ChunkArena& arena);
+
+	// Gives the chunks of the last Generate their reduced height range once the GPU finished it, true then.
+	// chunks must still be the ones generated, wait blocks until the GPU is done
+	bool ResolveBounds(std::vector<Chunk>& chunks, bool wait = false);
+
+	// Reads the vertices of the chunk back and returns the largest height difference with a CPU HeightMap,
+	// infinite when a vertex is not at its grid position
+	float Validate(Chunk& chunk, const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend);
+
+	static std::shared_ptr<GpuChunkGenerator> Create(const std::shared_ptr<Shader>& computeShader)
+	{
+		return std::make_shared<GpuChunkGenerator>(computeShader);
+	}
+
+private:
+	void Begin(std::vector<Chunk>& chunks);
+	void Dispatch(const Chunk& chunk, int boundsIndex);
+	void End();
+
+	void SetLayer(const std::string& name, const NoiseSettings& settings, int splineOffset, int splineCount);
+
+	std::shared_ptr<Shader> m_shader;
+	std::shared_ptr<ShaderStorageBuffer> m_permutations;
+	std::shared_ptr<ShaderStorageBuffer> m_splines;
+	std::shared_ptr<ShaderStorageBuffer> m_bounds;
+
+	// Of the settings, see HeightMap::GetHeightBounds
+	float m_minHeight = 0.f;
+	float m_maxHeight = 0.f;
+
+	// Signaled once the bounds of the chunks of the last Generate are written, null when read
+	GLsync m_boundsFence = nullptr;
+	std::vector<glm::ivec2> m_boundsChunks;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include "gl/glew.h"
 #include "../../libs/noise/PerlinNoise.h"
@@ -13,98 +14,136 @@ Type Map(Type val, Type in_min, Type in_max, Type out_min, Type out_max)
 class HeightMap: public std::vector<float>
 {
 public:
-	int mapWidth;
-	int mapHeight;
+	int mapWidth = 0;
+	int mapHeight = 0;
 	GLuint textureId = 0;
 
 	HeightMap() = default;
 	HeightMap(const int width, const int height, const int x, const int z, const int lod, NoiseSettings& continentalnessSettings, NoiseSettings& erosionSettings, bool blend): mapWidth(width), mapHeight(height)
 	{
-		resize(width * lod * height * lod);
-		const siv::PerlinNoise continentalnessPerlin(continentalnessSettings.seed);
-		const siv::PerlinNoise erosionPerlin(erosionSettings.seed);
+		// Both noise layers are evaluated for the whole chunk at once, see NoiseSettings::SampleNoise
+		const NoiseGrid grid{ x * (width - 1), z * (height - 1), width * lod, height * lod, lod };
 
-        const float startX = x * width + x * -1.f;
-        const float startZ = z * height + z * -1.f;
+		std::vector<float> continentalnessHeights, erosionHeights;
+		SampleLayer(continentalnessSettings, grid, continentalnessHeights);
+		RemapLayer(continentalnessSettings, continentalnessSettings, continentalnessHeights, continentalnessHeights);
 
-		for (int z = 0; z < height * lod; ++z)
+		if (blend)
 		{
-			for (int x = 0; x < width * lod; ++x)
-			{
-                auto x1 = x / (float)lod + startX;
-                auto z1 = z / (float)lod + startZ;
-
-				size_t index = x + z * width * lod;
-
-				const float f = continentalnessSettings.frequency * 0.001f;
-				float continentalnessNoise = continentalnessSettings.GetNoiseValue(continentalnessPerlin, x1 * f, z1 * f);
-
-				if (continentalnessSettings.splinePoints.size() > 1)
-				{
-					auto previousSpline = continentalnessSettings.splinePoints[0];
-					auto currentSpline = continentalnessSettings.splinePoints[0];
-					for (int i = 0; i < continentalnessSettings.splinePoints.size(); ++i)
-					{
-						previousSpline = currentSpline;
-						currentSpline = continentalnessSettings.splinePoints[i];
-						if (continentalnessNoise < continentalnessSettings.splinePoints[i].value)
-						{
-							break;
-						}
-					}
-					continentalnessNoise = Map(continentalnessNoise, previousSpline.value, currentSpline.value, previousSpline.height, currentSpline.height);
-				}
-
-				const float g = erosionSettings.frequency * 0.001f;
-				float erosionNoise = erosionSettings.GetNoiseValue(erosionPerlin, x1 * g, z1 * g);
-
-				if (erosionSettings.splinePoints.size() > 1)
-				{
-					auto previousSpline = erosionSettings.splinePoints[0];
-					auto currentSpline = erosionSettings.splinePoints[0];
-					for (int i = 0; i < erosionSettings.splinePoints.size(); ++i)
-					{
-						previousSpline = currentSpline;
-						currentSpline = erosionSettings.splinePoints[i];
-						if (erosionNoise < erosionSettings.splinePoints[i].value)
-						{
-							break;
-						}
-					}
-					erosionNoise = Map(erosionNoise, previousSpline.value, currentSpline.value, previousSpline.height, currentSpline.height);
-				}
-
-
-				if (continentalnessSettings.ridgeNoise) {
-					continentalnessNoise = Ridgenoise(continentalnessNoise);
-					erosionNoise = Ridgenoise(erosionNoise);
-				}
-
-				if (continentalnessSettings.terraces) {
-					continentalnessNoise = terraceNoise(continentalnessNoise, continentalnessSettings.terraceCount);
-					erosionNoise = terraceNoise(erosionNoise, erosionSettings.terraceCount);
-				}
-
-				float height;
-
-				if (blend) {
-					height = BlendWithSubstractiveErosionNoise(continentalnessNoise, erosionNoise, erosionSettings.factor);
-				} else
-				{
-					height = continentalnessNoise;
-				}
-
-				(*this)[index] = height;
-			}
+			SampleLayer(erosionSettings, grid, erosionHeights);
+			RemapLayer(erosionSettings, continentalnessSettings, erosionHeights, erosionHeights);
+		}
+
+		Blend(continentalnessHeights, erosionHeights, blend, erosionSettings.factor);
+	}
+
+	// Generation stages, Chunk caches the output of each of them
+
+	// Returns false, leaving noise untouched, when the token got cancelled
+	static bool SampleLayer(const NoiseSettings& settings, const NoiseGrid& grid, std::vector<float>& noise, const CancellationToken* token = nullptr)
+	{
+		const siv::PerlinNoise perlin(settings.seed);
+
+		std::vector<double> values(static_cast<size_t>(grid.samplesX) * grid.samplesZ);
+		if (!settings.SampleNoise(perlin, grid, values.data(), token))
+			return false;
+
+		noise.assign(values.begin(), values.end());
+		return true;
+	}
+
+	// Ridges and terraces of both layers are toggled by the continentalness settings (shapeSettings)
+	static void RemapLayer(const NoiseSettings& settings, const NoiseSettings& shapeSettings, const std::vector<float>& noise, std::vector<float>& heights)
+	{
+		heights.resize(noise.size());
+
+		CompiledSpline fallback;
+		GetCompiledSpline(settings, fallback).Apply(noise.data(), heights.data(), noise.size());
+
+		for (float& height : heights)
+		{
+			if (shapeSettings.ridgeNoise)
+				height = Ridgenoise(height);
+
+			if (shapeSettings.terraces)
+				height = terraceNoise(height, settings.terraceCount);
+		}
+	}
+
+	// erosionHeights is only read when blending
+	void Blend(const std::vector<float>& continentalnessHeights, const std::vector<float>& erosionHeights, bool blend, float erosionFactor)
+	{
+		resize(continentalnessHeights.size());
+
+		for (size_t index = 0; index < size(); ++index)
+		{
+			(*this)[index] = blend
+				? BlendWithSubstractiveErosionNoise(continentalnessHeights[index], erosionHeights[index], erosionFactor)
+				: continentalnessHeights[index];
 		}
 	}
 
-	[[nodiscard]] float Ridgenoise(const float h) const
+	// Range every height generated from these settings falls in, whatever the chunk. Follows the stages:
+	// spline over the noise amplitude, ridges, terraces then blend
+	static void GetHeightBounds(const NoiseSettings& continentalnessSettings, const NoiseSettings& erosionSettings, bool blend, float& minHeight, float& maxHeight)
+	{
+		float continentalnessMin, continentalnessMax;
+		GetLayerBounds(continentalnessSettings, continentalnessSettings, continentalnessMin, continentalnessMax);
+		minHeight = continentalnessMin;
+		maxHeight = continentalnessMax;
+		if (!blend)
+			return;
+
+		float erosionMin, erosionMax;
+		GetLayerBounds(erosionSettings, continentalnessSettings, erosionMin, erosionMax);
+
+		// max(0, min(c - e * factor, c)) grows with c and shrinks with e * factor
+		const float factor = erosionSettings.factor;
+		const float erosionValueMin = std::min(erosionMin * factor, erosionMax * factor);
+		const float erosionValueMax = std::max(erosionMin * factor, erosionMax * factor);
+		minHeight = std::max(0.f, std::min(continentalnessMin - erosionValueMax, continentalnessMin));
+		maxHeight = std::max(0.f, std::min(continentalnessMax - erosionValueMin, continentalnessMax));
+	}
+
+	static void GetLayerBounds(const NoiseSettings& settings, const NoiseSettings& shapeSettings, float& minHeight, float& maxHeight)
+	{
+		CompiledSpline fallback;
+		const float amplitude = settings.GetNoiseAmplitude();
+		GetCompiledSpline(settings, fallback).GetOutputRange(-amplitude, amplitude, minHeight, maxHeight);
+
+		// Ridgenoise peaks at 0.5 and falls off on both sides
+		if (shapeSettings.ridgeNoise)
+		{
+			const float ridgeMin = std::min(Ridgenoise(minHeight), Ridgenoise(maxHeight));
+			const float ridgeMax = minHeight <= 0.5f && maxHeight >= 0.5f ? 1.f : std::max(Ridgenoise(minHeight), Ridgenoise(maxHeight));
+			minHeight = ridgeMin;
+			maxHeight = ridgeMax;
+		}
+
+		// Terraces never decrease
+		if (shapeSettings.terraces)
+		{
+			minHeight = terraceNoise(minHeight, settings.terraceCount);
+			maxHeight = terraceNoise(maxHeight, settings.terraceCount);
+		}
+	}
+
+	// Settings compiled by the caller are shared, otherwise the spline is compiled for this height map only
+	static const CompiledSpline& GetCompiledSpline(const NoiseSettings& settings, CompiledSpline& fallback)
+	{
+		if (settings.spline.IsCompiledFrom(settings.splinePoints, settings.smoothSpline))
+			return settings.spline;
+
+		fallback.Compile(settings.splinePoints, settings.smoothSpline);
+		return fallback;
+	}
+
+	[[nodiscard]] static float Ridgenoise(const float h)
 	{
 		return 2 * (0.5 - abs(0.5 - h));
 	}
 
-	[[nodiscard]] float terraceNoise(const float h, const int terraceCount) const
+	[[nodiscard]] static float terraceNoise(const float h, const int terraceCount)
 	{
 		const float terraceHeight = 1.f / terraceCount;
 		return floor(h / terraceHeight) * terraceHeight;
@@ -140,7 +179,7 @@ public:
 	}
 
 
-	float BlendWithSubstractiveErosionNoise(float v1, float erosionNoise, float erosionFactor) {
+	static float BlendWithSubstractiveErosionNoise(float v1, float erosionNoise, float erosionFactor) {
 		const float erosionValue = erosionNoise * erosionFactor;
 		auto v =  std::max(0.f, std::min(v1 - erosionValue, v1));
 		return v;
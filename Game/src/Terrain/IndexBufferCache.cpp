@@ -0,0 +1,49 @@
+#include "IndexBufferCache.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "GeoMipmap.h"
+
+const std::shared_ptr<IndexBuffer>& IndexBufferCache::GetChunkIndexBuffer(int width, int height, int lod, int level, uint8_t stitchMask)
+{
+	auto& indexBuffers = m_indexBuffers[{ width, height, lod }];
+	if (indexBuffers.empty())
+		indexBuffers.resize(static_cast<size_t>(GeoMipmap::GetLevelCount(width, height, lod)) * GeoMipmap::kStitchVariants);
+
+	auto& indexBuffer = indexBuffers[level * GeoMipmap::kStitchVariants + stitchMask];
+	if (indexBuffer)
+		return indexBuffer;
+
+	// 16 bit indices halve the buffers whenever every vertex of the chunk can be addressed
+	const size_t vertexCount = static_cast<size_t>(width) * lod * height * lod;
+	if (vertexCount <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1)
+	{
+		const auto indices = GeoMipmap::GenerateIndices<uint16_t>(width, height, lod, level, stitchMask);
+		indexBuffer = IndexBuffer::Create(indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+	else
+	{
+		auto indices = GeoMipmap::GenerateIndices<uint32_t>(width, height, lod, level, stitchMask);
+		indexBuffer = IndexBuffer::Create(indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+
+	return indexBuffer;
+}
+
+void IndexBufferCache::Trim()
+{
+	for (auto& [size, indexBuffers] : m_indexBuffers)
+	{
+		for (auto& indexBuffer : indexBuffers)
+		{
+			if (indexBuffer.use_count() == 1)
+				indexBuffer.reset();
+		}
+	}
+
+	std::erase_if(m_indexBuffers, [](const auto& entry)
+	{
+		return std::none_of(entry.second.begin(), entry.second.end(), [](const auto& indexBuffer) { return indexBuffer != nullptr; });
+	});
+}
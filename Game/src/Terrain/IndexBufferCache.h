@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "../OpenGl/Buffer/IndexBuffer.h"
+
+// Every chunk of the same size and LOD has the same triangle grids, one per geomipmap level and stitching
+// (see GeoMipmap). Their index buffers are built the first time a chunk draws them and shared by the vertex
+// arrays of all those chunks, so without geomipmapping only the full grid exists.
+// Must be used from the thread owning the GL context.
+class IndexBufferCache
+{
+public:
+	const std::shared_ptr<IndexBuffer>& GetChunkIndexBuffer(int width, int height, int lod, int level = 0, uint8_t stitchMask = 0);
+
+	// Releases the index buffers no vertex array uses anymore
+	void Trim();
+
+private:
+	using SizeKey = std::tuple<int, int, int>;
+
+	// Indexed by level * GeoMipmap::kStitchVariants + stitchMask, null until used
+	std::map<SizeKey, std::vector<std::shared_ptr<IndexBuffer>>> m_indexBuffers;
+};
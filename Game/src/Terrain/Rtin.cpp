@@ -0,0 +1,182 @@
+#include "Rtin.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr float kBaseTierError = 1.f / 16.f;
+	constexpr int kMaxTier = 20;
+
+	struct Grid
+	{
+		int rowSize;
+		int cellsX;
+		int cellsZ;
+		int tileSize;
+
+		Grid(int width, int height, int lod)
+			: rowSize(width * lod), cellsX((width - 1) * lod), cellsZ((height - 1) * lod), tileSize(1)
+		{
+			while (tileSize < std::max(cellsX, cellsZ))
+				tileSize *= 2;
+		}
+
+		[[nodiscard]] int GetSize() const { return tileSize + 1; }
+
+		[[nodiscard]] bool IsOutside(int minX, int minZ) const { return minX >= cellsX || minZ >= cellsZ; }
+
+		[[nodiscard]] bool IsInside(int maxX, int maxZ) const { return maxX <= cellsX && maxZ <= cellsZ; }
+
+		[[nodiscard]] bool IsOnBorder(int x, int z) const { return x == 0 || z == 0 || x == cellsX || z == cellsZ; }
+	};
+
+	class MeshWriter
+	{
+	public:
+		MeshWriter(const Grid& grid, const std::vector<float>& errors, float maxError, std::vector<uint32_t>& samples, std::vector<uint32_t>& indices)
+			: m_grid(grid), m_errors(errors), m_maxError(maxError), m_samples(samples), m_indices(indices),
+			m_vertexOfSample(static_cast<size_t>(grid.rowSize) * (grid.cellsZ + 1), kNoVertex)
+		{
+		}
+
+		// a and b are the ends of the hypotenuse, c the right angle
+		void Triangle(int ax, int az, int bx, int bz, int cx, int cz)
+		{
+			if (m_grid.IsOutside(std::min({ ax, bx, cx }), std::min({ az, bz, cz })))
+				return;
+
+			const int mx = (ax + bx) / 2;
+			const int mz = (az + bz) / 2;
+			const bool canSplit = std::abs(ax - cx) + std::abs(az - cz) > 1;
+			if (canSplit && m_errors[mx + mz * static_cast<size_t>(m_grid.GetSize())] > m_maxError)
+			{
+				Triangle(cx, cz, ax, az, mx, mz);
+				Triangle(bx, bz, cx, cz, mx, mz);
+				return;
+			}
+
+			m_indices.push_back(Vertex(ax, az));
+			m_indices.push_back(Vertex(bx, bz));
+			m_indices.push_back(Vertex(cx, cz));
+		}
+
+	private:
+		static constexpr uint32_t kNoVertex = std::numeric_limits<uint32_t>::max();
+
+		uint32_t Vertex(int x, int z)
+		{
+			const size_t sample = x + z * static_cast<size_t>(m_grid.rowSize);
+			uint32_t& vertex = m_vertexOfSample[sample];
+			if (vertex == kNoVertex)
+			{
+				vertex = static_cast<uint32_t>(m_samples.size());
+				m_samples.push_back(static_cast<uint32_t>(sample));
+			}
+			return vertex;
+		}
+
+		const Grid& m_grid;
+		const std::vector<float>& m_errors;
+		float m_maxError;
+		std::vector<uint32_t>& m_samples;
+		std::vector<uint32_t>& m_indices;
+		std::vector<uint32_t> m_vertexOfSample;
+	};
+}
+
+std::vector<float> Rtin::ComputeErrors(const float* heights, int width, int height, int lod)
+{
+	const Grid grid(width, height, lod);
+	const int size = grid.GetSize();
+	const int tileSize = grid.tileSize;
+
+	std::vector<float> errors(static_cast<size_t>(size) * size, 0.f);
+
+	auto heightAt = [&](int x, int z) { return heights[x + z * static_cast<size_t>(grid.rowSize)]; };
+	auto errorAt = [&](int x, int z) -> float& { return errors[x + z * static_cast<size_t>(size)]; };
+
+	// Triangles are numbered level by level from the two halves of the tile, the smallest ones come last
+	// and are visited first so that every triangle sees the errors of its children
+	const long long smallestCount = static_cast<long long>(tileSize) * tileSize;
+	const long long triangleCount = smallestCount * 2 - 2;
+	const long long lastLevelStart = triangleCount - smallestCount;
+
+	for (long long i = triangleCount - 1; i >= 0; --i)
+	{
+		long long id = i + 2;
+		int ax = 0, az = 0, bx = 0, bz = 0, cx = 0, cz = 0;
+		if (id & 1)
+			bx = bz = cx = tileSize;
+		else
+			ax = az = cz = tileSize;
+
+		while ((id >>= 1) > 1)
+		{
+			const int mx = (ax + bx) / 2;
+			const int mz = (az + bz) / 2;
+			if (id & 1)
+			{
+				bx = ax; bz = az;
+				ax = cx; az = cz;
+			}
+			else
+			{
+				ax = bx; az = bz;
+				bx = cx; bz = cz;
+			}
+			cx = mx; cz = mz;
+		}
+
+		if (grid.IsOutside(std::min({ ax, bx, cx }), std::min({ az, bz, cz })))
+			continue;
+
+		const int mx = (ax + bx) / 2;
+		const int mz = (az + bz) / 2;
+		float& error = errorAt(mx, mz);
+
+		if (!grid.IsInside(std::max({ ax, bx, cx }), std::max({ az, bz, cz })) || grid.IsOnBorder(mx, mz))
+		{
+			error = std::numeric_limits<float>::infinity();
+			continue;
+		}
+
+		const float interpolated = (heightAt(ax, az) + heightAt(bx, bz)) * 0.5f;
+		error = std::max(error, std::abs(interpolated - heightAt(mx, mz)));
+
+		if (i < lastLevelStart)
+		{
+			error = std::max(error, errorAt((ax + cx) / 2, (az + cz) / 2));
+			error = std::max(error, errorAt((bx + cx) / 2, (bz + cz) / 2));
+		}
+	}
+
+	return errors;
+}
+
+void Rtin::Extract(const std::vector<float>& errors, int width, int height, int lod, float maxError, std::vector<uint32_t>& samples, std::vector<uint32_t>& indices)
+{
+	const Grid grid(width, height, lod);
+	const int tileSize = grid.tileSize;
+
+	samples.clear();
+	indices.clear();
+
+	MeshWriter writer(grid, errors, maxError, samples, indices);
+	writer.Triangle(0, 0, tileSize, tileSize, tileSize, 0);
+	writer.Triangle(tileSize, tileSize, 0, 0, 0, tileSize);
+}
+
+int Rtin::GetErrorTier(float maxError)
+{
+	if (!(maxError >= kBaseTierError))
+		return -1;
+
+	return std::min(kMaxTier, static_cast<int>(std::floor(std::log2(maxError / kBaseTierError))));
+}
+
+float Rtin::GetTierError(int tier)
+{
+	return tier < 0 ? 0.f : std::ldexp(kBaseTierError, tier);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Right-triangulated irregular network of the chunk grids (Martini): every triangle splits at the middle of
+// its hypotenuse into two right triangles, down to the cells of the grid. The error of a split vertex is the
+// largest height error of the triangles it splits and of their children, so cutting the hierarchy at any
+// threshold gives a conforming mesh. Chunks whose cell count is not a power of 2 are covered by the next
+// power of 2, the triangles crossing their far edges are always split and those outside are dropped.
+namespace Rtin
+{
+	// Error of every split vertex on a square grid of 2^k + 1 samples covering the chunk.
+	// Vertices on the border of the chunk never merge, so chunks meet whatever their thresholds are
+	std::vector<float> ComputeErrors(const float* heights, int width, int height, int lod);
+
+	// Coarsest mesh of the chunk whose height error stays under maxError. samples receives the height map index
+	// of every vertex and indices the triangles, indexing samples
+	void Extract(const std::vector<float>& errors, int width, int height, int lod, float maxError, std::vector<uint32_t>& samples, std::vector<uint32_t>& indices);
+
+	// Meshes are selected per error tier, which doubles the error each time, so they are only rebuilt
+	// when the camera moves enough to change their tier. Tier -1 allows no error
+	int GetErrorTier(float maxError);
+	float GetTierError(int tier);
+}
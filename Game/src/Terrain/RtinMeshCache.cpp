@@ -0,0 +1,69 @@
+#include "RtinMeshCache.h"
+
+#include "Chunk.h"
+
+namespace
+{
+	// Compacted meshes mostly fit 16 bit indices
+	std::shared_ptr<IndexBuffer> CreateIndexBuffer(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		if (vertexCount > 65536)
+			return IndexBuffer::Create(indices.data(), static_cast<uint32_t>(indices.size()));
+
+		const std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		return IndexBuffer::Create(shortIndices.data(), static_cast<uint32_t>(shortIndices.size()));
+	}
+}
+
+void RtinMeshCache::Update(const std::vector<const Chunk*>& chunks, const glm::vec3& cameraPosition, float errorFactor, float maxPixelError)
+{
+	++m_frame;
+	m_triangleCount = 0;
+	m_vertexCount = 0;
+
+	std::vector<ChunkVertex> vertices;
+	std::vector<uint32_t> indices;
+	for (const Chunk* chunk : chunks)
+	{
+		if (!chunk->HasAdaptiveMesh())
+			continue;
+
+		const int tier = Rtin::GetErrorTier(maxPixelError * chunk->GetDistance(cameraPosition) / errorFactor);
+
+		Mesh& mesh = m_meshes.Insert({ chunk->x, chunk->z });
+		mesh.frame = m_frame;
+		if (!mesh.vertexArray || mesh.heightKey != chunk->GetHeightKey() || mesh.tier != tier)
+		{
+			chunk->GenerateAdaptiveMesh(Rtin::GetTierError(tier), vertices, indices);
+
+			const auto vertexBuffer = VertexBuffer::Create(vertices.data(), static_cast<uint32_t>(sizeof(ChunkVertex) * vertices.size()));
+			vertexBuffer->SetLayout(Chunk::GetVertexLayout());
+
+			mesh.vertexArray = VertexArray::Create();
+			mesh.vertexArray->AddVertexBuffer(vertexBuffer);
+			mesh.vertexArray->SetIndexBuffer(CreateIndexBuffer(indices, vertices.size()));
+
+			mesh.heightKey = chunk->GetHeightKey();
+			mesh.tier = tier;
+			mesh.vertexCount = vertices.size();
+		}
+
+		m_triangleCount += mesh.vertexArray->GetIndexBuffer()->GetCount() / 3;
+		m_vertexCount += mesh.vertexCount;
+	}
+
+	m_meshes.EraseIf([this](ChunkCoord, const Mesh& mesh) { return mesh.frame != m_frame; });
+}
+
+const std::shared_ptr<VertexArray>* RtinMeshCache::Find(const Chunk& chunk) const
+{
+	const Mesh* mesh = m_meshes.Find({ chunk.x, chunk.z });
+	return mesh ? &mesh->vertexArray : nullptr;
+}
+
+void RtinMeshCache::Clear()
+{
+	m_meshes.Clear();
+	m_triangleCount = 0;
+	m_vertexCount = 0;
+}
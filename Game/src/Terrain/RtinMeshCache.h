@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkMap.h"
+#include "../OpenGl/Buffer/VertexArray.h"
+
+class Chunk;
+
+// Adaptive (RTIN) meshes of the chunks, each with its own compacted vertex and index buffers.
+// A mesh is rebuilt when the heights of its chunk or its error tier change, see Rtin::GetErrorTier.
+// Must be used from the thread owning the GL context.
+class RtinMeshCache
+{
+public:
+	// Picks the error of every chunk so it projects to at most maxPixelError pixels, like GeoMipmap::SelectLevels,
+	// and rebuilds the meshes that changed. The meshes of the chunks missing from the list are released
+	void Update(const std::vector<const Chunk*>& chunks, const glm::vec3& cameraPosition, float errorFactor, float maxPixelError);
+
+	// Null for chunks without an adaptive mesh, which keep their own vertex array
+	[[nodiscard]] const std::shared_ptr<VertexArray>* Find(const Chunk& chunk) const;
+
+	[[nodiscard]] size_t GetTriangleCount() const { return m_triangleCount; }
+	[[nodiscard]] size_t GetVertexCount() const { return m_vertexCount; }
+
+	void Clear();
+
+private:
+	struct Mesh
+	{
+		uint64_t heightKey = 0;
+		int tier = 0;
+		uint32_t frame = 0;
+		size_t vertexCount = 0;
+		std::shared_ptr<VertexArray> vertexArray;
+	};
+
+	ChunkMap<Mesh> m_meshes;
+	uint32_t m_frame = 0;
+
+	size_t m_triangleCount = 0;
+	size_t m_vertexCount = 0;
+};
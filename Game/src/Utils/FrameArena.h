@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data living until the end of a frame: allocating is moving an offset, Reset frees
+// everything at once. A frame outgrowing the current block chains new ones, Reset then merges them into
+// one block large enough for the whole frame. Only for trivially destructible types, nothing is destroyed.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t blockSize = 64 << 10) : m_blockSize(blockSize) {}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Uninitialised storage for count values
+	template<typename T>
+	T* Allocate(size_t count = 1)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Frame arena values are never destroyed");
+		return static_cast<T*>(AllocateBytes(sizeof(T) * count, alignof(T)));
+	}
+
+	template<typename T>
+	std::span<T> Copy(std::span<const T> values)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Frame arena values are copied by their bytes");
+		if (values.empty())
+			return {};
+
+		T* copy = Allocate<T>(values.size());
+		std::memcpy(copy, values.data(), values.size_bytes());
+		return { copy, values.size() };
+	}
+
+	void Reset()
+	{
+		if (m_blocks.size() > 1)
+		{
+			m_blockSize = std::max(m_blockSize, m_capacity);
+			m_blocks.clear();
+			m_capacity = 0;
+		}
+
+		m_block = 0;
+		m_offset = 0;
+		m_usedSize = 0;
+	}
+
+	[[nodiscard]] size_t GetUsedSize() const { return m_usedSize; }
+	[[nodiscard]] size_t GetCapacity() const { return m_capacity; }
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+
+	void* AllocateBytes(size_t size, size_t alignment)
+	{
+		while (true)
+		{
+			if (m_block < m_blocks.size())
+			{
+				Block& block = m_blocks[m_block];
+				const size_t offset = (m_offset + alignment - 1) / alignment * alignment;
+				if (offset + size <= block.size)
+				{
+					m_offset = offset + size;
+					m_usedSize += size;
+					return block.data.get() + offset;
+				}
+
+				if (m_block + 1 < m_blocks.size())
+				{
+					++m_block;
+					m_offset = 0;
+					continue;
+				}
+			}
+
+			// new[] aligns for any fundamental type
+			const size_t blockSize = std::max(m_blockSize, size);
+			m_blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+			m_capacity += blockSize;
+			m_block = m_blocks.size() - 1;
+			m_offset = 0;
+		}
+	}
+
+	size_t m_blockSize;
+	std::vector<Block> m_blocks;
+	size_t m_block = 0;
+	size_t m_offset = 0;
+	size_t m_usedSize = 0;
+	size_t m_capacity = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace Hash
+{
+	constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+	constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+	// 64 bit FNV-1a, pass a previous hash as seed to chain several values
+	constexpr uint64_t Fnv1a(const void* data, size_t size, uint64_t seed = kFnvOffset)
+	{
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= kFnvPrime;
+		}
+		return hash;
+	}
+
+	constexpr uint64_t Fnv1a(std::string_view text, uint64_t seed = kFnvOffset)
+	{
+		uint64_t hash = seed;
+		for (const char c : text)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= kFnvPrime;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	uint64_t Combine(uint64_t seed, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be hashed by their bytes");
+		return Fnv1a(&value, sizeof(T), seed);
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read only view of a whole file mapped in memory, the pages are loaded on first access
+class MappedFile
+{
+public:
+	// Empty when the file cannot be opened or is empty
+	explicit MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	explicit operator bool() const { return m_data != nullptr; }
+
+	[[nodiscard]] const uint8_t* GetData() const { return m_data; }
+	[[nodiscard]] size_t GetSize() const { return m_size; }
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
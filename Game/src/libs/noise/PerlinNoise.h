@@ -26,6 +26,8 @@
 //----------------------------------------------------------------------------------------
 
 # pragma once
+# include <cmath>
+# include <cstddef>
 # include <cstdint>
 # include <algorithm>
 # include <array>
@@ -38,6 +40,27 @@
 #	include <concepts>
 # endif
 
+// SIMD batch kernels are only available on x86
+# if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define SIVPERLIN_SIMD 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#	endif
+# else
+#	define SIVPERLIN_SIMD 0
+# endif
+
+// Lets a function use an instruction set the rest of the program is not compiled for.
+// GCC would fuse mul + add into FMA where AVX-512 implies it, which breaks bit-identical results.
+# if SIVPERLIN_SIMD && defined(__clang__)
+#	define SIVPERLIN_TARGET(isa) __attribute__((target(isa)))
+# elif SIVPERLIN_SIMD && defined(__GNUC__)
+#	define SIVPERLIN_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+# else
+#	define SIVPERLIN_TARGET(isa)
+# endif
+
 
 // Library major version
 # define SIVPERLIN_VERSION_MAJOR			3
@@ -236,6 +259,13 @@ namespace siv
 		[[nodiscard]]
 		value_type normalizedOctave3D_01(value_type x, value_type y, value_type z, std::int32_t octaves, value_type persistence = value_type(0.5)) const noexcept;
 
+		///////////////////////////////////////
+		//
+		//	Batch octave noise (Same results as octave2D(), evaluated with the widest SIMD kernel the CPU supports)
+		//
+
+		void octave2DBatch(const value_type* xs, const value_type* ys, value_type* results, std::size_t count, std::int32_t octaves, value_type persistence = value_type(0.5)) const noexcept;
+
 	private:
 
 		state_type m_permutation;
@@ -403,6 +433,406 @@ namespace siv
 
 			return result;
 		}
+
+		////////////////////////////////////////////////
+		//
+		//	SIMD kernels for octave2DBatch().
+		//	Every lane runs the same operations in the same order as noise3D(x, y, SIVPERLIN_DEFAULT_Z),
+		//	so the results are bit-identical to the scalar path.
+		//
+		enum class SimdLevel
+		{
+			Scalar,
+			SSE42,
+			AVX2,
+			AVX512,
+		};
+
+		[[nodiscard]]
+		inline SimdLevel DetectSimdLevel() noexcept
+		{
+		# if SIVPERLIN_SIMD && defined(_MSC_VER) && !defined(__clang__)
+			int info[4] = {};
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			const bool sse42 = (info[2] & (1 << 20)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const std::uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+			const bool avxState = (xcr0 & 0x6) == 0x6;
+			const bool avx512State = (xcr0 & 0xE6) == 0xE6;
+
+			bool avx2 = false, avx512 = false;
+			if (maxLeaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+				avx512 = (info[1] & (1 << 16)) != 0;
+			}
+
+			if (avx512 && avx512State)
+				return SimdLevel::AVX512;
+			if (avx2 && avxState)
+				return SimdLevel::AVX2;
+			if (sse42)
+				return SimdLevel::SSE42;
+		# elif SIVPERLIN_SIMD
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f"))
+				return SimdLevel::AVX512;
+			if (__builtin_cpu_supports("avx2"))
+				return SimdLevel::AVX2;
+			if (__builtin_cpu_supports("sse4.2"))
+				return SimdLevel::SSE42;
+		# endif
+			return SimdLevel::Scalar;
+		}
+
+		[[nodiscard]]
+		inline SimdLevel GetSimdLevel() noexcept
+		{
+			static const SimdLevel level = DetectSimdLevel();
+			return level;
+		}
+
+		// 256 permutation entries widened to 32 bits and repeated once, so that
+		// the (index + 1) and (hash + i) lookups never need the "& 255" mask
+		using BatchPermutation = std::array<std::int32_t, 512>;
+
+	# if SIVPERLIN_SIMD
+
+		SIVPERLIN_TARGET("sse4.2")
+		inline __m128d FadeSSE42(const __m128d t) noexcept
+		{
+			const __m128d t3 = _mm_mul_pd(_mm_mul_pd(t, t), t);
+			const __m128d inner = _mm_add_pd(_mm_mul_pd(t, _mm_sub_pd(_mm_mul_pd(t, _mm_set1_pd(6)), _mm_set1_pd(15))), _mm_set1_pd(10));
+			return _mm_mul_pd(t3, inner);
+		}
+
+		SIVPERLIN_TARGET("sse4.2")
+		inline __m128d LerpSSE42(const __m128d a, const __m128d b, const __m128d t) noexcept
+		{
+			return _mm_add_pd(a, _mm_mul_pd(_mm_sub_pd(b, a), t));
+		}
+
+		SIVPERLIN_TARGET("sse4.2")
+		inline __m128d GradSSE42(const __m128i hash, const __m128d x, const __m128d y, const __m128d z) noexcept
+		{
+			const __m128i h = _mm_and_si128(hash, _mm_set1_epi64x(15));
+			const __m128d uIsY = _mm_castsi128_pd(_mm_cmpgt_epi64(h, _mm_set1_epi64x(7)));
+			const __m128d vIsY = _mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(4), h));
+			const __m128d vIsX = _mm_castsi128_pd(_mm_or_si128(_mm_cmpeq_epi64(h, _mm_set1_epi64x(12)), _mm_cmpeq_epi64(h, _mm_set1_epi64x(14))));
+			const __m128d u = _mm_blendv_pd(x, y, uIsY);
+			const __m128d v = _mm_blendv_pd(_mm_blendv_pd(z, x, vIsX), y, vIsY);
+			const __m128d signU = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(1)), 63));
+			const __m128d signV = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(h, _mm_set1_epi64x(2)), 62));
+			return _mm_add_pd(_mm_xor_pd(u, signU), _mm_xor_pd(v, signV));
+		}
+
+		// No gather before AVX2: the hashes are computed per lane, only the floating point part is vectorized
+		SIVPERLIN_TARGET("sse4.2")
+		inline std::size_t Octave2DBatchSSE42(const BatchPermutation& p, const double* xs, const double* ys, double* results, const std::size_t count, const std::int32_t octaves, const double persistence) noexcept
+		{
+			const double z = static_cast<double>(SIVPERLIN_DEFAULT_Z);
+			const double _z = std::floor(z);
+			const std::int32_t iz = static_cast<std::int32_t>(_z) & 255;
+			const __m128d fz = _mm_set1_pd(z - _z);
+			const __m128d fz1 = _mm_set1_pd((z - _z) - 1);
+			const __m128d w = _mm_set1_pd(Fade(z - _z));
+			const __m128d one = _mm_set1_pd(1);
+
+			const std::size_t end = count - count % 2;
+			for (std::size_t i = 0; i < end; i += 2)
+			{
+				__m128d x = _mm_loadu_pd(xs + i);
+				__m128d y = _mm_loadu_pd(ys + i);
+				__m128d result = _mm_setzero_pd();
+				double amplitude = 1;
+
+				for (std::int32_t octave = 0; octave < octaves; ++octave)
+				{
+					const __m128d _x = _mm_floor_pd(x);
+					const __m128d _y = _mm_floor_pd(y);
+
+					alignas(16) std::int32_t ix[4], iy[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(ix), _mm_cvttpd_epi32(_x));
+					_mm_store_si128(reinterpret_cast<__m128i*>(iy), _mm_cvttpd_epi32(_y));
+
+					alignas(16) std::int64_t hashes[8][2];
+					for (int lane = 0; lane < 2; ++lane)
+					{
+						const std::int32_t A = p[ix[lane] & 255] + (iy[lane] & 255);
+						const std::int32_t B = p[(ix[lane] & 255) + 1] + (iy[lane] & 255);
+						const std::int32_t AA = p[A] + iz;
+						const std::int32_t AB = p[A + 1] + iz;
+						const std::int32_t BA = p[B] + iz;
+						const std::int32_t BB = p[B + 1] + iz;
+						hashes[0][lane] = p[AA];
+						hashes[1][lane] = p[BA];
+						hashes[2][lane] = p[AB];
+						hashes[3][lane] = p[BB];
+						hashes[4][lane] = p[AA + 1];
+						hashes[5][lane] = p[BA + 1];
+						hashes[6][lane] = p[AB + 1];
+						hashes[7][lane] = p[BB + 1];
+					}
+
+					const __m128d fx = _mm_sub_pd(x, _x);
+					const __m128d fy = _mm_sub_pd(y, _y);
+					const __m128d fx1 = _mm_sub_pd(fx, one);
+					const __m128d fy1 = _mm_sub_pd(fy, one);
+					const __m128d u = FadeSSE42(fx);
+					const __m128d v = FadeSSE42(fy);
+
+					__m128i h[8];
+					for (int corner = 0; corner < 8; ++corner)
+					{
+						h[corner] = _mm_load_si128(reinterpret_cast<const __m128i*>(hashes[corner]));
+					}
+
+					const __m128d q0 = LerpSSE42(GradSSE42(h[0], fx, fy, fz), GradSSE42(h[1], fx1, fy, fz), u);
+					const __m128d q1 = LerpSSE42(GradSSE42(h[2], fx, fy1, fz), GradSSE42(h[3], fx1, fy1, fz), u);
+					const __m128d q2 = LerpSSE42(GradSSE42(h[4], fx, fy, fz1), GradSSE42(h[5], fx1, fy, fz1), u);
+					const __m128d q3 = LerpSSE42(GradSSE42(h[6], fx, fy1, fz1), GradSSE42(h[7], fx1, fy1, fz1), u);
+					const __m128d noise = LerpSSE42(LerpSSE42(q0, q1, v), LerpSSE42(q2, q3, v), w);
+
+					result = _mm_add_pd(result, _mm_mul_pd(noise, _mm_set1_pd(amplitude)));
+					x = _mm_mul_pd(x, _mm_set1_pd(2));
+					y = _mm_mul_pd(y, _mm_set1_pd(2));
+					amplitude *= persistence;
+				}
+
+				_mm_storeu_pd(results + i, result);
+			}
+
+			return end;
+		}
+
+		SIVPERLIN_TARGET("avx2")
+		inline __m256d FadeAVX2(const __m256d t) noexcept
+		{
+			const __m256d t3 = _mm256_mul_pd(_mm256_mul_pd(t, t), t);
+			const __m256d inner = _mm256_add_pd(_mm256_mul_pd(t, _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6)), _mm256_set1_pd(15))), _mm256_set1_pd(10));
+			return _mm256_mul_pd(t3, inner);
+		}
+
+		SIVPERLIN_TARGET("avx2")
+		inline __m256d LerpAVX2(const __m256d a, const __m256d b, const __m256d t) noexcept
+		{
+			return _mm256_add_pd(a, _mm256_mul_pd(_mm256_sub_pd(b, a), t));
+		}
+
+		SIVPERLIN_TARGET("avx2")
+		inline __m256d GradAVX2(const __m128i hash, const __m256d x, const __m256d y, const __m256d z) noexcept
+		{
+			const __m256i h = _mm256_and_si256(_mm256_cvtepi32_epi64(hash), _mm256_set1_epi64x(15));
+			const __m256d uIsY = _mm256_castsi256_pd(_mm256_cmpgt_epi64(h, _mm256_set1_epi64x(7)));
+			const __m256d vIsY = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h));
+			const __m256d vIsX = _mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)), _mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14))));
+			const __m256d u = _mm256_blendv_pd(x, y, uIsY);
+			const __m256d v = _mm256_blendv_pd(_mm256_blendv_pd(z, x, vIsX), y, vIsY);
+			const __m256d signU = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(1)), 63));
+			const __m256d signV = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(2)), 62));
+			return _mm256_add_pd(_mm256_xor_pd(u, signU), _mm256_xor_pd(v, signV));
+		}
+
+		SIVPERLIN_TARGET("avx2")
+		inline __m128i GatherAVX2(const int* table, const __m128i index) noexcept
+		{
+			return _mm_i32gather_epi32(table, index, 4);
+		}
+
+		SIVPERLIN_TARGET("avx2")
+		inline std::size_t Octave2DBatchAVX2(const BatchPermutation& p, const double* xs, const double* ys, double* results, const std::size_t count, const std::int32_t octaves, const double persistence) noexcept
+		{
+			const double z = static_cast<double>(SIVPERLIN_DEFAULT_Z);
+			const double _z = std::floor(z);
+			const __m128i iz = _mm_set1_epi32(static_cast<std::int32_t>(_z) & 255);
+			const __m256d fz = _mm256_set1_pd(z - _z);
+			const __m256d fz1 = _mm256_set1_pd((z - _z) - 1);
+			const __m256d w = _mm256_set1_pd(Fade(z - _z));
+			const __m256d one = _mm256_set1_pd(1);
+			const __m128i mask = _mm_set1_epi32(255);
+			const __m128i next = _mm_set1_epi32(1);
+			const int* table = p.data();
+
+			const std::size_t end = count - count % 4;
+			for (std::size_t i = 0; i < end; i += 4)
+			{
+				__m256d x = _mm256_loadu_pd(xs + i);
+				__m256d y = _mm256_loadu_pd(ys + i);
+				__m256d result = _mm256_setzero_pd();
+				double amplitude = 1;
+
+				for (std::int32_t octave = 0; octave < octaves; ++octave)
+				{
+					const __m256d _x = _mm256_floor_pd(x);
+					const __m256d _y = _mm256_floor_pd(y);
+					const __m128i ix = _mm_and_si128(_mm256_cvttpd_epi32(_x), mask);
+					const __m128i iy = _mm_and_si128(_mm256_cvttpd_epi32(_y), mask);
+
+					const __m128i A = _mm_add_epi32(GatherAVX2(table, ix), iy);
+					const __m128i B = _mm_add_epi32(GatherAVX2(table, _mm_add_epi32(ix, next)), iy);
+					const __m128i AA = _mm_add_epi32(GatherAVX2(table, A), iz);
+					const __m128i AB = _mm_add_epi32(GatherAVX2(table, _mm_add_epi32(A, next)), iz);
+					const __m128i BA = _mm_add_epi32(GatherAVX2(table, B), iz);
+					const __m128i BB = _mm_add_epi32(GatherAVX2(table, _mm_add_epi32(B, next)), iz);
+
+					const __m256d fx = _mm256_sub_pd(x, _x);
+					const __m256d fy = _mm256_sub_pd(y, _y);
+					const __m256d fx1 = _mm256_sub_pd(fx, one);
+					const __m256d fy1 = _mm256_sub_pd(fy, one);
+					const __m256d u = FadeAVX2(fx);
+					const __m256d v = FadeAVX2(fy);
+
+					const __m256d q0 = LerpAVX2(GradAVX2(GatherAVX2(table, AA), fx, fy, fz), GradAVX2(GatherAVX2(table, BA), fx1, fy, fz), u);
+					const __m256d q1 = LerpAVX2(GradAVX2(GatherAVX2(table, AB), fx, fy1, fz), GradAVX2(GatherAVX2(table, BB), fx1, fy1, fz), u);
+					const __m256d q2 = LerpAVX2(GradAVX2(GatherAVX2(table, _mm_add_epi32(AA, next)), fx, fy, fz1), GradAVX2(GatherAVX2(table, _mm_add_epi32(BA, next)), fx1, fy, fz1), u);
+					const __m256d q3 = LerpAVX2(GradAVX2(GatherAVX2(table, _mm_add_epi32(AB, next)), fx, fy1, fz1), GradAVX2(GatherAVX2(table, _mm_add_epi32(BB, next)), fx1, fy1, fz1), u);
+					const __m256d noise = LerpAVX2(LerpAVX2(q0, q1, v), LerpAVX2(q2, q3, v), w);
+
+					result = _mm256_add_pd(result, _mm256_mul_pd(noise, _mm256_set1_pd(amplitude)));
+					x = _mm256_mul_pd(x, _mm256_set1_pd(2));
+					y = _mm256_mul_pd(y, _mm256_set1_pd(2));
+					amplitude *= persistence;
+				}
+
+				_mm256_storeu_pd(results + i, result);
+			}
+
+			return end;
+		}
+
+		SIVPERLIN_TARGET("avx512f")
+		inline __m512d FadeAVX512(const __m512d t) noexcept
+		{
+			const __m512d t3 = _mm512_mul_pd(_mm512_mul_pd(t, t), t);
+			const __m512d inner = _mm512_add_pd(_mm512_mul_pd(t, _mm512_sub_pd(_mm512_mul_pd(t, _mm512_set1_pd(6)), _mm512_set1_pd(15))), _mm512_set1_pd(10));
+			return _mm512_mul_pd(t3, inner);
+		}
+
+		SIVPERLIN_TARGET("avx512f")
+		inline __m512d LerpAVX512(const __m512d a, const __m512d b, const __m512d t) noexcept
+		{
+			return _mm512_add_pd(a, _mm512_mul_pd(_mm512_sub_pd(b, a), t));
+		}
+
+		SIVPERLIN_TARGET("avx512f")
+		inline __m512d GradAVX512(const __m256i hash, const __m512d x, const __m512d y, const __m512d z) noexcept
+		{
+			const __m512i h = _mm512_and_si512(_mm512_cvtepi32_epi64(hash), _mm512_set1_epi64(15));
+			const __mmask8 uIsY = _mm512_cmpgt_epi64_mask(h, _mm512_set1_epi64(7));
+			const __mmask8 vIsY = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(4));
+			const __mmask8 vIsX = _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(12)) | _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(14));
+			const __m512i u = _mm512_castpd_si512(_mm512_mask_blend_pd(uIsY, x, y));
+			const __m512i v = _mm512_castpd_si512(_mm512_mask_blend_pd(vIsY, _mm512_mask_blend_pd(vIsX, z, x), y));
+			const __m512i signU = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(1)), 63);
+			const __m512i signV = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(2)), 62);
+			return _mm512_add_pd(_mm512_castsi512_pd(_mm512_xor_si512(u, signU)), _mm512_castsi512_pd(_mm512_xor_si512(v, signV)));
+		}
+
+		SIVPERLIN_TARGET("avx512f")
+		inline __m256i GatherAVX512(const int* table, const __m256i index) noexcept
+		{
+			return _mm256_i32gather_epi32(table, index, 4);
+		}
+
+		SIVPERLIN_TARGET("avx512f")
+		inline std::size_t Octave2DBatchAVX512(const BatchPermutation& p, const double* xs, const double* ys, double* results, const std::size_t count, const std::int32_t octaves, const double persistence) noexcept
+		{
+			const double z = static_cast<double>(SIVPERLIN_DEFAULT_Z);
+			const double _z = std::floor(z);
+			const __m256i iz = _mm256_set1_epi32(static_cast<std::int32_t>(_z) & 255);
+			const __m512d fz = _mm512_set1_pd(z - _z);
+			const __m512d fz1 = _mm512_set1_pd((z - _z) - 1);
+			const __m512d w = _mm512_set1_pd(Fade(z - _z));
+			const __m512d one = _mm512_set1_pd(1);
+			const __m256i mask = _mm256_set1_epi32(255);
+			const __m256i next = _mm256_set1_epi32(1);
+			const int* table = p.data();
+
+			const std::size_t end = count - count % 8;
+			for (std::size_t i = 0; i < end; i += 8)
+			{
+				__m512d x = _mm512_loadu_pd(xs + i);
+				__m512d y = _mm512_loadu_pd(ys + i);
+				__m512d result = _mm512_setzero_pd();
+				double amplitude = 1;
+
+				for (std::int32_t octave = 0; octave < octaves; ++octave)
+				{
+					const __m512d _x = _mm512_roundscale_pd(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+					const __m512d _y = _mm512_roundscale_pd(y, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+					const __m256i ix = _mm256_and_si256(_mm512_cvttpd_epi32(_x), mask);
+					const __m256i iy = _mm256_and_si256(_mm512_cvttpd_epi32(_y), mask);
+
+					const __m256i A = _mm256_add_epi32(GatherAVX512(table, ix), iy);
+					const __m256i B = _mm256_add_epi32(GatherAVX512(table, _mm256_add_epi32(ix, next)), iy);
+					const __m256i AA = _mm256_add_epi32(GatherAVX512(table, A), iz);
+					const __m256i AB = _mm256_add_epi32(GatherAVX512(table, _mm256_add_epi32(A, next)), iz);
+					const __m256i BA = _mm256_add_epi32(GatherAVX512(table, B), iz);
+					const __m256i BB = _mm256_add_epi32(GatherAVX512(table, _mm256_add_epi32(B, next)), iz);
+
+					const __m512d fx = _mm512_sub_pd(x, _x);
+					const __m512d fy = _mm512_sub_pd(y, _y);
+					const __m512d fx1 = _mm512_sub_pd(fx, one);
+					const __m512d fy1 = _mm512_sub_pd(fy, one);
+					const __m512d u = FadeAVX512(fx);
+					const __m512d v = FadeAVX512(fy);
+
+					const __m512d q0 = LerpAVX512(GradAVX512(GatherAVX512(table, AA), fx, fy, fz), GradAVX512(GatherAVX512(table, BA), fx1, fy, fz), u);
+					const __m512d q1 = LerpAVX512(GradAVX512(GatherAVX512(table, AB), fx, fy1, fz), GradAVX512(GatherAVX512(table, BB), fx1, fy1, fz), u);
+					const __m512d q2 = LerpAVX512(GradAVX512(GatherAVX512(table, _mm256_add_epi32(AA, next)), fx, fy, fz1), GradAVX512(GatherAVX512(table, _mm256_add_epi32(BA, next)), fx1, fy, fz1), u);
+					const __m512d q3 = LerpAVX512(GradAVX512(GatherAVX512(table, _mm256_add_epi32(AB, next)), fx, fy1, fz1), GradAVX512(GatherAVX512(table, _mm256_add_epi32(BB, next)), fx1, fy1, fz1), u);
+					const __m512d noise = LerpAVX512(LerpAVX512(q0, q1, v), LerpAVX512(q2, q3, v), w);
+
+					result = _mm512_add_pd(result, _mm512_mul_pd(noise, _mm512_set1_pd(amplitude)));
+					x = _mm512_mul_pd(x, _mm512_set1_pd(2));
+					y = _mm512_mul_pd(y, _mm512_set1_pd(2));
+					amplitude *= persistence;
+				}
+
+				_mm512_storeu_pd(results + i, result);
+			}
+
+			return end;
+		}
+
+	# endif
+
+		// Returns how many samples were computed, the remaining tail is left to the scalar path
+		[[nodiscard]]
+		inline std::size_t Octave2DBatch(const std::array<std::uint8_t, 256>& permutation, const double* xs, const double* ys, double* results, const std::size_t count, const std::int32_t octaves, const double persistence) noexcept
+		{
+		# if SIVPERLIN_SIMD
+			const SimdLevel level = GetSimdLevel();
+			if (level == SimdLevel::Scalar)
+			{
+				return 0;
+			}
+
+			BatchPermutation table;
+			for (std::size_t i = 0; i < table.size(); ++i)
+			{
+				table[i] = permutation[i & 255];
+			}
+
+			switch (level)
+			{
+			case SimdLevel::AVX512:
+				return Octave2DBatchAVX512(table, xs, ys, results, count, octaves, persistence);
+			case SimdLevel::AVX2:
+				return Octave2DBatchAVX2(table, xs, ys, results, count, octaves, persistence);
+			case SimdLevel::SSE42:
+				return Octave2DBatchSSE42(table, xs, ys, results, count, octaves, persistence);
+			default:
+				return 0;
+			}
+		# else
+			return 0;
+		# endif
+		}
 	}
 
 	///////////////////////////////////////
@@ -652,8 +1082,29 @@ namespace siv
 	{
 		return perlin_detail::Remap_01(normalizedOctave3D(x, y, z, octaves, persistence));
 	}
+
+	///////////////////////////////////////
+
+	template <class Float>
+	inline void BasicPerlinNoise<Float>::octave2DBatch(const value_type* xs, const value_type* ys, value_type* results, const std::size_t count, const std::int32_t octaves, const value_type persistence) const noexcept
+	{
+		std::size_t done = 0;
+
+		// The kernels work on doubles, other precisions go through the scalar path
+		if constexpr (std::is_same_v<Float, double>)
+		{
+			done = perlin_detail::Octave2DBatch(m_permutation, xs, ys, results, count, octaves, persistence);
+		}
+
+		for (std::size_t i = done; i < count; ++i)
+		{
+			results[i] = octave2D(xs[i], ys[i], octaves, persistence);
+		}
+	}
 }
 
 # undef SIVPERLIN_NODISCARD_CXX20
 # undef SIVPERLIN_CONCEPT_URBG
 # undef SIVPERLIN_CONCEPT_URBG_
+# undef SIVPERLIN_TARGET
+# undef SIVPERLIN_SIMD
@@ -0,0 +1,159 @@
+// Generates chunks with GpuChunkGenerator in a headless context and compares their heights with the CPU
+// HeightMap. Needs no window or display: the context is surfaceless EGL, ctest runs it on Mesa llvmpipe.
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../src/OpenGl/Buffer/VertexArray.h"
+#include "../src/PerlinNoise/PerlinGeneration.h"
+#include "../src/Terrain/Chunk.h"
+#include "../src/Terrain/GpuChunkGenerator.h"
+
+namespace
+{
+	// Same as the DEBUG tab check
+	constexpr float kTolerance = 0.01f;
+
+	struct TestCase
+	{
+		std::string name;
+		NoiseSettings continentalness;
+		NoiseSettings erosion;
+		bool blend;
+	};
+
+	bool CreateHeadlessContext()
+	{
+		EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		EGLint major, minor;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+			return false;
+
+		const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, 0, EGL_NONE };
+		EGLConfig config;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+			return false;
+
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 6,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE,
+		};
+		const EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+
+		// No surface to draw to, the test only dispatches compute work
+		return context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+	}
+
+	// Largest difference of the heights and of the reduced height ranges over a few chunks, negative coordinates,
+	// a finer lod and an odd vertex count included. Infinite when a range escapes the bounds of the settings
+	float Run(GpuChunkGenerator& generator, TestCase& test)
+	{
+		test.continentalness.CompileSpline();
+		test.erosion.CompileSpline();
+
+		const int coordinates[][4] = { { 0, 0, 1, 32 }, { 1, 0, 1, 32 }, { -2, 3, 1, 32 }, { 2, -1, 2, 32 }, { 3, 1, 1, 33 } };
+
+		std::vector<Chunk> chunks;
+		for (const auto& [x, z, lod, size] : coordinates)
+		{
+			Chunk& chunk = chunks.emplace_back(x, z, size, size, lod);
+
+			const auto vertexBuffer = VertexBuffer::Create(static_cast<uint32_t>(sizeof(ChunkVertex) * chunk.GetVertexCount()));
+			vertexBuffer->SetLayout(Chunk::GetVertexLayout());
+			const auto vertexArray = VertexArray::Create();
+			vertexArray->AddVertexBuffer(vertexBuffer);
+			chunk.SetVertexArray(vertexArray);
+		}
+
+		generator.SetSettings(test.continentalness, test.erosion, test.blend);
+		generator.Generate(chunks);
+
+		float minBound, maxBound;
+		HeightMap::GetHeightBounds(test.continentalness, test.erosion, test.blend, minBound, maxBound);
+		if (!generator.ResolveBounds(chunks, true))
+			return std::numeric_limits<float>::infinity();
+
+		float maxDifference = 0.f;
+		for (Chunk& chunk : chunks)
+		{
+			maxDifference = std::max(maxDifference, generator.Validate(chunk, test.continentalness, test.erosion, test.blend));
+
+			// The reduced range is the one of the CPU heights, within the range of the settings
+			NoiseSettings continentalness = test.continentalness;
+			NoiseSettings erosion = test.erosion;
+			continentalness.coarseGrid = false;
+			erosion.coarseGrid = false;
+			const HeightMap heightMap(chunk.width, chunk.height, chunk.x, chunk.z, chunk.lod, continentalness, erosion, test.blend);
+			const auto [minHeight, maxHeight] = std::minmax_element(heightMap.begin(), heightMap.end());
+			maxDifference = std::max({ maxDifference, std::abs(chunk.GetMinHeight() - *minHeight), std::abs(chunk.GetMaxHeight() - *maxHeight) });
+			if (chunk.GetMinHeight() < minBound || chunk.GetMaxHeight() > maxBound)
+				return std::numeric_limits<float>::infinity();
+		}
+		return maxDifference;
+	}
+}
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		std::cerr << "No OpenGL 4.6 context, on Mesa set MESA_GL_VERSION_OVERRIDE=4.6 and MESA_GLSL_VERSION_OVERRIDE=460" << std::endl;
+		return 1;
+	}
+
+	// GLEW looks for a GLX display once the functions are loaded, there is none without a window
+	glewExperimental = GL_TRUE;
+	const GLenum status = glewInit();
+	if (status != GLEW_OK && status != GLEW_ERROR_NO_GLX_DISPLAY)
+	{
+		std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(status) << std::endl;
+		return 1;
+	}
+
+	std::cout << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+
+	const auto shader = Shader::CreateCompute("./assets/shaders/Generation/computeShader.glsl");
+	const auto generator = GpuChunkGenerator::Create(shader);
+
+	NoiseSettings ridged = continentalnessNoiseSettings;
+	ridged.ridgeNoise = true;
+	NoiseSettings terraced = continentalnessNoiseSettings;
+	terraced.terraces = true;
+
+	// Heights far from 0, the vertices store them relative to the range of the settings
+	NoiseSettings tall = continentalnessNoiseSettings;
+	for (SplinePoint& point : tall.splinePoints)
+		point.height = point.height * 4.f + 300.f;
+
+	std::vector<TestCase> tests = {
+		{ "continentalness", continentalnessNoiseSettings, erosionNoiseSettings, false },
+		{ "blend", continentalnessNoiseSettings, erosionNoiseSettings, true },
+		{ "ridges", ridged, erosionNoiseSettings, true },
+		{ "terraces", terraced, erosionNoiseSettings, true },
+		{ "tall", tall, erosionNoiseSettings, false },
+	};
+
+	int failures = 0;
+	for (TestCase& test : tests)
+	{
+		const float difference = Run(*generator, test);
+		const bool passed = difference < kTolerance;
+		std::cout << (passed ? "PASS " : "FAIL ") << test.name << ": max difference " << difference << std::endl;
+		failures += passed ? 0 : 1;
+	}
+
+	return failures == 0 ? 0 : 1;
+}